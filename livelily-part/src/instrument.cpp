@@ -924,9 +924,15 @@ void Instrument::drawStaff(int bar, float xOffset, float yStartPnt, float yOffse
 }
 
 //--------------------------------------------------------------
-void Instrument::drawNotes(int bar, int loopNdx,  vector<int> *v, float xOffset, float yStartPnt, float yOffset, bool animate, float xCoef)
+void Instrument::drawNotes(int bar, int loop, int loopNdx,  vector<int> *v, float xOffset, float yStartPnt, float yOffset, bool animate, float xCoef)
 {
-	notesObj.drawNotes(bar, loopNdx, v, xOffset, yStartPnt, yOffset, animate, xCoef);
+	notesObj.drawNotes(bar, loop, loopNdx, v, xOffset, yStartPnt, yOffset, animate, xCoef);
+}
+
+//--------------------------------------------------------------
+void Instrument::invalidateLoopNaturalSigns(int loop)
+{
+	notesObj.invalidateLoopNaturalSigns(loop);
 }
 
 void Instrument::printVector(vector<int> v)
@@ -123,8 +123,9 @@ class Instrument
 		float getMeterXOffset();
 		void drawStaff(int bar, float xOffset, float yStartPnt, float yOffset, bool drawClef,
 				bool drawMeter, bool drawLoopStartEnd, bool drawTempo);
-		void drawNotes(int bar, int loopNdx, vector<int> *v, float xOffset, float yStartPnt,
+		void drawNotes(int bar, int loop, int loopNdx, vector<int> *v, float xOffset, float yStartPnt,
 				float yOffset, bool animate, float xCoef);
+		void invalidateLoopNaturalSigns(int loop);
 		void printVector(vector<int> v);
 		void printVector(vector<string> v);
 		void printVector(vector<float> v);
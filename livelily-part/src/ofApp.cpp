@@ -1,6 +1,7 @@
 #include "ofApp.h"
 #include <string.h>
 #include <sstream>
+#include <thread>
 
 //--------------------------------------------------------------
 void ofApp::setup()
@@ -16,6 +17,8 @@ void ofApp::setup()
 	fullscreen = false;
 	finishState = false;
 	changeBeatColorOnUpdate = false;
+	syncing = false;
+	numSyncMessages = 0;
 	
 	parsingBar = false;
 	parsingLoop = false;
@@ -31,11 +34,14 @@ void ofApp::setup()
 	ofSetWindowTitle("LiveLily Part");
 	
 	oscReceiver.setup(OSCPORT);
+	setOscRoutes();
+	barParser.setup();
 	
 	screenWidth = ofGetWindowWidth();
 	screenHeight = ofGetWindowHeight();
 	middleOfScreenX = screenWidth / 2;
 	middleOfScreenY = screenHeight / 2;
+	scoreFbo.allocate(screenWidth, screenHeight, GL_RGBA);
 
 	numInstruments = 0;
 	numBarsToDisplay = 4;
@@ -112,6 +118,120 @@ void ofApp::setup()
 	}
 }
 
+//--------------------------------------------------------------
+void ofApp::setOscRoutes()
+{
+	// all the addresses the main program sends to a part are known in advance
+	// so we map them to a route index once, and update() dispatches with a single lookup
+	oscRoutes.clear();
+	oscRoutes["/beatinfo"] = beatInfoRoute;
+	oscRoutes["/beat"] = beatRoute;
+	oscRoutes["/line"] = lineRoute;
+	oscRoutes["/copyline"] = copyLineRoute;
+	oscRoutes["/bar"] = barRoute;
+	oscRoutes["/loop"] = loopRoute;
+	oscRoutes["/clef"] = clefRoute;
+	oscRoutes["/update"] = updateRoute;
+	oscRoutes["/loopndx"] = loopNdxRoute;
+	oscRoutes["/thisloopndx"] = thisLoopNdxRoute;
+	oscRoutes["/seq"] = seqRoute;
+	oscRoutes["/initinst"] = initInstRoute;
+	oscRoutes["/group"] = groupRoute;
+	oscRoutes["/numbars"] = numBarsRoute;
+	oscRoutes["/scorechange"] = scoreChangeRoute;
+	oscRoutes["/countdown"] = countdownRoute;
+	oscRoutes["/nocountdown"] = noCountdownRoute;
+	oscRoutes["/fullscreen"] = fullscreenRoute;
+	oscRoutes["/beatviztype"] = beatVizTypeRoute;
+	oscRoutes["/beatbright"] = beatBrightRoute;
+	oscRoutes["/cursor"] = cursorRoute;
+	oscRoutes["/beatcolor"] = beatColorRoute;
+	oscRoutes["/size"] = sizeRoute;
+	oscRoutes["/accoffset"] = accOffsetRoute;
+	oscRoutes["/exit"] = exitRoute;
+	oscRoutes["/synced"] = syncedRoute;
+}
+
+//--------------------------------------------------------------
+void ofApp::requestSync(string host)
+{
+	// a sync that is requested again starts from scratch
+	if (numInstruments > 0) clearScore();
+	syncHost = host;
+	syncing = true;
+	numSyncMessages = 0;
+	syncTimeStamps[host] = ofGetElapsedTimeMillis();
+	mainSender.setup(host, MAINPORT);
+	ofxOscMessage m;
+	m.setAddress("/sync");
+	m.addIntArg(OSCPORT);
+	mainSender.sendMessage(m, false);
+}
+
+//--------------------------------------------------------------
+void ofApp::countSyncMessage(int route)
+{
+	switch (route) {
+		// the sequencer of the main program sends these while it runs, so they are not counted in the sync
+		case beatInfoRoute:
+		case beatRoute:
+		case thisLoopNdxRoute:
+		case loopNdxRoute:
+		case seqRoute:
+		case countdownRoute:
+		case noCountdownRoute:
+			break;
+		default:
+			numSyncMessages++;
+			syncTimeStamps[syncHost] = ofGetElapsedTimeMillis();
+			break;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::clearScore()
+{
+	// the bars, loops and instruments of a sync that lost messages are removed before it is requested again
+	// so that the indexes of the new sync match the ones of the main program
+	barParser.waitUntilIdle();
+	std::lock_guard<std::mutex> lock(scoreMutex);
+	instruments.clear();
+	instrumentIndexes.clear();
+	instrumentIndexesOrdered.clear();
+	instrumentIndexMap.clear();
+	instNameWidths.clear();
+	barsIndexes.clear();
+	loopsIndexes.clear();
+	mainBarIndexes.clear();
+	loopsOrdered.clear();
+	loopsVariants.clear();
+	loopData.clear();
+	tempo.clear();
+	tempoMs.clear();
+	BPMTempi.clear();
+	BPMMultiplier.clear();
+	beatAtDifferentThanDivisor.clear();
+	beatAtValues.clear();
+	tempoBaseForScore.clear();
+	BPMDisplayHasDot.clear();
+	barFirstStaffAnchor.clear();
+	numBeats.clear();
+	numerator.clear();
+	denominator.clear();
+	numerator[0] = 4;
+	denominator[0] = 4;
+	numBeats[0] = 4;
+	numInstruments = 0;
+	longestInstNameWidth = 0;
+	maxBarFirstStaffAnchor = 0;
+	allStaffDiffs = 0;
+	loopIndex = 0;
+	tempBarLoopIndex = 0;
+	thisLoopIndex = 0;
+	thisBarIndex = 0;
+	lastBarIndex = 0;
+}
+
 //--------------------------------------------------------------
 void ofApp::update()
 {
@@ -119,88 +239,186 @@ void ofApp::update()
 	while (oscReceiver.hasWaitingMessages()) {
 		ofxOscMessage m;
 		oscReceiver.getNextMessage(m);
-		if (m.getAddress() == "/beatinfo") {
+		auto route = oscRoutes.find(m.getAddress());
+		if (route == oscRoutes.end()) continue;
+		// if we receive anything but an instrument initialization before we have any instruments
+		// the main program is already running, so we ask it for its current state
+		if (numInstruments == 0 && route->second != initInstRoute && m.getRemoteHost().compare(syncHost) != 0) {
+			requestSync(m.getRemoteHost());
+		}
+		if (route->second == syncedRoute) {
+			// the main program tells how many messages it sent for the sync, those we didn't count were lost on the way
+			int numLost = m.getArgAsInt32(0) - numSyncMessages;
+			if (syncing && numLost > 0) {
+				cout << numLost << " messages of the sync from the main program were lost, requesting it again" << endl;
+				requestSync(syncHost);
+			}
+			else {
+				syncing = false;
+			}
+			continue;
+		}
+		if (syncing) countSyncMessage(route->second);
+		switch (route->second) {
+			// the beat visualization is handled right away, so it stays in time while bars are being parsed
+			// these only set values that are read in this thread, so they don't wait for the score to be unlocked
+			case beatInfoRoute:
+			case beatRoute:
+			case scoreChangeRoute:
+			case countdownRoute:
+			case noCountdownRoute:
+			case beatVizTypeRoute:
+			case beatBrightRoute:
+			case cursorRoute:
+			case beatColorRoute:
+			case exitRoute:
+				handleOscMessage(m, route->second);
+				break;
+			// these load fonts or change the window, which can only be done in this thread
+			// they are rare, so we wait for the bars that arrived before them to be parsed
+			// the parser thread is then idle until we push something to it, so the score doesn't need to be locked
+			case initInstRoute:
+			case sizeRoute:
+			case fullscreenRoute:
+				barParser.waitUntilIdle();
+				handleOscMessage(m, route->second);
+				break;
+			default:
+				barParser.push(m, route->second);
+				break;
+		}
+	}
+	// neither the snapshot nor its end arrived, so the request or the rest of the snapshot got lost
+	if (syncing && ofGetElapsedTimeMillis() - syncTimeStamps[syncHost] > SYNCTIMEOUT) {
+		cout << "the sync from the main program timed out, requesting it again" << endl;
+		requestSync(syncHost);
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::handleOscMessage(ofxOscMessage& m, int route)
+{
+	switch (route) {
+		case beatInfoRoute: {
 			beatVizStepsPerMs = m.getArgAsFloat(0);
 			beatVizRampStart = m.getArgAsInt32(1);
 			beatVizTimeStamp = ofGetElapsedTimeMillis();
 			beatViz = true;
+			break;
 		}
-		else if (m.getAddress() == "/beat") {
+		case beatRoute: {
 			beatCounter = m.getArgAsInt32(0);
+			break;
 		}
-		else if (m.getAddress() == "/line") {
+		case lineRoute: {
 			linesToParse = {m.getArgAsString(0)};
 			parseStrings();
+			break;
+		}
+		case copyLineRoute: {
+			// the line of this instrument hasn't changed since the previous definition of this bar
+			// so we copy it instead of parsing it and calculating the note positions again
+			// the bar is given by its index in the main program, if we never received it, we parse the line that comes with it
+			auto instNdx = instrumentIndexes.find(m.getArgAsString(0));
+			if (instNdx == instrumentIndexes.end()) break;
+			lastInstrumentIndex = instNdx->second;
+			auto barNdx = mainBarIndexes.find(m.getArgAsInt32(1));
+			if (barNdx != mainBarIndexes.end()) {
+				copyLineFromBar(barNdx->second);
+			}
+			else {
+				linesToParse = {m.getArgAsString(2)};
+				parseStrings();
+			}
+			break;
 		}
-		else if (m.getAddress() == "/bar") {
+		case barRoute: {
 			if (m.getArgType(0) == OFXOSC_TYPE_STRING) {
 				parseCommand("\\bar " + m.getArgAsString(0));
+				if (m.getNumArgs() > 1) mainBarIndexes[m.getArgAsInt32(1)] = lastBarIndex;
 			}
 			else if (m.getArgType(0) == OFXOSC_TYPE_INT32) {
 				parseBar();
 			}
+			break;
 		}
-		else if (m.getAddress() == "/loop") {
+		case loopRoute: {
 			string loopName = m.getArgAsString(0);
 			storeNewLoop(loopName);
 			int loopNdx = m.getArgAsInt32(1);
-			loopData[loopNdx] = vector<int>();
+			vector<int> bars;
 			for (size_t i = 2; i < m.getNumArgs(); i++) {
-				loopData[loopNdx].push_back(m.getArgAsInt32(i));
+				bars.push_back(m.getArgAsInt32(i));
 			}
+			setLoopData(loopNdx, bars);
 			if (!seqState) {
 				loopIndex = tempBarLoopIndex;
 			}
+			break;
 		}
-		else if (m.getAddress() == "/clef") {
-			int instNdx = instrumentIndexes[m.getArgAsString(0)];
-			instruments[instNdx].setClef(getLastBarIndex(), m.getArgAsInt32(1));
+		case clefRoute: {
+			// instruments are looked up without operator[], so that a message for an unknown one doesn't insert it
+			auto instNdx = instrumentIndexes.find(m.getArgAsString(0));
+			if (instNdx == instrumentIndexes.end()) break;
+			instruments.at(instNdx->second).setClef(getLastBarIndex(), m.getArgAsInt32(1));
+			break;
 		}
-		else if (m.getAddress() == "/update") {
+		case updateRoute: {
 			tempBarLoopIndex = m.getArgAsInt32(0);
 			mustUpdateScore = true;
 			showUpdatePulseColor = true;
+			break;
 		}
-		else if (m.getAddress() == "/loopndx") {
+		case loopNdxRoute: {
 			loopIndex = m.getArgAsInt32(0);
+			break;
 		}
-		else if (m.getAddress() == "/thisloopndx") {
+		case thisLoopNdxRoute: {
 			thisLoopIndex = m.getArgAsInt32(0);
+			break;
 		}
-		else if (m.getAddress() == "/seq") {
+		case seqRoute: {
 			seqState = m.getArgAsBool(0);
+			break;
 		}
-		else if (m.getAddress() == "/initinst") {
+		case initInstRoute: {
 			int ndx = m.getArgAsInt32(0);
 			string name = m.getArgAsString(1);
 			initializeInstrument(ndx, "\\" + name);
+			break;
 		}
-		else if (m.getAddress() == "/group") {
-			for (size_t i = 0; i < m.getNumArgs(); i++) {
-				if (i > 0) {
-					instruments[instrumentIndexes[m.getArgAsString(i)]].setGroup(instruments[instrumentIndexes[m.getArgAsString(i-1)]].getID());
-				}
+		case groupRoute: {
+			for (size_t i = 1; i < m.getNumArgs(); i++) {
+				auto instNdx = instrumentIndexes.find(m.getArgAsString(i));
+				auto prevInstNdx = instrumentIndexes.find(m.getArgAsString(i-1));
+				if (instNdx == instrumentIndexes.end() || prevInstNdx == instrumentIndexes.end()) continue;
+				instruments.at(instNdx->second).setGroup(instruments.at(prevInstNdx->second).getID());
 			}
+			break;
 		}
-		else if (m.getAddress() == "/numbars") {
+		case numBarsRoute: {
 			numBarsToDisplay = m.getArgAsInt32(0);
 			for (auto it = instruments.begin(); it != instruments.end(); ++it) {
 				it->second.setNumBarsToDisplay(numBarsToDisplay);
 			}
 			setScoreCoords();
+			break;
 		}
-		else if (m.getAddress() == "/scorechange") {
+		case scoreChangeRoute: {
 			scoreChangeOnLastBar = m.getArgAsBool(0);
+			break;
 		}
-		else if (m.getAddress() == "/countdown") {
+		case countdownRoute: {
 			countdown = m.getArgAsInt32(0);
 			if (countdown > 0) showCountdown = true;
 			else showCountdown = false;
+			break;
 		}
-		else if (m.getAddress() == "/nocountdown") {
+		case noCountdownRoute: {
 			showCountdown = false;
+			break;
 		}
-		else if (m.getAddress() == "/fullscreen") {
+		case fullscreenRoute: {
 			bool fullscreenBool = m.getArgAsBool(0);
 			if (fullscreenBool != fullscreen) {
 				ofToggleFullscreen();
@@ -209,45 +427,68 @@ void ofApp::update()
 				screenHeight = ofGetWindowHeight();
 				setScoreSizes();
 			}
+			break;
 		}
-		else if (m.getAddress() == "/beatviztype") {
+		case beatVizTypeRoute: {
 			beatVizType = m.getArgAsInt32(0);
+			break;
 		}
-		else if (m.getAddress() == "/beatbright") {
+		case beatBrightRoute: {
 			beatBrightnessCoeff = m.getArgAsFloat(0);
+			break;
 		}
-		else if (m.getAddress() == "/cursor") {
+		case cursorRoute: {
 			if (m.getArgAsBool(0)) {
 				ofShowCursor();
 			}
 			else {
 				ofHideCursor();
 			}
+			break;
 		}
-		else if (m.getAddress() == "/beatcolor") {
+		case beatColorRoute: {
 			changeBeatColorOnUpdate = m.getArgAsBool(0);
+			break;
 		}
-		else if (m.getAddress() == "/size") {
+		case sizeRoute: {
 			staffLinesDist = m.getArgAsFloat(0);
 			scoreFontSize = (int)(35.0 * staffLinesDist / 10.0);
-	    	instFontSize = scoreFontSize / 3.5;
-	    	instFont.load("Monaco.ttf", instFontSize);
-	    	setScoreSizes();
+			instFontSize = scoreFontSize / 3.5;
+			instFont.load("Monaco.ttf", instFontSize);
+			setScoreSizes();
+			break;
 		}
-		else if (m.getAddress() == "/accoffset") {
+		case accOffsetRoute: {
 			for (auto it = instruments.begin(); it != instruments.end(); ++it) {
 				it->second.setAccidentalsOffsetCoef(m.getArgAsFloat(0));
 			}
+			break;
 		}
-		else if (m.getAddress() == "/exit") {
+		case exitRoute: {
 			ofShowCursor();
 			ofExit();
+			break;
 		}
 	}
 }
 
 //--------------------------------------------------------------
 void ofApp::draw()
+{
+	// if the parser thread holds the score, we show the score of the previous frame instead of waiting for it
+	std::unique_lock<std::mutex> lock(scoreMutex, std::try_to_lock);
+	if (lock.owns_lock()) {
+		scoreFbo.begin();
+		ofClear(backgroundColor);
+		drawScore();
+		scoreFbo.end();
+	}
+	ofSetColor(255);
+	scoreFbo.draw(0, 0);
+}
+
+//--------------------------------------------------------------
+void ofApp::drawScore()
 {
 	ofSetColor(brightness);
 	ofDrawRectangle(scoreXOffset, scoreYOffset, screenWidth, screenHeight);
@@ -554,7 +795,7 @@ void ofApp::draw()
 				bool drawTempoLocal = (showTempo && drawTempo ? true : false);
 				if (showBar) {
 					it->second.drawStaff(bar, staffOffsetX, yStartPntLocal, scoreYOffset, drawClef, drawMeter, drawLoopStartEnd, drawTempoLocal);
-					it->second.drawNotes(bar, i, &loopData[insertNaturalsNdx], notesOffsetX, yStartPntLocal, scoreYOffset, animate, notesXCoef);
+					it->second.drawNotes(bar, insertNaturalsNdx, i, &loopData[insertNaturalsNdx], notesOffsetX, yStartPntLocal, scoreYOffset, animate, notesXCoef);
 				}
 				yStartPntLocal += (allStaffDiffs + (staffLinesDist * 2));
 				instCounter++;
@@ -571,6 +812,12 @@ void ofApp::draw()
 	}
 }
 
+//--------------------------------------------------------------
+void ofApp::exit()
+{
+	barParser.stop();
+}
+
 //--------------------------------------------------------------
 int ofApp::getMappedIndex(int index)
 {
@@ -1053,7 +1300,7 @@ void ofApp::parseBar()
 	fillInMissingInsts(barIndex);
 	// then store the number of beats for this bar
 	// if we create a bar, create a loop with this bar only
-	loopData[barIndex] = {barIndex};
+	setLoopData(barIndex, {barIndex});
 	// check if no time has been specified and set the default 4/4
 	if (numerator.find(barIndex) == numerator.end()) {
 		numerator[barIndex] = 4;
@@ -1432,6 +1679,16 @@ bool ofApp::isBarLoop(vector<string>& commands)
 	return barLoopExists;
 }
 
+//--------------------------------------------------------------
+void ofApp::setLoopData(int loopNdx, const vector<int>& bars)
+{
+	loopData[loopNdx] = bars;
+	// the natural signs stored for the positions of this loop were searched in the bars it had before
+	for (auto it = instruments.begin(); it != instruments.end(); ++it) {
+		it->second.invalidateLoopNaturalSigns(loopNdx);
+	}
+}
+
 //--------------------------------------------------------------
 int ofApp::getLastLoopIndex()
 {
@@ -1491,8 +1748,14 @@ int ofApp::getPlayingBarIndex()
 void ofApp::stripLineFromBar(string str)
 {
 	auto barToCopyIt = loopsIndexes.find(str);
+	copyLineFromBar(barToCopyIt->second);
+}
+
+//--------------------------------------------------------------
+void ofApp::copyLineFromBar(int copyNdx)
+{
 	int barIndex = getLastLoopIndex();
-	barToCopy = barToCopyIt->second;
+	barToCopy = copyNdx;
 	instruments[lastInstrumentIndex].setPassed(true);
 	instruments[lastInstrumentIndex].setCopied(barIndex, true);
 	instruments[lastInstrumentIndex].setCopyNdx(barIndex, barToCopy);
@@ -1608,7 +1871,7 @@ void ofApp::parseBarLoop(string str)
 	}
 	// find the last index of the stored loops and store the vector we just created to the value of loopData
 	int loopNdx = getLastLoopIndex();
-	loopData[loopNdx] = thisLoopIndexes;
+	setLoopData(loopNdx, thisLoopIndexes);
 	if (restOfCommand.size() > 0) {
 		// falsify this so that the name of the loop is treated properly in parseString()
 		// otherwise, parseString() will again call this function
@@ -3032,7 +3295,7 @@ void ofApp::createFirstBar(int instNdx)
 	instruments[instNdx].setScoreNotes(barIndex, denominator[0], numerator[0], numBeats[0],
 			BPMTempi[0], tempoBaseForScore[0], BPMDisplayHasDot[0], BPMMultiplier[0]);
 	instruments[instNdx].setNotePositions(0);
-	loopData[0] = {0};
+	setLoopData(0, {0});
 	calculateStaffPositions(0, false);
 }
 
@@ -3074,17 +3337,29 @@ void ofApp::setScoreNotes(int barIndex)
 //--------------------------------------------------------------
 void ofApp::setNotePositions(int barIndex)
 {
-	for (auto it = instruments.begin(); it != instruments.end(); ++it) {
-		if (!it->second.getCopied(barIndex)) it->second.setNotePositions(barIndex);
-	}
+	layoutInstruments([barIndex](Instrument& inst) {
+		if (!inst.getCopied(barIndex)) inst.setNotePositions(barIndex);
+	});
 }
 
 //--------------------------------------------------------------
 void ofApp::setNotePositions(int barIndex, int numBars)
 {
+	layoutInstruments([barIndex, numBars](Instrument& inst) {
+		if (!inst.getCopied(barIndex)) inst.setNotePositions(barIndex, numBars);
+	});
+}
+
+//--------------------------------------------------------------
+void ofApp::layoutInstruments(std::function<void(Instrument&)> layout)
+{
+	// each instrument has its own Notes and fonts, so the instruments are laid out in parallel
+	// the layout of a bar reads its neighbouring bars, so all the bars of an instrument are laid out by one thread
+	std::vector<Instrument*> insts;
 	for (auto it = instruments.begin(); it != instruments.end(); ++it) {
-		if (!it->second.getCopied(barIndex)) it->second.setNotePositions(barIndex, numBars);
+		insts.push_back(&it->second);
 	}
+	barParser.layoutInstruments(insts, layout);
 }
 
 //--------------------------------------------------------------
@@ -3146,13 +3421,20 @@ void ofApp::setScoreSizes()
 	scoreXStartPnt = longestInstNameWidth + (blankSpace * 1.5);
 	setScoreCoords();
 	if (barsIndexes.size() > 0) {
+		// the meters are set here, so that the layout threads don't touch the maps of this class
+		vector<int> bars;
 		for (auto it = barsIndexes.begin(); it != barsIndexes.end(); ++it) {
 			//setScoreCoords();
 			for (auto it2 = instruments.begin(); it2 != instruments.end(); ++it2) {
 				it2->second.setMeter(it->second, numerator[it->second], denominator[it->second], numBeats[it->second]);
-				it2->second.setNotePositions(it->second);
 			}
+			bars.push_back(it->second);
 		}
+		layoutInstruments([&bars](Instrument& inst) {
+			for (auto it = bars.begin(); it != bars.end(); ++it) {
+				inst.setNotePositions(*it);
+			}
+		});
 	}
 	//else {
 	//	setScoreCoords();
@@ -3200,10 +3482,13 @@ void ofApp::windowResized(int w, int h)
 {
 	// hold the previous middle of screen value so the score is also properly updated
 	int prevMiddleOfScreenX = middleOfScreenX;
+	// like the OSC messages that change the size of the score, wait for the bars that are being parsed
+	barParser.waitUntilIdle();
 	screenWidth = w;
 	screenHeight = h;
 	middleOfScreenX = screenWidth / 2;
 	middleOfScreenY = screenHeight / 2;
+	scoreFbo.allocate(screenWidth, screenHeight, GL_RGBA);
 	if (staffXOffset == prevMiddleOfScreenX) {
 		staffXOffset = 0;
 		staffWidth = screenWidth / 2;
@@ -3228,3 +3513,122 @@ void ofApp::dragEvent(ofDragInfo dragInfo)
 {
 
 }
+
+/******************** bar parser thread class *****************/
+//--------------------------------------------------------------
+void BarParserThread::setup()
+{
+	numPending = 0;
+	layoutInsts = NULL;
+	nextLayoutInst = 0;
+	layoutGeneration = 0;
+	numLayoutWorking = 0;
+	stopLayoutWorkers = false;
+	// the thread that calls layoutInstruments() is one of the layout threads
+	unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned i = 1; i < numThreads; i++) {
+		layoutWorkers.push_back(std::thread(&BarParserThread::layoutWorker, this));
+	}
+	startThread();
+}
+
+//--------------------------------------------------------------
+void BarParserThread::push(const ofxOscMessage& m, int route)
+{
+	RoutedOscMessage msg;
+	msg.m = m;
+	msg.route = route;
+	{
+		std::lock_guard<std::mutex> lock(idleMutex);
+		numPending++;
+	}
+	channel.send(std::move(msg));
+}
+
+//--------------------------------------------------------------
+void BarParserThread::waitUntilIdle()
+{
+	std::unique_lock<std::mutex> lock(idleMutex);
+	idleCondition.wait(lock, [this]() { return numPending == 0; });
+}
+
+//--------------------------------------------------------------
+void BarParserThread::layoutInstruments(std::vector<Instrument*>& insts, std::function<void(Instrument&)> layout)
+{
+	// this is called by the parser thread, and by the main thread only when the parser is idle
+	// but we still make sure that one layout runs at a time
+	std::lock_guard<std::mutex> callLock(layoutCallMutex);
+	std::unique_lock<std::mutex> lock(layoutMutex);
+	layoutJob = layout;
+	layoutInsts = &insts;
+	nextLayoutInst = 0;
+	layoutGeneration++;
+	lock.unlock();
+	layoutCondition.notify_all();
+	runLayout();
+	lock.lock();
+	layoutDoneCondition.wait(lock, [this]() { return numLayoutWorking == 0; });
+	// a worker that wakes up after this point finds no job, so it won't touch the instruments of this call
+	layoutInsts = NULL;
+	layoutJob = nullptr;
+}
+
+//--------------------------------------------------------------
+void BarParserThread::runLayout()
+{
+	size_t i;
+	while ((i = nextLayoutInst.fetch_add(1)) < layoutInsts->size()) {
+		layoutJob(*(*layoutInsts)[i]);
+	}
+}
+
+//--------------------------------------------------------------
+void BarParserThread::layoutWorker()
+{
+	unsigned generation = 0;
+	std::unique_lock<std::mutex> lock(layoutMutex);
+	while (true) {
+		layoutCondition.wait(lock, [&]() {
+			return stopLayoutWorkers || (layoutInsts != NULL && layoutGeneration != generation);
+		});
+		if (stopLayoutWorkers) return;
+		generation = layoutGeneration;
+		numLayoutWorking++;
+		lock.unlock();
+		runLayout();
+		lock.lock();
+		if (--numLayoutWorking == 0) layoutDoneCondition.notify_one();
+	}
+}
+
+//--------------------------------------------------------------
+void BarParserThread::stop()
+{
+	channel.close();
+	waitForThread(true);
+	{
+		std::lock_guard<std::mutex> lock(layoutMutex);
+		stopLayoutWorkers = true;
+	}
+	layoutCondition.notify_all();
+	for (auto it = layoutWorkers.begin(); it != layoutWorkers.end(); ++it) {
+		it->join();
+	}
+	layoutWorkers.clear();
+}
+
+//--------------------------------------------------------------
+void BarParserThread::threadedFunction()
+{
+	ofApp *app = (ofApp*)ofGetAppPtr();
+	RoutedOscMessage msg;
+	// receive() blocks until a message arrives, and returns false once the channel is closed
+	while (channel.receive(msg)) {
+		{
+			std::lock_guard<std::mutex> lock(app->scoreMutex);
+			app->handleOscMessage(msg.m, msg.route);
+		}
+		std::lock_guard<std::mutex> lock(idleMutex);
+		if (--numPending == 0) idleCondition.notify_all();
+	}
+}
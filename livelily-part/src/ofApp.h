@@ -4,7 +4,13 @@
 #include "ofMain.h"
 #include "ofxOsc.h"
 #include <map>
+#include <unordered_map>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
 #include "instrument.h"
 
 #define OFRECVPORT 8001
@@ -20,17 +26,65 @@
 #define MINDB 60
 
 #define OSCPORT 9000 // for receiving OSC messages from main program 
+#define MAINPORT 9050 // for sending sync requests to the main program
+#define SYNCTIMEOUT 2000 // ms without a message of a sync before it is requested again
 
 #define WINDOW_RESIZE_GAP 50
 #define NOTESXOFFSETCOEF 3
 
+struct RoutedOscMessage
+{
+	ofxOscMessage m;
+	int route;
+};
+
+// bar data is parsed and laid out in its own thread, so that a transfer of many bars doesn't stall the frames
+// messages are handled in the order they arrive, each one with the score locked
+// draw() doesn't wait for the score, it shows the last frame it drew while a message is being handled
+// the instruments of a bar are laid out by a pool of threads that lives as long as this one
+class BarParserThread : public ofThread
+{
+	public:
+		void setup();
+		void push(const ofxOscMessage& m, int route);
+		void waitUntilIdle();
+		void layoutInstruments(std::vector<Instrument*>& insts, std::function<void(Instrument&)> layout);
+		void stop();
+
+	private:
+		void threadedFunction();
+		void layoutWorker();
+		void runLayout();
+
+		ofThreadChannel<RoutedOscMessage> channel;
+		int numPending;
+		std::mutex idleMutex;
+		std::condition_variable idleCondition;
+		// the layout pool, the thread that calls layoutInstruments() lays out instruments too
+		std::vector<std::thread> layoutWorkers;
+		std::mutex layoutCallMutex;
+		std::mutex layoutMutex;
+		std::condition_variable layoutCondition;
+		std::condition_variable layoutDoneCondition;
+		std::function<void(Instrument&)> layoutJob;
+		std::vector<Instrument*> *layoutInsts;
+		std::atomic<size_t> nextLayoutInst;
+		unsigned layoutGeneration;
+		int numLayoutWorking;
+		bool stopLayoutWorkers;
+};
+
 class ofApp : public ofBaseApp
 {
 	public:
 		// basic OF program structure
 		void setup();
+		void setOscRoutes();
 		void update();
+		void handleOscMessage(ofxOscMessage& m, int route);
 		void draw();
+		void drawScore();
+		void exit();
 		int getMappedIndex(int index);
 		void keyPressed(int key);
 		void keyReleased(int key);
@@ -66,11 +120,13 @@ class ofApp : public ofBaseApp
 		void parseCommand(string str);
 		bool isInstrument(vector<string>& commands);
 		bool isBarLoop(vector<string>& commands);
+		void setLoopData(int loopNdx, const vector<int>& bars);
 		int getLastLoopIndex();
 		int getLastBarIndex();
 		int getPrevBarIndex();
 		int getPlayingBarIndex();
 		void stripLineFromBar(string str);
+		void copyLineFromBar(int copyNdx);
 		void parseBarLoop(string str);
 		vector<string> tokenizeChord(string input, bool includeAngleBrackets = false);
 		vector<string> tokenizeMelodicLine(const string& input);
@@ -85,6 +141,7 @@ class ofApp : public ofBaseApp
 		void setScoreNotes(int barIndex);
 		void setNotePositions(int barIndex);
 		void setNotePositions(int barIndex, int numBars);
+		void layoutInstruments(std::function<void(Instrument&)> layout);
 		void calculateStaffPositions(int bar, bool windowChanged);
 		void setScoreSizes();
 		// rest of OF functions
@@ -108,6 +165,8 @@ class ofApp : public ofBaseApp
 		map<int, int> instrumentIndexesOrdered; // for sending to parts in specific order
 		map<string, int> barsIndexes;
 		map<string, int> loopsIndexes;
+		// the indexes of the bars in the main program, mapped to the indexes of the same bars here
+		map<int, int> mainBarIndexes;
 		// since string keys are sorted, we need a way to retrieve them in arbirtary order
 		// e.g. a bar named "5" stored first, will be moved after a bar named "4" that is stored later on
 		// the map below is ordered, but we store the index as a key, which is stored with an incrementing value anyway
@@ -133,6 +192,29 @@ class ofApp : public ofBaseApp
 		bool firstInstForBarsSet;
 
 		ofxOscReceiver oscReceiver;
+		// a part that starts after the main program has sent its data requests a snapshot of it
+		ofxOscSender mainSender;
+		string syncHost;
+		// the messages of the sync received so far, checked against the number the main program says it sent
+		bool syncing;
+		int numSyncMessages;
+		// per host of a main program, the time of the last sync request or message of the sync
+		// so that a request or a snapshot that got lost is requested again
+		map<string, uint64_t> syncTimeStamps;
+		void requestSync(string host);
+		void countSyncMessage(int route);
+		void clearScore();
+		// OSC addresses are mapped to route indexes in setOscRoutes()
+		// so that each incoming message is dispatched with one hash lookup
+		enum oscRouteTypes {beatInfoRoute, beatRoute, lineRoute, copyLineRoute, barRoute, loopRoute, clefRoute, updateRoute,
+			loopNdxRoute, thisLoopNdxRoute, seqRoute, initInstRoute, groupRoute, numBarsRoute, scoreChangeRoute,
+			countdownRoute, noCountdownRoute, fullscreenRoute, beatVizTypeRoute, beatBrightRoute, cursorRoute,
+			beatColorRoute, sizeRoute, accOffsetRoute, exitRoute, syncedRoute};
+		unordered_map<string, int> oscRoutes;
+		// the score is changed by the bar parser thread and drawn here, so both lock it
+		BarParserThread barParser;
+		std::mutex scoreMutex;
+		ofFbo scoreFbo; // the last drawn score, shown while the parser holds the score
 
 		int notesID; // used mainly for debugging note and staff objects
 
@@ -181,7 +263,8 @@ class ofApp : public ofBaseApp
 
 		map<int, int> instrumentIndexMap;
 
-		int numInstruments;
+		// instruments are only added in this thread, but update() reads the count without locking the score
+		std::atomic<int> numInstruments;
 		int numBarsToDisplay;
 
 		bool displayConnectionError;
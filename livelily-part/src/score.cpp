@@ -513,6 +513,7 @@ void Notes::setNotes(int bar,
 	isLinked[bar] = std::make_pair(0, 0);
 	BPMMultiplier[bar] = BPMMult;
 	if (clefIndex[bar] != 0) changeNotesBasedOnClef(bar);
+	invalidateNaturalSigns(bar);
 }
 
 //--------------------------------------------------------------
@@ -2322,33 +2323,57 @@ void Notes::copyMelodicLine(int barIndex, int barToCopy)
 		tupDirs[barIndex] = tupDirs.at(barToCopy);
 	}
 	tupRatios[barIndex] = tupRatios.at(barToCopy);
+	invalidateNaturalSigns(barIndex);
 }
 
 //--------------------------------------------------------------
 void Notes::deleteBar(int bar)
 {
 	allNotes.erase(bar);
+	invalidateNaturalSigns(bar);
 }
 
 //--------------------------------------------------------------
-void Notes::insertNaturalSigns(int bar, int loopNdx, vector<int> *v)
+const vector<vector<int>>& Notes::getNaturalSigns(int bar, int loop, int loopNdx, vector<int> *v)
 {
+	// the natural signs of a bar at a position of a loop are searched the first time the bar is drawn there
+	// and stay stored until the loop is stored again or the notes of a bar displayed before it change
+	map<std::pair<int, int>, NaturalSigns>& barNaturals = naturalSigns[bar];
+	auto it = barNaturals.find(std::make_pair(loop, loopNdx));
+	if (it == barNaturals.end()) {
+		NaturalSigns signs;
+		signs.prevBars.assign(v->begin(), v->begin() + std::min(loopNdx, (int)v->size()));
+		signs.naturals = findNaturalSigns(bar, signs.prevBars);
+		it = barNaturals.insert(std::make_pair(std::make_pair(loop, loopNdx), std::move(signs))).first;
+	}
+	return it->second.naturals;
+}
+
+//--------------------------------------------------------------
+vector<vector<int>> Notes::findNaturalSigns(int bar, const vector<int>& prevBars)
+{
+	vector<vector<int>> naturals;
+	for (unsigned i = 0; i < allNotes[bar].size(); i++) {
+		naturals.push_back(vector<int>(allNotes[bar][i].size(), 0));
+	}
 	// create an array of booleans where the index is the note and the value
 	// determines whether this note has already been corrected
 	int notesAlreadyCorrected[7] = {0};
 	// iterate backwards through the bars already displayed to see if we need to add a natural sign
-	for (int i = loopNdx-1; i >= 0; i--) {
-		for (int j = (int)allNotes[v->at(i)].size()-1; j >= 0; j--) {
-			for (int k = (int)allNotes[v->at(i)][j].size()-1; k >= 0; k--) {
+	for (int i = (int)prevBars.size()-1; i >= 0; i--) {
+		if (allNotes.find(prevBars[i]) == allNotes.end()) continue;
+		vector<vector<int>>& prevNotes = allNotes[prevBars[i]];
+		vector<vector<int>>& prevAccidentals = allAccidentals[prevBars[i]];
+		for (int j = (int)prevNotes.size()-1; j >= 0; j--) {
+			for (int k = (int)prevNotes[j].size()-1; k >= 0; k--) {
 				// once we access a note from a previous bar, we iterate over this bar to see if we have the same note
 				for (unsigned l = 0; l < allNotes[bar].size(); l++) {
 					for (unsigned m = 0; m < allNotes[bar][l].size(); m++) {
-						if (allNotes[v->at(i)][j][k] == allNotes[bar][l][m] && \
-								allAccidentals[v->at(i)][j][k] != allAccidentals[bar][l][m] &&
+						if (prevNotes[j][k] == allNotes[bar][l][m] && \
+								prevAccidentals[j][k] != allAccidentals[bar][l][m] &&
 								(allAccidentals[bar][l][m] == -1 || allAccidentals[bar][l][m] != 4)) {
 							if (!notesAlreadyCorrected[allNotes[bar][l][m]]) {
-								// the boolean below will be set to false once this additional natural sign is drawn
-								naturalSignsNotWritten[bar][l][m] = 1;
+								naturals[l][m] = 1;
 								notesAlreadyCorrected[allNotes[bar][l][m]] = 1;
 							}
 						}
@@ -2357,6 +2382,32 @@ void Notes::insertNaturalSigns(int bar, int loopNdx, vector<int> *v)
 			}
 		}
 	}
+	return naturals;
+}
+
+//--------------------------------------------------------------
+void Notes::invalidateNaturalSigns(int bar)
+{
+	// the signs of this bar, and of any bar that was displayed after it, must be searched again
+	naturalSigns.erase(bar);
+	for (auto it = naturalSigns.begin(); it != naturalSigns.end(); ++it) {
+		for (auto it2 = it->second.begin(); it2 != it->second.end();) {
+			const vector<int>& prevBars = it2->second.prevBars;
+			if (std::find(prevBars.begin(), prevBars.end(), bar) != prevBars.end()) it2 = it->second.erase(it2);
+			else ++it2;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void Notes::invalidateLoopNaturalSigns(int loop)
+{
+	for (auto it = naturalSigns.begin(); it != naturalSigns.end(); ++it) {
+		for (auto it2 = it->second.begin(); it2 != it->second.end();) {
+			if (it2->first.first == loop) it2 = it->second.erase(it2);
+			else ++it2;
+		}
+	}
 }
 
 //--------------------------------------------------------------
@@ -2366,7 +2417,7 @@ std::pair<int, int> Notes::isBarLinked(int bar)
 }
 
 //--------------------------------------------------------------
-void Notes::drawNotes(int bar, int loopNdx, vector<int> *v, float xStartPnt, float yStartPnt, float yOffset, bool animation, float xCoef)
+void Notes::drawNotes(int bar, int loop, int loopNdx, vector<int> *v, float xStartPnt, float yStartPnt, float yOffset, bool animation, float xCoef)
 {
 	if (allNotes.find(bar) == allNotes.end()) return;
 	float xCoefLocal = xCoef;
@@ -2376,9 +2427,9 @@ void Notes::drawNotes(int bar, int loopNdx, vector<int> *v, float xStartPnt, flo
 	xOffsets[bar] = xStartPnt;
 	if (!mute) {
 		// first determine if there is any natural sign that needs to be inserted
-		// the second argument is the index within the loop that displays the bars horizontally
-		// the third is a pointer to the vector that holds the bar indexes (map keys) of the currently playing loop
-		if (loopNdx > 0) insertNaturalSigns(bar, loopNdx, v);
+		// the second argument is the loop the bars are taken from, and the third the index within the loop that displays the bars horizontally
+		// the fourth is a pointer to the vector that holds the bar indexes (map keys) of the currently playing loop
+		const vector<vector<int>> *naturals = (loopNdx > 0 ? &getNaturalSigns(bar, loop, loopNdx, v) : nullptr);
 		for (unsigned i = 0; i < allNotes.at(bar).size(); i++) {
 			int restsColor = 0;
 			for (unsigned j = 0; j < allNotes.at(bar).at(i).size(); j++) {
@@ -2541,7 +2592,7 @@ void Notes::drawNotes(int bar, int loopNdx, vector<int> *v, float xStartPnt, flo
 				}
 			}
 		}
-		drawAccidentals(bar, xStartPnt, yStartPnt, yOffset, xCoef);
+		drawAccidentals(bar, naturals, xStartPnt, yStartPnt, yOffset, xCoef);
 		drawGlissandi(bar, xStartPnt, yStartPnt, yOffset, xCoef);
 		drawTuplets(bar, xStartPnt, yStartPnt, yOffset, xCoef);
 		drawArticulations(bar, xStartPnt, yStartPnt, yOffset, xCoef);
@@ -2626,7 +2677,7 @@ void Notes::drawBeams(float x1, float y1, float x2, float y2)
 }
 
 //--------------------------------------------------------------
-void Notes::drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef)
+void Notes::drawAccidentals(int bar, const vector<vector<int>> *naturals, float xStartPnt, float yStartPnt, float yOffset, float xCoef)
 {
 	if (tacet[bar]) return;
 	float xCoefLocal = xCoef;
@@ -2655,7 +2706,7 @@ void Notes::drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOf
 					prevX = x;
 				}
 			}
-			if (naturalSignsNotWritten[bar][i][j]) {
+			if (naturalSignsNotWritten[bar][i][j] || (naturals != nullptr && (*naturals)[i][j])) {
 				if (abs(y-prevY) < staffDist * 3 && j > 0) {
 					if (prevX == (allNoteCoordsX[bar][i][allChordsBaseIndexes[bar][i]] - allNoteCoordsXOffset[bar][i])) {
 						x -= (staffDist * accidentalsOffsetCoef);
@@ -2664,7 +2715,6 @@ void Notes::drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOf
 				notationFont.drawString(accSyms[4],
 						(x*xCoefLocal)+xStartPnt-(noteWidth*1.2),
 						y+yStartPnt+yOffset);
-				naturalSignsNotWritten[bar][i][j] = 0;
 				prevY = y;
 				prevX = x;
 			}
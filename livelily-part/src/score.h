@@ -72,6 +72,12 @@ class Staff
 		ofTrueTypeFont BPMDisplayFont;
 };
 
+// the natural signs a bar needs at a position of a loop, with the bars displayed before it that they were searched in
+struct NaturalSigns
+{
+	vector<int> prevBars;
+	vector<vector<int>> naturals;
+};
 
 class Notes
 {
@@ -136,13 +142,16 @@ class Notes
 		void storeMinMaxY(int bar);
 		void copyMelodicLine(int barIndex, int barToCopy);
 		void deleteBar(int bar);
-		void insertNaturalSigns(int bar, int loopNdx, vector<int> *v);
+		const vector<vector<int>>& getNaturalSigns(int bar, int loop, int loopNdx, vector<int> *v);
+		vector<vector<int>> findNaturalSigns(int bar, const vector<int>& prevBars);
+		void invalidateNaturalSigns(int bar);
+		void invalidateLoopNaturalSigns(int loop);
 		std::pair<int, int> isBarLinked(int bar);
-		void drawNotes(int bar, int loopNdx, vector<int> *v, float xStartPnt, float yStartPnt,
+		void drawNotes(int bar, int loop, int loopNdx, vector<int> *v, float xStartPnt, float yStartPnt,
 				float yOffset, bool animation, float xCoef);
 		void drawBeams(float x1, float y1, float x2, float y2);
 		int drawRest(int bar, int restDur, float x, float yStartPnt, int color, float yOffset);
-		void drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
+		void drawAccidentals(int bar, const vector<vector<int>> *naturals, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawGlissandi(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawTuplets(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawArticulations(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
@@ -171,6 +180,9 @@ class Notes
 		map<int, vector<int>> allChordsEdgeIndexes;
 		map<int, vector<vector<int>>> allAccidentals;
 		map<int, vector<vector<int>>> naturalSignsNotWritten;
+		// the natural signs each bar needs because of the accidentals of the bars displayed before it in a line of the score
+		// stored per loop and position in the loop, and searched again when the loop is stored or the notes of a bar change
+		map<int, map<std::pair<int, int>, NaturalSigns>> naturalSigns;
 		map<int, vector<vector<int>>> allOctaves;
 		map<int, vector<int>> allOttavas;
 		map<int, vector<int>> allGlissandi;
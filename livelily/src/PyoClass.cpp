@@ -17,22 +17,35 @@ void Pyo::setup(int _nChannels, int _bufferSize, int _sampleRate) {
     nChannels = _nChannels;
     bufferSize = _bufferSize;
     sampleRate = _sampleRate;
-    interpreter = pyo_new_interpreter(sampleRate, bufferSize, nChannels);
+    // the pyo server runs with a smaller buffer than the host, if it divides it evenly
+    subBlockSize = bufferSize;
+    if (bufferSize > PYOSUBBLOCKSIZE && (bufferSize % PYOSUBBLOCKSIZE) == 0) subBlockSize = PYOSUBBLOCKSIZE;
+    subBlockDur = (uint64_t)subBlockSize * 1000000 / sampleRate;
+    inBuffer.assign(bufferSize*nChannels, 0);
+    clockBase = 0;
+    frameCounter = 0;
+    interpreter = pyo_new_interpreter(sampleRate, subBlockSize, nChannels);
     pyoInBuffer = reinterpret_cast<float*>(pyo_get_input_buffer_address(interpreter));
     pyoOutBuffer = reinterpret_cast<float*>(pyo_get_output_buffer_address(interpreter));
     pyoCallback = reinterpret_cast<callPtr*>(pyo_get_embedded_callback_address(interpreter));
     pyoId = pyo_get_server_id(interpreter);
+    requestCounter = 0;
+    workerThreadId = 0;
+    workerMsg.assign(PYOMSGSIZE, 0);
+    workerRunning = true;
+    worker = std::thread(&Pyo::runWorker, this);
+    paramsRunning = true;
+    paramThread = std::thread(&Pyo::runParams, this);
 }
 
 /*
-** Gets updated from ecitor.cpp
-** All it does is check if there is a message in the queue by Python's stdout
-** and returns it to the editor so the message can be stored in LiveLily's traceback 
+** Returns the lines of Python's stdout that were not written by the code of a request
+** e.g. by exec() or by the bound methods, the output of requests is returned by poll()
 */
 std::vector<std::string> Pyo::getStdout() {
     std::vector<std::string> out;
     char *msg;
-    while (pyo_dequeue_stdout(&msg)) {
+    while (pyo_dequeue_stdout_of(workerThreadId, 0, &msg)) {
         out.emplace_back(msg);   // copy into vector
         free(msg);               // free allocated C buffer
     }
@@ -43,9 +56,160 @@ std::vector<std::string> Pyo::getStdout() {
 ** Terminates this object's interpreter.
 */
 Pyo::~Pyo() {
+    if (paramThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(paramMutex);
+            paramsRunning = false;
+        }
+        paramCondition.notify_one();
+        paramThread.join();
+    }
+    if (worker.joinable()) {
+        cancel();
+        {
+            std::lock_guard<std::mutex> lock(requestMutex);
+            workerRunning = false;
+        }
+        requestCondition.notify_one();
+        worker.join();
+    }
     pyo_end_interpreter(interpreter);
 }
 
+/*
+** Queues Python code for the interpreter thread and returns immediately.
+** The stdout of the code and its traceback, if it fails, are streamed back
+** through poll(), followed by a response of type pyoDone.
+**
+** arguments:
+**   code : std::string, the statements to execute.
+**   debug : int, same as in exec().
+**
+** returns the id of the request, which is included in its responses.
+*/
+int Pyo::request(std::string code, int debug) {
+    PyoRequest req;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        req.id = requestCounter++;
+        req.code = code;
+        req.debug = debug;
+        requests.push_back(req);
+    }
+    requestCondition.notify_one();
+    return req.id;
+}
+
+/*
+** Gets the next response of the interpreter thread. Called by the main thread
+** in its update loop, until it returns false.
+** The stdout of the running request is collected here too, so it shows up while the request runs.
+*/
+bool Pyo::poll(PyoResponse& response) {
+    std::lock_guard<std::mutex> lock(responseMutex);
+    int id = runningId.load();
+    if (id >= 0) drainStdout(id);
+    if (responses.empty()) return false;
+    response = responses.front();
+    responses.pop_front();
+    return true;
+}
+
+/*
+** Cancels a request, or all requests if "id" is -1.
+** Pending requests are removed from the queue and a running one is interrupted
+** with a KeyboardInterrupt, which is reported in its traceback.
+** Code that is stuck inside a C function is interrupted once the function returns.
+*/
+void Pyo::cancel(int id) {
+    std::vector<int> removed;
+    {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        for (auto it = requests.begin(); it != requests.end();) {
+            if (id < 0 || it->id == id) {
+                removed.push_back(it->id);
+                it = requests.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(responseMutex);
+        for (int removedId : removed) responses.push_back({removedId, pyoDone, true, ""});
+    }
+    int running = runningId.load();
+    if (running < 0 || (id >= 0 && running != id)) return;
+    cancelId = running;
+    // the exception is raised in the worker's thread state only
+    // so the calls of the parameter thread to the interpreter are not affected
+    PyEval_AcquireThread(interpreter);
+    if (runningId.load() == running) PyThreadState_SetAsyncExc(workerThreadId, PyExc_KeyboardInterrupt);
+    PyEval_ReleaseThread(interpreter);
+}
+
+/*
+** Returns true if there is Python code running or waiting to run.
+*/
+bool Pyo::isBusy() {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    return runningId.load() >= 0 || !requests.empty();
+}
+
+/*
+** The interpreter thread. Waits for requests and executes them one by one
+** with a thread state of its own in the same interpreter as the pyo server.
+*/
+void Pyo::runWorker() {
+    workerState = PyThreadState_New(PyThreadState_GetInterpreter(interpreter));
+    workerThreadId = PyThread_get_thread_ident();
+    while (true) {
+        PyoRequest req;
+        {
+            std::unique_lock<std::mutex> lock(requestMutex);
+            requestCondition.wait(lock, [this] { return !requests.empty() || !workerRunning; });
+            if (!workerRunning) break;
+            req = requests.front();
+            requests.pop_front();
+            runningId = req.id;
+        }
+        // clear an interrupt that was meant for the previous request but arrived after it was done
+        PyEval_AcquireThread(workerState);
+        PyThreadState_SetAsyncExc(workerThreadId, NULL);
+        PyEval_ReleaseThread(workerState);
+        // the executed code might redefine the objects of the bound methods
+        bindingsDirty = true;
+        if (req.code.size() >= workerMsg.size()) workerMsg.assign(req.code.size()+1, 0);
+        strcpy(workerMsg.data(), req.code.c_str());
+        int err = pyo_exec_statement(workerState, workerMsg.data(), req.debug);
+        {
+            std::lock_guard<std::mutex> lock(responseMutex);
+            drainStdout(req.id);
+            bool cancelled = (cancelId.load() == req.id);
+            if (err) responses.push_back({req.id, pyoTraceback, cancelled, std::string(workerMsg.data())});
+            responses.push_back({req.id, pyoDone, cancelled, ""});
+            runningId = -1;
+        }
+    }
+    PyEval_AcquireThread(workerState);
+    PyThreadState_Clear(workerState);
+    PyThreadState_DeleteCurrent();
+}
+
+/*
+** Moves the lines the interpreter thread wrote to Python's stdout to the responses of request "id".
+** Lines written by other threads at the same time stay in the queue for getStdout().
+** Must be called with responseMutex locked, so that no line ends up after the end of its request.
+*/
+void Pyo::drainStdout(int id) {
+    char *msg;
+    while (pyo_dequeue_stdout_of(workerThreadId, 1, &msg)) {
+        responses.push_back({id, pyoStdout, false, std::string(msg)});
+        free(msg);
+    }
+}
+
 /*
 ** This function fills pyo's input buffers with new samples. Should be called
 ** once per process block, inside the host's audioIn function.
@@ -54,7 +218,7 @@ Pyo::~Pyo() {
 **   *buffer : float *, float pointer pointing to the host's input buffers.
 */
 void Pyo::fillin(float *buffer) {
-    for (int i=0; i<(bufferSize*nChannels); i++) pyoInBuffer[i] = buffer[i];
+    for (int i=0; i<(bufferSize*nChannels); i++) inBuffer[i] = buffer[i];
 }
 
 
@@ -62,13 +226,48 @@ void Pyo::fillin(float *buffer) {
 ** This function tells pyo to process a buffer of samples and fills the host's
 ** output buffer with new samples. Should be called once per process block,
 ** inside the host's audioOut function.
+** The buffer is processed in sub-blocks of subBlockSize frames, and before each one
+** the parameter thread is told to apply the queued updates whose time stamp falls in it.
+** The parameter thread already holds the GIL by then, so the updates are applied right away,
+** and this function waits for them, for PYOPARAMMAXWAIT microseconds at most, before the sub-block is processed.
+** Events are delayed by one buffer, since an event queued during this buffer
+** can only be heard from the next one, and this keeps their relative timing intact.
+** This function doesn't call into Python and doesn't lock, so it never waits for the GIL.
+** If the parameter thread couldn't take the GIL in time, e.g. because Python code is running,
+** its updates land in a later sub-block instead.
 **
 ** arguments:
 **   *buffer : float *, float pointer pointing to the host's output buffers.
+**   timeStamp : uint64_t, the time this function is called, in microseconds.
 */
-void Pyo::process(float *buffer) {
-    pyoCallback(pyoId);
-    for (int i=0; i<(bufferSize*nChannels); i++) buffer[i] = pyoOutBuffer[i];
+void Pyo::process(float *buffer, uint64_t timeStamp) {
+    // derive the time of this buffer from the number of processed frames, so it doesn't jitter
+    // with the audio callback, and restart the count if it drifts by more than a buffer (e.g. after a dropout)
+    uint64_t bufferDur = (uint64_t)bufferSize * 1000000 / sampleRate;
+    uint64_t bufferStart = clockBase + (frameCounter * 1000000 / sampleRate);
+    if (frameCounter == 0 || (timeStamp > bufferStart ? timeStamp - bufferStart : bufferStart - timeStamp) > bufferDur) {
+        clockBase = bufferStart = timeStamp;
+        frameCounter = 0;
+    }
+    frameCounter += bufferSize;
+    int numSubBlocks = bufferSize / subBlockSize;
+    int subBlockSamples = subBlockSize * nChannels;
+    for (int block=0; block<numSubBlocks; block++) {
+        uint64_t blockEnd = bufferStart + ((uint64_t)(block+1) * subBlockSize * 1000000 / sampleRate);
+        uint64_t blockTime = blockEnd - bufferDur;
+        // notifying without the lock might miss a wait that is about to start, which the thread bounds with a timeout
+        applyUntil.store(blockTime, std::memory_order_release);
+        paramCondition.notify_one();
+        if (nextParamTime.load(std::memory_order_acquire) < blockTime) {
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(PYOPARAMMAXWAIT);
+            while (appliedUntil.load(std::memory_order_acquire) < blockTime && nextParamTime.load(std::memory_order_acquire) < blockTime) {
+                if (std::chrono::steady_clock::now() >= deadline) break;
+            }
+        }
+        for (int i=0; i<subBlockSamples; i++) pyoInBuffer[i] = inBuffer[block*subBlockSamples+i];
+        pyoCallback(pyoId);
+        for (int i=0; i<subBlockSamples; i++) buffer[block*subBlockSamples+i] = pyoOutBuffer[i];
+    }
 }
 
 /*
@@ -87,6 +286,7 @@ void Pyo::process(float *buffer) {
 ** returns 0 (no error), 1 (failed to open the file) or 2 (bad code in file).
 */
 int Pyo::loadfile(const char *file, int add) {
+    bindingsDirty = true;
     return pyo_exec_file(interpreter, file, pyoMsg, add);
 }
 
@@ -202,9 +402,175 @@ int Pyo::set(const char *name, float *value, int len) {
     return pyo_exec_statement(interpreter, pyoMsg, 0);
 }
 
+/*
+** Registers a method of a Python object that will receive numerical values
+** through pushParam(), without compiling a Python statement for every update.
+** The method is looked up in the interpreter by the parameter thread, the first time
+** it is used and every time Python code is executed, in case the object is redefined.
+** Must be called from the main thread.
+**
+** arguments:
+**   name : std::string, variable name of the object.
+**   method : std::string, name of the method to call.
+**
+** returns the index of the binding, or -1 if no more bindings can be stored.
+**
+** Example:
+**
+** int freqBinding = pyo.bind("synth", "setFreq");
+** float freq = 440;
+** pyo.pushParam(freqBinding, &freq, 1); // calls synth.setFreq(440.0) at the next audio buffer
+*/
+int Pyo::bind(std::string name, std::string method) {
+    int num = numBindings.load(std::memory_order_acquire);
+    for (int i=0; i<num; i++) {
+        if (bindings[i].name == name && bindings[i].method == method) return i;
+    }
+    if (num >= PYOMAXBINDINGS) return -1;
+    bindings[num].name = name;
+    bindings[num].method = method;
+    bindings[num].callable = NULL;
+    numBindings.store(num+1, std::memory_order_release);
+    bindingsDirty = true;
+    return num;
+}
+
+/*
+** Queues numerical values for a bound method. A single value is passed as a float
+** and more values as a list. This is lock-free and is meant to be called by one thread only
+** (the sequencer). The values are applied at the sub-block of the time stamp,
+** or at the beginning of the next audio buffer if the time stamp is 0.
+** Time stamps may be pushed in any order, updates with equal stamps are applied in the order they were pushed.
+**
+** returns false if the binding is invalid or the queue is full.
+*/
+bool Pyo::pushParam(int binding, const float *values, int len, uint64_t timeStamp) {
+    if (binding < 0 || binding >= numBindings.load(std::memory_order_acquire)) return false;
+    PyoParam param;
+    param.binding = binding;
+    param.timeStamp = timeStamp;
+    param.len = (len > PYOMAXVALUES ? PYOMAXVALUES : len);
+    for (int i=0; i<param.len; i++) param.values[i] = values[i];
+    return params.push(param);
+}
+
+/*
+** Looks up the bound methods in the interpreter's main module.
+** Must be called with the interpreter's thread state acquired.
+*/
+void Pyo::resolveBindings() {
+    PyObject *module = PyImport_AddModule("__main__");
+    int num = numBindings.load(std::memory_order_acquire);
+    for (int i=0; i<num; i++) {
+        Py_XDECREF(bindings[i].callable);
+        bindings[i].callable = NULL;
+        PyObject *obj = PyObject_GetAttrString(module, bindings[i].name.c_str());
+        if (obj == NULL) {
+            PyErr_Clear();
+            continue;
+        }
+        bindings[i].callable = PyObject_GetAttrString(obj, bindings[i].method.c_str());
+        if (bindings[i].callable == NULL) PyErr_Clear();
+        Py_DECREF(obj);
+    }
+    bindingsDirty = false;
+}
+
+/*
+** Applies the queued parameter updates with a time stamp before "until".
+** If there are updates due in the next sub-block, the GIL is kept until the audio thread
+** publishes the time of that sub-block, so they are applied as soon as it starts.
+** Called by the parameter thread, which is the only consumer of the queue.
+*/
+void Pyo::applyParams(uint64_t until) {
+    PyoParam param;
+    while (params.pop(param)) {
+        pendingParams.insert(std::make_pair(param.timeStamp, param));
+    }
+    nextParamTime.store(pendingParams.empty() ? UINT64_MAX : pendingParams.begin()->first, std::memory_order_release);
+    if (pendingParams.empty() || pendingParams.begin()->first >= until + subBlockDur) {
+        appliedUntil.store(until, std::memory_order_release);
+        return;
+    }
+    PyEval_AcquireThread(paramState);
+    if (bindingsDirty) resolveBindings();
+    callParams(until);
+    // don't hold the GIL for longer than two sub-blocks, in case the audio stops
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(subBlockDur * 2);
+    while (!pendingParams.empty() && pendingParams.begin()->first < until + subBlockDur && paramsRunning) {
+        uint64_t now = applyUntil.load(std::memory_order_acquire);
+        if (now != until) {
+            until = now;
+            callParams(until);
+        }
+        else if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    PyEval_ReleaseThread(paramState);
+}
+
+/*
+** Calls the bound methods of the pending updates with a time stamp before "until",
+** and publishes "until" to the audio thread.
+** Must be called by the parameter thread with its thread state acquired.
+*/
+void Pyo::callParams(uint64_t until) {
+    PyoParam param;
+    while (!pendingParams.empty() && pendingParams.begin()->first < until) {
+        param = pendingParams.begin()->second;
+        pendingParams.erase(pendingParams.begin());
+        PyObject *callable = bindings[param.binding].callable;
+        if (callable == NULL) continue;
+        PyObject *arg;
+        if (param.len == 1) {
+            arg = PyFloat_FromDouble(param.values[0]);
+        }
+        else {
+            arg = PyList_New(param.len);
+            for (int i=0; i<param.len; i++) PyList_SET_ITEM(arg, i, PyFloat_FromDouble(param.values[i]));
+        }
+        PyObject *res = PyObject_CallFunctionObjArgs(callable, arg, NULL);
+        if (res == NULL) PyErr_Clear();
+        Py_XDECREF(res);
+        Py_DECREF(arg);
+    }
+    nextParamTime.store(pendingParams.empty() ? UINT64_MAX : pendingParams.begin()->first, std::memory_order_release);
+    appliedUntil.store(until, std::memory_order_release);
+}
+
+/*
+** The parameter thread. Applies the queued updates up to the time the audio thread
+** publishes before every sub-block, with a thread state of its own in the interpreter.
+** It wakes up at every sub-block, so it sees an update at least one sub-block before it is due.
+*/
+void Pyo::runParams() {
+    paramState = PyThreadState_New(PyThreadState_GetInterpreter(interpreter));
+    uint64_t applied = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(paramMutex);
+            paramCondition.wait_for(lock, std::chrono::milliseconds(1), [this, applied] {
+                return applyUntil.load(std::memory_order_acquire) != applied || !paramsRunning;
+            });
+            if (!paramsRunning) break;
+        }
+        applied = applyUntil.load(std::memory_order_acquire);
+        applyParams(applied);
+    }
+    PyEval_AcquireThread(paramState);
+    PyThreadState_Clear(paramState);
+    PyThreadState_DeleteCurrent();
+}
+
 /*
 ** Executes any raw valid python statement. With this function, one can dynamically
 ** creates and manipulates audio objects and algorithms.
+** This blocks the calling thread until the statement is done, use request()
+** for code that might take long.
 **
 ** arguments:
 **   msg : const char *, pointer to a string containing the statement to execute.
@@ -218,6 +584,8 @@ int Pyo::set(const char *name, float *value, int len) {
 ** pyo.exec("b = SumOsc(freq=fr, ratio=0.499, index=0.4, mul=0.2).out()")
 */
 int Pyo::exec(const char *_msg, int debug) {
+    // the executed code might redefine the objects of the bound methods
+    bindingsDirty = true;
     strcpy(pyoMsg, _msg);
     return pyo_exec_statement(interpreter, pyoMsg, debug);
 }
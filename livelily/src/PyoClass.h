@@ -8,14 +8,57 @@
 #include <vector>
 
 #ifdef USEPYO
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <map>
+#include "ringBuffer.h"
+
+#define PYOMAXBINDINGS 256
+#define PYOMAXVALUES 16 // maximum number of values of one parameter update, e.g. the notes of a chord
+#define PYOPARAMQUEUESIZE 1024
+#define PYOSUBBLOCKSIZE 32 // pyo runs in blocks of this many frames so that events land close to their time
+#define PYOPARAMMAXWAIT 100 // microseconds the audio thread waits at most for the updates due in a sub-block
+
 typedef int callPtr(int);
 
+// a numeric update of a bound method, queued by the sequencer and applied by the parameter thread of Pyo
+// the time stamp is in microseconds, in the same clock as ofGetElapsedTimeMicros(), or 0 to apply at once
+struct PyoParam {
+	int binding;
+	int len;
+	float values[PYOMAXVALUES];
+	uint64_t timeStamp;
+};
+
+// Python code queued by the main thread for the interpreter thread
+struct PyoRequest {
+	int id;
+	std::string code;
+	int debug;
+};
+
+enum pyoResponseTypes {pyoStdout, pyoTraceback, pyoDone};
+
+// a line of stdout, the traceback of a failed request, or the end of a request
+// sent back by the interpreter thread and polled by the main thread
+struct PyoResponse {
+	int id;
+	int type;
+	bool cancelled;
+	std::string text;
+};
+
 class Pyo {
     public:
         ~Pyo();
         void setup(int nChannels, int bufferSize, int sampleRate);
 		std::vector<std::string> getStdout();
-        void process(float *buffer);
+        void process(float *buffer, uint64_t timeStamp);
         void fillin(float *buffer);
         void clear();
         int loadfile(const char *file, int add);
@@ -25,12 +68,70 @@ class Pyo {
         int value(const char *name, float *value, int len);
         int set(const char *name, float value);
         int set(const char *name, float *value, int len);
+        int bind(std::string name, std::string method);
+        bool pushParam(int binding, const float *values, int len, uint64_t timeStamp = 0);
+        int request(std::string code, int debug);
+        bool poll(PyoResponse& response);
+        void cancel(int id = -1);
+        bool isBusy();
 
     private:
+        void resolveBindings();
+        void applyParams(uint64_t until);
+        void callParams(uint64_t until);
+        void runParams();
+        void runWorker();
+        void drainStdout(int id);
+
+        // methods of Python objects, resolved once and called with raw floats
+        struct PyoBinding {
+            std::string name;
+            std::string method;
+            PyObject *callable;
+        };
+        PyoBinding bindings[PYOMAXBINDINGS];
+        std::atomic<int> numBindings{0};
+        std::atomic<bool> bindingsDirty{true};
+        RingBuffer<PyoParam, PYOPARAMQUEUESIZE> params;
+        // the queued updates are applied by a thread of their own, so the audio thread never waits for the GIL
+        // the audio thread publishes the time up to which the updates are due, before every sub-block
+        // the thread takes the GIL one sub-block ahead of an update, and applies it as soon as its sub-block starts
+        std::thread paramThread;
+        PyThreadState *paramState;
+        std::atomic<uint64_t> applyUntil{0};
+        std::atomic<uint64_t> appliedUntil{0};
+        std::atomic<uint64_t> nextParamTime{UINT64_MAX}; // the time stamp of the earliest update not applied yet
+        // the updates taken from the queue, ordered by time stamp, since the instruments and their ramps
+        // push stamps that don't increase across each other, and an update mustn't wait behind a later one
+        std::multimap<uint64_t, PyoParam> pendingParams;
+        std::atomic<bool> paramsRunning{false};
+        std::mutex paramMutex;
+        std::condition_variable paramCondition;
         int nChannels;
         int bufferSize;
         int sampleRate;
+        // the host buffer is processed in sub-blocks, with the events due in each applied before it
+        int subBlockSize;
+        uint64_t subBlockDur; // in microseconds
+        std::vector<float> inBuffer;
+        uint64_t clockBase;
+        uint64_t frameCounter;
         PyThreadState *interpreter;
+        // Python code typed in the editor runs in its own thread, with its own thread state
+        // so that a long statement doesn't block the main thread and it can be interrupted
+        std::thread worker;
+        PyThreadState *workerState;
+        std::atomic<unsigned long> workerThreadId; // the stdout lines of this thread belong to the running request
+        std::mutex requestMutex;
+        std::condition_variable requestCondition;
+        std::deque<PyoRequest> requests;
+        std::mutex responseMutex;
+        std::deque<PyoResponse> responses;
+        std::atomic<int> runningId{-1};
+        std::atomic<int> cancelId{-1}; // the cancellation token, the id of the request to interrupt
+        std::atomic<bool> workerRunning{false};
+        int requestCounter;
+        std::vector<char> workerMsg;
         float *pyoInBuffer;
         float *pyoOutBuffer;
         callPtr *pyoCallback;
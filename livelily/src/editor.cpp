@@ -19,6 +19,9 @@ Editor::Editor()
 	cursorPos = 0;
 	arrowCursorPos = 0;
 	activeSession = true;
+	typingAnimFirstLine = typingAnimLastLine = -1;
+	typingAnimRate = 0;
+	typingAnimTimeStamp = 0;
 
 	executionStepPerMs = (float)EXECUTIONBRIGHTNESS / (float)(EXECUTIONDUR - EXECUTIONRAMPSTART);
 
@@ -473,7 +476,7 @@ void Editor::drawText()
 			strOnCursorLineYOffset = strYOffset;
 		}
 		// draw all strings that are not empty
-		if (allStrings[i].size() > 0) {
+		if (allStrings[i].size() > 0 && !isHiddenByTypingAnim(i)) {
 			// iterate through each word to check for keywords
 			// set last argument to tokenizeString to true to include the delimiters
 			std::vector<std::string> tokens = tokenizeString(allStrings[i], delimiters[thisLang], true);
@@ -1502,7 +1505,6 @@ void Editor::assembleString(int key, bool executing, bool lineBreaking)
 				highlightManyChars = false;
 			}
 #ifdef USEPYO
-			int err = 0;
 			std::string pyStr = "";
 #endif
 			switch (thisLang) {
@@ -1516,65 +1518,9 @@ void Editor::assembleString(int key, bool executing, bool lineBreaking)
 						if (i > 0) pyStr += "\n";
 						pyStr += allStrings[i+executingLineLocal];
 					}
-					// execute the Python line in verbose mode with the last argument set to 1
-					err = ((ofApp*)ofGetAppPtr())->sharedData.pyo.exec(pyStr.c_str(), 1);
-					if (err) {
-						std::string errStr = ((ofApp*)ofGetAppPtr())->sharedData.pyo.getErrorMsg();
-						size_t lineNdx = errStr.find("line")+ 5;
-						errStr = errStr.substr(0, lineNdx) + std::to_string(executingLineLocal+1) + errStr.substr(lineNdx+errStr.substr(lineNdx+1).find(" "));
-						setTraceback(3, errStr, executingLineLocal, lineNdx);
-					}
-					else {
-						std::vector<std::string> pyStdout = ((ofApp*)ofGetAppPtr())->sharedData.pyo.getStdout();
-						if (pyStdout.size() > 1) {
-							bool sendToLily = false;
-							int whichPane = objID;
-							size_t startChar = 0;
-							std::string s = "";
-							if (startsWith(pyStdout[0], "livelily-") || startsWith(pyStdout[0], "livelily: ")) {
-								sendToLily = true;
-								if (pyStdout[0].substr(8, 1).compare("-") == 0) {
-									size_t colonNdx = pyStdout[0].find(":");
-									if (colonNdx != std::string::npos && colonNdx > 9 &&
-											isNumber(pyStdout[0].substr(9, colonNdx-9))) {
-										whichPane = stoi(pyStdout[0].substr(9, colonNdx-9)) - 1;
-										startChar = colonNdx + 2;
-										if (startChar >= pyStdout[0].size()) {
-											sendToLily = false;
-										}
-									}
-									else {
-										sendToLily = false;
-									}
-								}
-								else {
-									whichPane = ((ofApp*)ofGetAppPtr())->whichPane;
-									startChar = pyStdout[0].find(" ") + 1;
-									if (startChar >= pyStdout[0].size()) {
-										sendToLily = false;
-									}
-								}
-							}
-						    for (size_t i = 0; i < pyStdout.size()-1; i++) {
-								s += pyStdout[i];
-								if (i < pyStdout.size()-2 && !endsWith(pyStdout[i], "\n")) s += "\n";
-								if (sendToLily) {
-									startChar = (i == 0 ? startChar : 0);
-									((ofApp*)ofGetAppPtr())->sharedData.pyStdoutStr += s.substr(startChar);
-								}
-								else {
-									setTraceback(1, s, executingLineLocal);
-								}
-						    }
-							if (sendToLily) {
-								((ofApp*)ofGetAppPtr())->sharedData.whichPyPane = whichPane;
-								((ofApp*)ofGetAppPtr())->sharedData.typePyStr = true;
-							}
-						}
-						else {
-						    releaseTraceback(executingLineLocal);
-						}
-					}
+					// execute the Python code in verbose mode with the last argument set to 1
+					// in the interpreter thread, its output is received in pyoResponse()
+					pyRequestLines[((ofApp*)ofGetAppPtr())->sharedData.pyo.request(pyStr, 1)] = executingLineLocal;
 #endif
 					break;
 				default:
@@ -1891,6 +1837,46 @@ void Editor::setString(std::string s)
 	cursorPos = maxCursorPos();
 }
 
+//--------------------------------------------------------------
+void Editor::insertString(std::string str)
+{
+	// inserts a run of characters without line breaks at the cursor in one edit
+	// used to type Python output in bulk, instead of calling assembleString() for every character
+	if (highlightManyChars) deleteString();
+	std::string strWithoutTabs = replaceCharInStr(str, "\t", tabStr);
+	int absPos = std::min(cursorPos + allStringStartPos[cursorLineIndex], (int)allStrings[cursorLineIndex].size());
+	allStrings[cursorLineIndex].insert(absPos, strWithoutTabs);
+	absPos += (int)strWithoutTabs.size();
+	// if the string gets longer than the pane, scroll it so the cursor stays visible
+	allStringStartPos[cursorLineIndex] = std::max(allStringStartPos[cursorLineIndex], absPos - maxCharactersPerString);
+	cursorPos = arrowCursorPos = absPos - allStringStartPos[cursorLineIndex];
+	fileEdited = true;
+}
+
+//--------------------------------------------------------------
+void Editor::startTypingAnim(int firstLine, float animRate)
+{
+	// the lines from firstLine to the cursor line have already been typed, and are revealed gradually when drawn
+	if (animRate <= 0) return;
+	typingAnimFirstLine = firstLine;
+	typingAnimLastLine = cursorLineIndex;
+	typingAnimRate = animRate;
+	typingAnimTimeStamp = ofGetElapsedTimeMillis();
+}
+
+//--------------------------------------------------------------
+bool Editor::isHiddenByTypingAnim(int lineNum)
+{
+	if (typingAnimRate <= 0 || lineNum < typingAnimFirstLine || lineNum > typingAnimLastLine) return false;
+	int linesRevealed = (int)((ofGetElapsedTimeMillis() - typingAnimTimeStamp) * typingAnimRate / 1000.0);
+	if (typingAnimFirstLine + linesRevealed > typingAnimLastLine) {
+		// the animation is over
+		typingAnimRate = 0;
+		return false;
+	}
+	return lineNum > typingAnimFirstLine + linesRevealed;
+}
+
 //--------------------------------------------------------------
 void Editor::setHighlightManyChars(int charPos1, int charPos2, int charLine1, int charLine2)
 {
@@ -2814,6 +2800,14 @@ void Editor::setTraceback(int errorCode, std::string errorStr, int lineNum, size
 	tracebackStrBreakPnt[lineNum] = strBreakPnt;
 }
 
+//--------------------------------------------------------------
+void Editor::appendTraceback(std::string str, int lineNum)
+{
+	tracebackStr[lineNum] += str;
+	tracebackTimeStamps[lineNum] = ofGetElapsedTimeMillis();
+	tracebackNumLines[lineNum] += count(begin(str), end(str), '\n');
+}
+
 //--------------------------------------------------------------
 void Editor::releaseTraceback(int lineNum)
 {
@@ -2844,6 +2838,105 @@ uint64_t Editor::getTracebackTimeStamp(int lineNum)
 	return tracebackTimeStamps[lineNum];
 }
 
+//--------------------------------------------------------------
+bool Editor::pyoResponse(int id, int type, bool cancelled, std::string text)
+{
+	std::map<int, int>::iterator lineIt = pyRequestLines.find(id);
+	if (lineIt == pyRequestLines.end()) return false;
+#ifdef USEPYO
+	int lineNum = lineIt->second;
+	std::vector<std::string>& pyStdout = pyRequestStdout[id];
+	if (type == pyoStdout) {
+		pyStdout.push_back(text);
+		// stdout is shown while the code runs, unless it is meant to be typed in a LiveLily pane
+		if (startsWith(pyStdout[0], "livelily-") || startsWith(pyStdout[0], "livelily: ")) return true;
+		// only the new output is added to what is shown, without the newlines at its end
+		size_t lastChar = text.find_last_not_of('\n');
+		std::map<int, int>::iterator newlinesIt = pyRequestNewlines.find(id);
+		if (lastChar == std::string::npos) {
+			if (newlinesIt != pyRequestNewlines.end()) newlinesIt->second += (int)text.size();
+			return true;
+		}
+		if (newlinesIt == pyRequestNewlines.end()) {
+			setTraceback(1, text.substr(0, lastChar+1), lineNum);
+			newlinesIt = pyRequestNewlines.insert(std::make_pair(id, 0)).first;
+		}
+		else {
+			appendTraceback(std::string(newlinesIt->second, '\n') + text.substr(0, lastChar+1), lineNum);
+		}
+		newlinesIt->second = (int)(text.size() - lastChar - 1);
+		return true;
+	}
+	if (type == pyoTraceback) {
+		std::string errStr = text;
+		if (cancelled) {
+			setTraceback(2, "interrupted", lineNum);
+		}
+		else {
+			size_t lineNdx = errStr.find("line")+ 5;
+			errStr = errStr.substr(0, lineNdx) + std::to_string(lineNum+1) + errStr.substr(lineNdx+errStr.substr(lineNdx+1).find(" "));
+			setTraceback(3, errStr, lineNum, lineNdx);
+		}
+		pyStdout.clear();
+		return true;
+	}
+	// the request is done, check if its stdout should be typed in a LiveLily pane
+	if (pyStdout.size() > 1 && (startsWith(pyStdout[0], "livelily-") || startsWith(pyStdout[0], "livelily: "))) {
+		bool sendToLily = true;
+		int whichPane = objID;
+		size_t startChar = 0;
+		if (pyStdout[0].substr(8, 1).compare("-") == 0) {
+			size_t colonNdx = pyStdout[0].find(":");
+			if (colonNdx != std::string::npos && colonNdx > 9 &&
+					isNumber(pyStdout[0].substr(9, colonNdx-9))) {
+				whichPane = stoi(pyStdout[0].substr(9, colonNdx-9)) - 1;
+				startChar = colonNdx + 2;
+				if (startChar >= pyStdout[0].size()) {
+					sendToLily = false;
+				}
+			}
+			else {
+				sendToLily = false;
+			}
+			if (sendToLily && ((ofApp*)ofGetAppPtr())->editors.find(whichPane) == ((ofApp*)ofGetAppPtr())->editors.end()) {
+				setTraceback(3, "pane " + std::to_string(whichPane+1) + " doesn't exist", lineNum);
+				pyRequestStdout.erase(id);
+				pyRequestNewlines.erase(id);
+				pyRequestLines.erase(lineIt);
+				return true;
+			}
+		}
+		else {
+			whichPane = ((ofApp*)ofGetAppPtr())->whichPane;
+			startChar = pyStdout[0].find(" ") + 1;
+			if (startChar >= pyStdout[0].size()) {
+				sendToLily = false;
+			}
+		}
+		std::string s = "";
+		for (size_t i = 0; i < pyStdout.size()-1; i++) {
+			s += pyStdout[i];
+			if (i < pyStdout.size()-2 && !endsWith(pyStdout[i], "\n")) s += "\n";
+		}
+		if (sendToLily) {
+			((ofApp*)ofGetAppPtr())->sharedData.pyStdoutStr += s.substr(startChar);
+			((ofApp*)ofGetAppPtr())->sharedData.whichPyPane = whichPane;
+			((ofApp*)ofGetAppPtr())->sharedData.typePyStr = true;
+		}
+		else {
+			setTraceback(1, s, lineNum);
+		}
+	}
+	else if (pyStdout.empty() && !cancelled && getTracebackColor(lineNum) != 2) {
+		releaseTraceback(lineNum);
+	}
+	pyRequestStdout.erase(id);
+	pyRequestNewlines.erase(id);
+#endif
+	pyRequestLines.erase(lineIt);
+	return true;
+}
+
 //--------------------------------------------------------------
 int Editor::getTracebackNumLines(int lineNum)
 {
@@ -134,6 +134,10 @@ class Editor
 		void assembleString(int key);
 		// set entire string to a line (used for remote typing)
 		void setString(std::string s);
+		void insertString(std::string str);
+		// reveal the lines typed at once from Python gradually, at animRate lines per second
+		void startTypingAnim(int firstLine, float animRate);
+		bool isHiddenByTypingAnim(int lineNum);
 		// set variables for highlighting many characters
 		// for executing multiple lines, copying, pasting, deleting, cutting
 		void setHighlightManyChars(int charPos1, int charPos2, int charLine1, int charLine2);
@@ -180,6 +184,7 @@ class Editor
 		std::vector<int> sortVec(std::vector<int> v);
 		// traceback functions
 		void setTraceback(int errorCode, std::string errorStr, int lineNum, size_t strBreakPnt=0);
+		void appendTraceback(std::string str, int lineNum);
 		void releaseTraceback(int lineNum);
 		std::string getTracebackStr(int lineNum);
 		int getTracebackColor(int lineNum);
@@ -188,6 +193,8 @@ class Editor
 		uint64_t getTracebackDur();
 		std::map<int, uint64_t>::iterator getTracebackTimeStampsBegin();
 		std::map<int, uint64_t>::iterator getTracebackTimeStampsEnd();
+		// output of the Python interpreter thread, returns false if the request is not from this pane
+		bool pyoResponse(int id, int type, bool cancelled, std::string text);
 		// receive single characters from OSC
 		void fromOscPress(int ascii);
 		void fromOscRelease(int ascii);
@@ -307,6 +314,16 @@ class Editor
 		// useful in case we hit shift+return as the cursor will move
 		// before the line is executed
 		int executingLine;
+		// lines passed to startTypingAnim() are revealed gradually when drawn, if an animation rate is set
+		int typingAnimFirstLine;
+		int typingAnimLastLine;
+		float typingAnimRate; // in lines per second
+		uint64_t typingAnimTimeStamp;
+		// Python code sent to the interpreter thread, mapped to its first line and its stdout so far
+		std::map<int, int> pyRequestLines;
+		std::map<int, std::vector<std::string>> pyRequestStdout;
+		// newlines at the end of the stdout shown so far, added only if more output follows
+		std::map<int, int> pyRequestNewlines;
 		// used in case we're executing more than one lines
 		// so as many rectangles as the executing lines are created
 		// all with the same width
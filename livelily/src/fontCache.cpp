@@ -0,0 +1,84 @@
+#include "fontCache.h"
+
+std::map<std::pair<std::string, int>, std::weak_ptr<CachedFont>> FontCache::fonts;
+
+/*********************** cached font class ********************/
+//--------------------------------------------------------------
+bool CachedFont::load(const std::string& fileName, int size)
+{
+	metrics.clear();
+	return font.load(fileName, size);
+}
+
+//--------------------------------------------------------------
+void CachedFont::measure(const std::string *strings, int numStrings)
+{
+	for (int i = 0; i < numStrings; i++) {
+		getMetrics(strings[i]);
+	}
+}
+
+//--------------------------------------------------------------
+StringMetrics CachedFont::getMetrics(const std::string& str)
+{
+	auto it = metrics.find(str);
+	if (it == metrics.end()) {
+		StringMetrics m;
+		m.width = font.stringWidth(str);
+		m.height = font.stringHeight(str);
+		m.bounds = font.getStringBoundingBox(str, 0, 0);
+		it = metrics.insert(std::make_pair(str, m)).first;
+	}
+	return it->second;
+}
+
+//--------------------------------------------------------------
+float CachedFont::stringWidth(const std::string& str)
+{
+	return getMetrics(str).width;
+}
+
+//--------------------------------------------------------------
+float CachedFont::stringHeight(const std::string& str)
+{
+	return getMetrics(str).height;
+}
+
+//--------------------------------------------------------------
+ofRectangle CachedFont::getStringBoundingBox(const std::string& str)
+{
+	return getMetrics(str).bounds;
+}
+
+//--------------------------------------------------------------
+void CachedFont::drawString(const std::string& str, float x, float y) const
+{
+	font.drawString(str, x, y);
+}
+
+//--------------------------------------------------------------
+const ofTrueTypeFont& CachedFont::getFont() const
+{
+	return font;
+}
+
+/************************ font cache class ********************/
+//--------------------------------------------------------------
+std::shared_ptr<CachedFont> FontCache::get(const std::string& fileName, int size)
+{
+	std::pair<std::string, int> key = std::make_pair(fileName, size);
+	auto it = fonts.find(key);
+	if (it != fonts.end()) {
+		std::shared_ptr<CachedFont> font = it->second.lock();
+		if (font) return font;
+	}
+	// fonts that are not used any more are forgotten when a new one is loaded
+	for (auto it2 = fonts.begin(); it2 != fonts.end();) {
+		if (it2->second.expired()) it2 = fonts.erase(it2);
+		else ++it2;
+	}
+	std::shared_ptr<CachedFont> font = std::make_shared<CachedFont>();
+	font->load(fileName, size);
+	fonts[key] = font;
+	return font;
+}
@@ -0,0 +1,50 @@
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+#include "ofMain.h"
+#include <map>
+#include <unordered_map>
+#include <memory>
+
+// the metrics of a string as measured by its font
+struct StringMetrics
+{
+	float width;
+	float height;
+	ofRectangle bounds; // with the string drawn at the origin
+};
+
+// a font loaded at one size and shared by all the staffs and notes that use it
+// the metrics of each string are stored the first time it is measured, or in advance with measure()
+// the layout passes don't measure strings, so like loading, measuring is done only from the thread that draws
+class CachedFont
+{
+	public:
+		bool load(const std::string& fileName, int size);
+		void measure(const std::string *strings, int numStrings);
+		float stringWidth(const std::string& str);
+		float stringHeight(const std::string& str);
+		ofRectangle getStringBoundingBox(const std::string& str);
+		void drawString(const std::string& str, float x, float y) const;
+		const ofTrueTypeFont& getFont() const;
+
+	private:
+		StringMetrics getMetrics(const std::string& str);
+
+		ofTrueTypeFont font;
+		std::unordered_map<std::string, StringMetrics> metrics;
+};
+
+// hands out fonts by file name and size, loading each combination only once
+// the fonts are reference counted, so a font is released once no staff uses it any more
+// fonts load textures, so get() must be called from the thread that draws
+class FontCache
+{
+	public:
+		static std::shared_ptr<CachedFont> get(const std::string& fileName, int size);
+
+	private:
+		static std::map<std::pair<std::string, int>, std::weak_ptr<CachedFont>> fonts;
+};
+
+#endif
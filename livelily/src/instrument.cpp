@@ -1,4 +1,5 @@
 #include "instrument.h"
+#include <set>
 
 //--------------------------------------------------------------
 Instrument::Instrument()
@@ -51,6 +52,19 @@ Instrument::Instrument()
 	transposition = 0;
 
 	startGliss = false;
+	glissRate = GLISSGRAIN;
+	glissNumVoices = 0;
+	glissNumFrames = 0;
+	glissFrame = 0;
+
+	pyoFreqBinding = -1;
+	pyoAmpBinding = -1;
+
+	startDynRamp = false;
+	dynRampRate = DYNRAMPGRAIN;
+	dynRampOutput = dynRampDefault;
+	dynRampFrame = 0;
+	dynRampLastMidiVal = -1;
 
 	delayState = false;
 	delayTime = 0;
@@ -149,6 +163,54 @@ int64_t Instrument::getDelayTime()
 	return delayTime;
 }
 
+//--------------------------------------------------------------
+void Instrument::setGlissRate(int64_t rate)
+{
+	glissRate = rate;
+}
+
+//--------------------------------------------------------------
+int64_t Instrument::getGlissRate()
+{
+	return glissRate;
+}
+
+//--------------------------------------------------------------
+void Instrument::setDynamicsRampStart(bool startRamp)
+{
+	startDynRamp = startRamp;
+}
+
+//--------------------------------------------------------------
+bool Instrument::getDynamicsRampStart()
+{
+	return startDynRamp;
+}
+
+//--------------------------------------------------------------
+void Instrument::setDynamicsRampRate(int64_t rate)
+{
+	dynRampRate = rate;
+}
+
+//--------------------------------------------------------------
+int64_t Instrument::getDynamicsRampRate()
+{
+	return dynRampRate;
+}
+
+//--------------------------------------------------------------
+void Instrument::setDynamicsRampOutput(int output)
+{
+	dynRampOutput = output;
+}
+
+//--------------------------------------------------------------
+int Instrument::getDynamicsRampOutput()
+{
+	return dynRampOutput;
+}
+
 //--------------------------------------------------------------
 void Instrument::setSendMIDI(bool sendMIDI)
 {
@@ -429,47 +491,87 @@ void Instrument::setScoreNotes(int bar, int numerator, int denominator, int numB
 //--------------------------------------------------------------
 void Instrument::setNotePositions(int bar)
 {
-	notesObj.setNotePositions(bar);
-	notesObj.storeArticulationsCoords(bar);
-	notesObj.storeTupletCoords(bar);
-	notesObj.storeSlurCoords(bar);
-	notesObj.storeOttavaCoords(bar);
-	notesObj.storeTextCoords(bar);
-	notesObj.storeDynamicsCoords(bar);
-	notesObj.storeMinMaxY(bar);
+	notesObj.invalidateLayout(bar);
+	setNotePositions(std::vector<int>{bar});
 }
 
 //--------------------------------------------------------------
-void Instrument::setNotePositions(int bar, int numBars)
+void Instrument::setNotePositions(const std::vector<int>& bars)
 {
-	for (int i = 0; i < numBars; i++) {
-		notesObj.setNotePositions(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+	// bars laid out together are run through each pass before moving to the next one
+	// as a slur that spans more than one bar depends on the stems of all of them
+	// each bar starts from the first pass that is out of date
+	std::vector<int> firstPasses;
+	for (auto it = bars.begin(); it != bars.end(); ++it) {
+		firstPasses.push_back(notesObj.getFirstDirtyPass(*it));
+	}
+	for (int pass = 0; pass < numLayoutPasses; pass++) {
+		for (size_t i = 0; i < bars.size(); i++) {
+			if (firstPasses[i] <= pass) notesObj.runLayoutPass(bars[i], pass, pass == firstPasses[i]);
+		}
 	}
-	for (int i = 0; i < numBars; i++) {
-		notesObj.storeArticulationsCoords(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+	for (auto it = bars.begin(); it != bars.end(); ++it) {
+		notesObj.setLayoutClean(*it);
 	}
-	for (int i = 0; i < numBars; i++) {
-		notesObj.storeTupletCoords(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+}
+
+//--------------------------------------------------------------
+void Instrument::setLayoutDirty(int bar)
+{
+	notesObj.invalidateLayout(bar);
+}
+
+//--------------------------------------------------------------
+bool Instrument::hasLayoutDirty(const std::vector<int>& bars)
+{
+	for (auto it = bars.begin(); it != bars.end(); ++it) {
+		if (notesObj.isLayoutDirty(*it)) return true;
 	}
-	for (int i = 0; i < numBars; i++) {
-		notesObj.storeSlurCoords(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+	return false;
+}
+
+//--------------------------------------------------------------
+void Instrument::timeLayoutPasses(const std::vector<int>& bars, uint64_t *passDurs)
+{
+	// lays out the bars from scratch like setNotePositions() does, and stores how long each pass took over all the bars
+	// in microseconds, for \score bench
+	for (int pass = 0; pass < numLayoutPasses; pass++) {
+		uint64_t start = ofGetElapsedTimeMicros();
+		for (auto it = bars.begin(); it != bars.end(); ++it) {
+			notesObj.runLayoutPass(*it, pass, pass == positionsPass);
+		}
+		passDurs[pass] = ofGetElapsedTimeMicros() - start;
 	}
-	for (int i = 0; i < numBars; i++) {
-		notesObj.storeOttavaCoords(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+	for (auto it = bars.begin(); it != bars.end(); ++it) {
+		notesObj.setLayoutClean(*it);
 	}
-	for (int i = 0; i < numBars; i++) {
-		notesObj.storeTextCoords(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+}
+
+//--------------------------------------------------------------
+bool Instrument::layoutDirtyBars(const std::vector<int>& bars)
+{
+	// lay out the bars that are out of date, together with the bars their slurs continue to
+	// which run the slurs pass and the ones after it again, as their slurs depend on the stems of the dirty bars
+	std::set<int> toLayout;
+	for (auto it = bars.begin(); it != bars.end(); ++it) {
+		if (!notesObj.isLayoutDirty(*it)) continue;
+		toLayout.insert(*it);
+		int bar = *it;
+		while (notesObj.getSlurLinks(bar).first && notesObj.hasBar(bar-1) && toLayout.find(bar-1) == toLayout.end()) {
+			toLayout.insert(--bar);
+		}
+		bar = *it;
+		while (notesObj.getSlurLinks(bar).second && notesObj.hasBar(bar+1) && toLayout.find(bar+1) == toLayout.end()) {
+			toLayout.insert(++bar);
+		}
 	}
-	for (int i = 0; i < numBars; i++) {
-		notesObj.storeDynamicsCoords(bar+i);
-		notesObj.storeMinMaxY(bar+i);
+	if (toLayout.empty()) return false;
+	for (auto it = toLayout.begin(); it != toLayout.end(); ++it) {
+		notesObj.invalidateLayout(*it, slursPass);
 	}
+	std::vector<int> v(toLayout.begin(), toLayout.end());
+	setNotePositions(v);
+	return true;
 }
 
 //--------------------------------------------------------------
@@ -733,6 +835,60 @@ void Instrument::setFirstIter(bool iter)
 	firstIter = iter;
 }
 
+//--------------------------------------------------------------
+InstSeqState Instrument::getSeqState()
+{
+	InstSeqState state;
+	state.beatCounter = beatCounter;
+	state.barCounter = barCounter;
+	state.barDataCounter = barDataCounter;
+	state.barDataCounterReset = barDataCounterReset;
+	state.seqToggle = seqToggle;
+	state.noteDur = noteDur;
+	state.timeStamp = timeStamp;
+	state.firstIter = firstIter;
+	state.hasNewStep = hasNewStepBool;
+	state.newStep = newStep;
+	state.updateTempo = updateTempo;
+	state.muteState = muteState;
+	state.toMuteState = toMuteState;
+	state.toUnmuteState = toUnmuteState;
+	state.startGliss = startGliss;
+	state.startDynRamp = startDynRamp;
+	state.loopStart = staff.isLoopStart;
+	state.loopEnd = staff.isLoopEnd;
+	state.scoreEnd = staff.isScoreEnd;
+	state.animate = notesObj.getAnimation();
+	state.activeNote = notesObj.getActiveNote();
+	return state;
+}
+
+//--------------------------------------------------------------
+void Instrument::setSeqState(const InstSeqState& state)
+{
+	beatCounter = state.beatCounter;
+	barCounter = state.barCounter;
+	barDataCounter = state.barDataCounter;
+	barDataCounterReset = state.barDataCounterReset;
+	seqToggle = state.seqToggle;
+	noteDur = state.noteDur;
+	timeStamp = state.timeStamp;
+	firstIter = state.firstIter;
+	hasNewStepBool = state.hasNewStep;
+	newStep = state.newStep;
+	updateTempo = state.updateTempo;
+	setMute(state.muteState);
+	toMuteState = state.toMuteState;
+	toUnmuteState = state.toUnmuteState;
+	startGliss = state.startGliss;
+	startDynRamp = state.startDynRamp;
+	staff.isLoopStart = state.loopStart;
+	staff.isLoopEnd = state.loopEnd;
+	staff.isScoreEnd = state.scoreEnd;
+	notesObj.setAnimation(state.animate);
+	notesObj.setActiveNote(state.activeNote);
+}
+
 //--------------------------------------------------------------
 void Instrument::setToMute(bool mute)
 {
@@ -791,6 +947,12 @@ void Instrument::setTimeStamp(uint64_t stamp)
 	timeStamp = stamp;
 }
 
+//--------------------------------------------------------------
+uint64_t Instrument::getTimeStamp()
+{
+	return timeStamp;
+}
+
 //--------------------------------------------------------------
 void Instrument::resetNoteDur()
 {
@@ -823,6 +985,17 @@ bool Instrument::mustFireStep(uint64_t stamp, int bar, float tempo)
 	return false;
 }
 
+//--------------------------------------------------------------
+bool Instrument::getNextStepTime(int bar, uint64_t& stamp)
+{
+	// the time at which mustFireStep() will next return true, or false if the bar has no more steps
+	if (barDataCounter >= (int)notes[bar].size()) {
+		return false;
+	}
+	stamp = (uint64_t)((int64_t)timeStamp + noteDur + delayTime);
+	return true;
+}
+
 //--------------------------------------------------------------
 void Instrument::setNoteDur(int bar, float tempo)
 {
@@ -1044,9 +1217,33 @@ void Instrument::drawStaff(int bar, float xOffset, float yStartPnt, float yOffse
 }
 
 //--------------------------------------------------------------
-void Instrument::drawNotes(int bar, int loopNdx,  std::vector<int> *v, float xOffset, float yStartPnt, float yOffset, bool animate, float xCoef)
+void Instrument::drawNotes(int bar, int loop, int loopNdx,  std::vector<int> *v, float xOffset, float yStartPnt, float yOffset, bool animate, float xCoef)
+{
+	notesObj.drawNotes(bar, loop, loopNdx, v, xOffset, yStartPnt, yOffset, animate, xCoef);
+}
+
+//--------------------------------------------------------------
+void Instrument::invalidateLoopNaturalSigns(int loop)
+{
+	notesObj.invalidateLoopNaturalSigns(loop);
+}
+
+//--------------------------------------------------------------
+void Instrument::setCountDrawCalls(bool count)
+{
+	notesObj.setCountDrawCalls(count);
+}
+
+//--------------------------------------------------------------
+unsigned Instrument::getNumDrawCalls()
+{
+	return notesObj.getNumDrawCalls();
+}
+
+//--------------------------------------------------------------
+void Instrument::resetNumDrawCalls()
 {
-	notesObj.drawNotes(bar, loopNdx, v, xOffset, yStartPnt, yOffset, animate, xCoef);
+	notesObj.resetNumDrawCalls();
 }
 
 void Instrument::printVector(std::vector<int> v)
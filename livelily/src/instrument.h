@@ -4,9 +4,38 @@
 #include "ofMain.h"
 #include "ofxOsc.h"
 #include "score.h"
+#include "latencyStats.h"
 #include <vector>
 
 #define MINDUR 256
+#define GLISSGRAIN 20 // default control rate for glissandi in ms
+#define DYNRAMPGRAIN 10 // default control rate for crescendi and diminuendi in ms
+
+// the state the sequencer changes while it plays an instrument, saved before an offline render and restored after it
+struct InstSeqState
+{
+	uint64_t beatCounter;
+	int barCounter;
+	int barDataCounter;
+	bool barDataCounterReset;
+	int seqToggle;
+	int64_t noteDur;
+	uint64_t timeStamp;
+	bool firstIter;
+	bool hasNewStep;
+	int newStep;
+	bool updateTempo;
+	bool muteState;
+	bool toMuteState;
+	bool toUnmuteState;
+	bool startGliss;
+	bool startDynRamp;
+	bool loopStart;
+	bool loopEnd;
+	bool scoreEnd;
+	bool animate;
+	int activeNote;
+};
 
 class Instrument
 {
@@ -25,6 +54,14 @@ class Instrument
 		void setDelay(int64_t dur);
 		bool hasDelay();
 		int64_t getDelayTime();
+		void setGlissRate(int64_t rate);
+		int64_t getGlissRate();
+		void setDynamicsRampStart(bool startRamp);
+		bool getDynamicsRampStart();
+		void setDynamicsRampRate(int64_t rate);
+		int64_t getDynamicsRampRate();
+		void setDynamicsRampOutput(int output);
+		int getDynamicsRampOutput();
 		void setSendMIDI(bool sendMIDI);
 		bool sendMIDI();
 		void setTransposition(int transpo);
@@ -61,7 +98,12 @@ class Instrument
 		void setNoteCoords(float xLen, float staffLineDist, int fontSize);
 		void setAccidentalsOffsetCoef(float coef);
 		void setNotePositions(int bar);
-		void setNotePositions(int bar, int numBars);
+		void setNotePositions(const std::vector<int>& bars);
+		// the layout of a bar is only calculated when it's about to be shown
+		void setLayoutDirty(int bar);
+		bool hasLayoutDirty(const std::vector<int>& bars);
+		bool layoutDirtyBars(const std::vector<int>& bars);
+		void timeLayoutPasses(const std::vector<int>& bars, uint64_t *passDurs);
 		void setScoreOrientation(int orientation);
 		void setStaffColor(ofColor color);
 		void setStaffColor(int color, int rgbVal);
@@ -95,6 +137,8 @@ class Instrument
 		bool isLoopEnd();
 		void initSeqToggle();
 		void setFirstIter(bool iter);
+		InstSeqState getSeqState();
+		void setSeqState(const InstSeqState& state);
 		void setToMute(bool mute);
 		bool isToBeMuted();
 		void setToUnmute(bool unmute);
@@ -104,9 +148,11 @@ class Instrument
 		void setMidi(bool isMidiBool);
 		bool isMidi();
 		void setTimeStamp(uint64_t stamp);
+		uint64_t getTimeStamp();
 		void resetNoteDur();
 		void zeroNoteDur();
 		bool mustFireStep(uint64_t stamp, int bar, float tempo);
+		bool getNextStepTime(int bar, uint64_t& stamp);
 		void setNoteDur(int bar, float tempo);
 		bool isNoteSlurred(int bar, int dataCounter);
 		bool isNoteTied(int bar, int dataCounter);
@@ -139,8 +185,12 @@ class Instrument
 		float getMeterXOffset();
 		void drawStaff(int bar, float xOffset, float yStartPnt, float yOffset, bool drawClef,
 				bool drawMeter, bool drawLoopStartEnd, bool drawTempo);
-		void drawNotes(int bar, int loopNdx, std::vector<int> *v, float xOffset, float yStartPnt,
+		void drawNotes(int bar, int loop, int loopNdx, std::vector<int> *v, float xOffset, float yStartPnt,
 				float yOffset, bool animate, float xCoef);
+		void invalidateLoopNaturalSigns(int loop);
+		void setCountDrawCalls(bool count);
+		unsigned getNumDrawCalls();
+		void resetNumDrawCalls();
 		void printVector(std::vector<int> v);
 		void printVector(std::vector<std::string> v);
 		void printVector(std::vector<float> v);
@@ -198,17 +248,36 @@ class Instrument
 		std::map<int, std::vector<std::string>> scoreTexts;
 
 		// variables for handling glissandi in the sequencer
-		std::vector<float> glissStart;
-		std::vector<float> glissEnd;
-		std::vector<float> glissSteps;
-		std::vector<int> glissNumSteps;
-		int64_t glissTimeStamp;
-		int64_t glissStartTimeStamp;
-		int glissCounter;
+		// a glissando is rendered to a table of output values when it starts
+		// with one frame every glissRate ms, each holding one value per voice
+		std::vector<float> glissTable;
+		std::string glissAddress;
+		int glissNumVoices;
+		int glissNumFrames;
+		int glissFrame;
+		int64_t glissStartTimeStamp; // in microseconds, like the time stamps of the steps
 		int64_t glissDurMs;
-		int64_t glissTimeDiff;
 		bool startGliss;
 
+		// variables for streaming crescendi and diminuendi in the sequencer
+		// the dynamic is interpolated from the start to the end value every dynRampRate ms
+		// the default output is the dynamics OSC address, the amplitude in Python, or CC 11 in MIDI
+		enum dynamicsRampOutputs {dynRampDefault, dynRampCC7, dynRampCC11, dynRampPressure, dynRampOff};
+		float dynRampStartVal;
+		float dynRampEndVal;
+		int64_t dynRampStartTimeStamp; // in microseconds
+		int64_t dynRampDurMs;
+		int dynRampFrame;
+		int dynRampLastMidiVal;
+		bool startDynRamp;
+
+		// bindings to the setFreq() and setAmp() methods of the instrument's Python object
+		int pyoFreqBinding;
+		int pyoAmpBinding;
+
+		// how late the steps of this instrument leave the sequencer, per output, written by the sequencer only
+		LatencyHistogram latency[latencyNumOutputs];
+
 		// score parts OSC handling
 		bool sendToPart;
 		ofxOscSender scorePartSender;
@@ -223,6 +292,9 @@ class Instrument
 		// the boolean below stores the state of the delay
 		bool delayState;
 		int64_t delayTime;
+		int64_t glissRate;
+		int64_t dynRampRate;
+		int dynRampOutput;
 
 		// MIDI stuff
 		int midiPort;
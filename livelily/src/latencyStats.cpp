@@ -0,0 +1,134 @@
+#include "latencyStats.h"
+#include <algorithm>
+#include <limits>
+
+//--------------------------------------------------------------
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+//--------------------------------------------------------------
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& other)
+{
+	reset();
+	add(other);
+}
+
+//--------------------------------------------------------------
+LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other)
+{
+	if (this != &other) {
+		reset();
+		add(other);
+	}
+	return *this;
+}
+
+//--------------------------------------------------------------
+int LatencyHistogram::bucketIndex(uint64_t val)
+{
+	if (val < LATENCYSUBBUCKETS) return (int)val;
+	// the position of the highest set bit gives the power of two
+	// and the following LATENCYSUBBUCKETBITS bits give the bucket within it
+	int msb = 63;
+	while (!(val & ((uint64_t)1 << msb))) msb--;
+	if (msb >= LATENCYMAXBITS) return LATENCYNUMBUCKETS - 1;
+	int shift = msb - LATENCYSUBBUCKETBITS;
+	int sub = (int)((val >> shift) & (LATENCYSUBBUCKETS - 1));
+	return ((shift + 1) * LATENCYSUBBUCKETS) + sub;
+}
+
+//--------------------------------------------------------------
+uint64_t LatencyHistogram::bucketValue(int ndx)
+{
+	// the highest value that falls in a bucket
+	if (ndx < LATENCYSUBBUCKETS) return (uint64_t)ndx;
+	int shift = (ndx / LATENCYSUBBUCKETS) - 1;
+	int sub = ndx % LATENCYSUBBUCKETS;
+	return (((uint64_t)(LATENCYSUBBUCKETS + sub + 1)) << shift) - 1;
+}
+
+//--------------------------------------------------------------
+void LatencyHistogram::record(int64_t us)
+{
+	// events sent early are counted as sent on time
+	if (us < 0) us = 0;
+	int ndx = bucketIndex((uint64_t)us);
+	counts[ndx].fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add((uint64_t)us, std::memory_order_relaxed);
+	// there is only one writer, so a load and a store is enough
+	if (us < minVal.load(std::memory_order_relaxed)) minVal.store(us, std::memory_order_relaxed);
+	if (us > maxVal.load(std::memory_order_relaxed)) maxVal.store(us, std::memory_order_relaxed);
+	totalCount.fetch_add(1, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+void LatencyHistogram::reset()
+{
+	for (int i = 0; i < LATENCYNUMBUCKETS; i++) {
+		counts[i].store(0, std::memory_order_relaxed);
+	}
+	sum.store(0, std::memory_order_relaxed);
+	minVal.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+	maxVal.store(0, std::memory_order_relaxed);
+	totalCount.store(0, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+	if (other.getCount() == 0) return;
+	for (int i = 0; i < LATENCYNUMBUCKETS; i++) {
+		counts[i].fetch_add(other.counts[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+	sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	minVal.store(std::min(minVal.load(std::memory_order_relaxed), other.getMin()), std::memory_order_relaxed);
+	maxVal.store(std::max(maxVal.load(std::memory_order_relaxed), other.getMax()), std::memory_order_relaxed);
+	totalCount.fetch_add(other.getCount(), std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+uint64_t LatencyHistogram::getCount() const
+{
+	return totalCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+int64_t LatencyHistogram::getMin() const
+{
+	if (getCount() == 0) return 0;
+	return minVal.load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+int64_t LatencyHistogram::getMax() const
+{
+	return maxVal.load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+double LatencyHistogram::getMean() const
+{
+	uint64_t count = getCount();
+	if (count == 0) return 0;
+	return (double)sum.load(std::memory_order_relaxed) / (double)count;
+}
+
+//--------------------------------------------------------------
+int64_t LatencyHistogram::getPercentile(double percentile) const
+{
+	// percentile is in the range 0-100, the result is the upper bound of the bucket it falls in
+	uint64_t count = getCount();
+	if (count == 0) return 0;
+	uint64_t target = (uint64_t)((percentile / 100.0) * (double)count + 0.5);
+	if (target < 1) target = 1;
+	uint64_t accum = 0;
+	for (int i = 0; i < LATENCYNUMBUCKETS; i++) {
+		accum += counts[i].load(std::memory_order_relaxed);
+		if (accum >= target) {
+			return std::min((int64_t)bucketValue(i), getMax());
+		}
+	}
+	return getMax();
+}
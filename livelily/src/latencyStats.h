@@ -0,0 +1,47 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <atomic>
+#include <cstdint>
+
+#define LATENCYSUBBUCKETBITS 4 // 16 buckets per power of two, about 6% precision
+#define LATENCYSUBBUCKETS (1 << LATENCYSUBBUCKETBITS)
+#define LATENCYMAXBITS 24 // values up to 2^24 microseconds (about 16 seconds), larger ones go to the last bucket
+#define LATENCYNUMBUCKETS ((LATENCYMAXBITS - LATENCYSUBBUCKETBITS + 1) * LATENCYSUBBUCKETS)
+
+// the outputs the sequencer measures separately
+enum latencyOutputs {latencyOsc, latencyMidi, latencyPyo, latencyNumOutputs};
+
+// log-linear histogram of the lateness of events in microseconds, in the spirit of HdrHistogram
+// values below LATENCYSUBBUCKETS are stored exactly, and above that every power of two
+// is split in LATENCYSUBBUCKETS buckets, so the relative error is the same across the range
+// the sequencer thread is the only writer, any other thread may read while it writes
+// readings taken while recording might be off by the values recorded in the meantime
+class LatencyHistogram
+{
+	public:
+		LatencyHistogram();
+		// atomics can't be copied, but the Instrument objects that hold histograms are
+		LatencyHistogram(const LatencyHistogram& other);
+		LatencyHistogram& operator=(const LatencyHistogram& other);
+		void record(int64_t us);
+		void reset();
+		void add(const LatencyHistogram& other);
+		uint64_t getCount() const;
+		int64_t getMin() const;
+		int64_t getMax() const;
+		double getMean() const;
+		int64_t getPercentile(double percentile) const;
+
+	private:
+		static int bucketIndex(uint64_t val);
+		static uint64_t bucketValue(int ndx);
+
+		std::atomic<uint32_t> counts[LATENCYNUMBUCKETS];
+		std::atomic<uint64_t> totalCount;
+		std::atomic<uint64_t> sum;
+		std::atomic<int64_t> minVal;
+		std::atomic<int64_t> maxVal;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <pthread.h>
+#include <atomic>
 
 
 #if !defined(_WIN32)
@@ -472,6 +473,7 @@ INLINE int pyo_exec_file(PyThreadState *interp, const char *file, char *msg, int
 
 typedef struct MsgNode {
     char *msg;
+    unsigned long thread; /* the Python thread that wrote the message */
     struct MsgNode *next;
 } MsgNode;
 
@@ -487,6 +489,7 @@ static void pyo_enqueue_stdout(const char *s) {
     if (!node) return;
 
     node->msg = strdup(s);  /* copy string */
+    node->thread = PyThread_get_thread_ident();  /* called with the GIL held */
     node->next = NULL;
 
     pthread_mutex_lock(&g_msg_mutex);
@@ -517,6 +520,32 @@ INLINE int pyo_dequeue_stdout(char **out_msg) {
     return 1;
 }
 
+/* Poll the first message written by the thread "thread" if "match" is 1, */
+/* or the first message written by any other thread if "match" is 0 */
+/* so the output of code running in different threads is kept apart */
+/* Returns 1 if a message was dequeued, 0 otherwise */
+INLINE int pyo_dequeue_stdout_of(unsigned long thread, int match, char **out_msg) {
+    pthread_mutex_lock(&g_msg_mutex);
+    MsgNode *prev = NULL;
+    MsgNode *node = g_msg_head;
+    while (node && ((node->thread == thread) != (match != 0))) {
+        prev = node;
+        node = node->next;
+    }
+    if (!node) {
+        pthread_mutex_unlock(&g_msg_mutex);
+        return 0;
+    }
+    if (prev) prev->next = node->next;
+    else g_msg_head = node->next;
+    if (g_msg_tail == node) g_msg_tail = prev;
+    pthread_mutex_unlock(&g_msg_mutex);
+
+    *out_msg = node->msg;  /* transfer ownership */
+    free(node);
+    return 1;
+}
+
 /* --------- cstdout module hooks ---------- */
 static PyObject* cstdout_write(PyObject *self, PyObject *args) {
     const char *s;
@@ -596,7 +625,8 @@ static inline void redirect_stdout_to_c(void) {
 ** returns 0 (no error) or 1 (bad code in file).
 */
 INLINE int pyo_exec_statement(PyThreadState *interp, char *msg, int debug) {
-    static long input_counter = 0;  /* REPL-style line counter */
+    /* REPL-style line counter, shared by the threads that execute statements */
+    static std::atomic<long> input_counter(0);
 
     int err = 0;
 
@@ -612,7 +642,7 @@ INLINE int pyo_exec_statement(PyThreadState *interp, char *msg, int debug) {
     PyEval_AcquireThread(interp);
 
     char filename[64];
-    snprintf(filename, sizeof(filename), "<python-input-%ld>", input_counter++);
+    snprintf(filename, sizeof(filename), "<python-input-%ld>", input_counter.fetch_add(1));
 
     PyObject *codeObj = Py_CompileString(msg, filename, Py_file_input);
     if (codeObj == NULL) {
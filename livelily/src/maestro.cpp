@@ -0,0 +1,150 @@
+#include "maestro.h"
+#include <cmath>
+#include <algorithm>
+
+//--------------------------------------------------------------
+Maestro::Maestro()
+{
+	minThresh = 7.5;
+	sensitivity = MAESTROSENSITIVITY;
+	resetRequested = false;
+	clear();
+}
+
+//--------------------------------------------------------------
+void Maestro::setThreshold(float thresh)
+{
+	minThresh = thresh;
+}
+
+//--------------------------------------------------------------
+void Maestro::setSensitivity(float sens)
+{
+	sensitivity = sens;
+}
+
+//--------------------------------------------------------------
+void Maestro::reset()
+{
+	resetRequested = true;
+}
+
+//--------------------------------------------------------------
+void Maestro::clear()
+{
+	for (int i = 0; i < MAESTROBUFFSIZE; i++) {
+		frames[i] = 0;
+	}
+	frameNdx = 0;
+	numFrames = 0;
+	sum = 0;
+	sumSq = 0;
+	prevVal = 0;
+	prevPrevVal = 0;
+	prevTimeStamp = 0;
+	beatTimeStamp = 0;
+	beatDetected = false;
+	numBeats = 1;
+	periodMs = 500;
+	periodVariance = MAESTROMEASURENOISE * 10;
+	tempoEstimated = false;
+}
+
+//--------------------------------------------------------------
+bool Maestro::process(float val, uint64_t timeStamp)
+{
+	// the frame before the current one is a peak if it is a local maximum
+	// that crosses both the user threshold and the adaptive threshold of the recent frames
+	if (resetRequested.exchange(false)) clear();
+	bool isBeat = false;
+	if (numFrames > 1 && prevVal > prevPrevVal && prevVal >= val && prevVal > minThresh) {
+		float mean = (float)(sum / numFrames);
+		float variance = (float)(sumSq / numFrames) - (mean * mean);
+		float stdDev = (variance > 0 ? sqrt(variance) : 0);
+		if (prevVal > mean + (sensitivity * stdDev)) {
+			// ignore peaks that are too close to the previous beat, to avoid double triggering
+			float refractoryMs = std::max((float)MAESTROMINPERIOD / 2.0f, periodMs * (float)MAESTROREFRACTORY);
+			if (!beatDetected || (float)(prevTimeStamp - beatTimeStamp) / 1000.0 > refractoryMs) {
+				numBeats = 1;
+				if (beatDetected) numBeats = updateTempo((float)(prevTimeStamp - beatTimeStamp) / 1000.0);
+				beatTimeStamp = prevTimeStamp;
+				beatDetected = true;
+				isBeat = true;
+			}
+		}
+	}
+	// store the current frame in the ring buffer and update the running sums
+	float oldest = frames[frameNdx];
+	if (numFrames == MAESTROBUFFSIZE) {
+		sum -= oldest;
+		sumSq -= oldest * oldest;
+	}
+	else {
+		numFrames++;
+	}
+	frames[frameNdx] = val;
+	sum += val;
+	sumSq += val * val;
+	frameNdx = (frameNdx + 1) % MAESTROBUFFSIZE;
+	prevPrevVal = prevVal;
+	prevVal = val;
+	prevTimeStamp = timeStamp;
+	return isBeat;
+}
+
+//--------------------------------------------------------------
+int Maestro::updateTempo(float intervalMs)
+{
+	// returns the number of beats the interval spans
+	if (intervalMs < MAESTROMINPERIOD || intervalMs > MAESTROMAXPERIOD) return 1;
+	if (!tempoEstimated) {
+		periodMs = intervalMs;
+		periodVariance = MAESTROMEASURENOISE;
+		tempoEstimated = true;
+		return 1;
+	}
+	// a missed beat results in an interval of roughly twice the period
+	// in which case we use half of it instead of treating it as a sudden tempo change
+	int beats = 1;
+	float ratio = intervalMs / periodMs;
+	if (ratio > 1.75 && ratio < 2.25) {
+		intervalMs /= 2.0;
+		beats = 2;
+	}
+	// predict, then correct with the measured interval
+	periodVariance += MAESTROPROCESSNOISE;
+	float gain = periodVariance / (periodVariance + MAESTROMEASURENOISE);
+	periodMs += gain * (intervalMs - periodMs);
+	periodVariance *= (1.0 - gain);
+	return beats;
+}
+
+//--------------------------------------------------------------
+bool Maestro::hasTempo()
+{
+	return tempoEstimated;
+}
+
+//--------------------------------------------------------------
+float Maestro::getBPM()
+{
+	return 60000.0 / periodMs;
+}
+
+//--------------------------------------------------------------
+float Maestro::getPeriodMs()
+{
+	return periodMs;
+}
+
+//--------------------------------------------------------------
+uint64_t Maestro::getBeatTimeStamp()
+{
+	return beatTimeStamp;
+}
+
+//--------------------------------------------------------------
+int Maestro::getNumBeats()
+{
+	return numBeats;
+}
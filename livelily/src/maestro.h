@@ -0,0 +1,61 @@
+#ifndef MAESTRO_H
+#define MAESTRO_H
+
+#include <cstdint>
+#include <atomic>
+
+#define MAESTROBUFFSIZE 64 // number of accelerometer frames used for the adaptive threshold
+#define MAESTROSENSITIVITY 1.5 // standard deviations above the mean a peak must reach to be a beat
+#define MAESTROREFRACTORY 0.4 // minimum time between beats, as a ratio of the estimated beat period
+#define MAESTROMINPERIOD 200 // in milliseconds, 300 BPM
+#define MAESTROMAXPERIOD 3000 // in milliseconds, 20 BPM
+#define MAESTROPROCESSNOISE 50.0 // Kalman filter process noise, how fast the conductor may change the tempo
+#define MAESTROMEASURENOISE 400.0 // Kalman filter measurement noise, how much conducted beats jitter
+
+// streaming beat tracker for a conductor controlling LiveLily with an accelerometer
+// every incoming frame is fed to process(), which picks peaks that cross an adaptive threshold
+// and the inter-beat intervals are smoothed with a one-dimensional Kalman filter
+// process() and the getters are called from the OSC receiving thread
+// the setters and reset() may be called from any thread, and take effect on the next call to process()
+class Maestro
+{
+	public:
+		Maestro();
+		void setThreshold(float thresh);
+		void setSensitivity(float sens);
+		void reset();
+		bool process(float val, uint64_t timeStamp);
+		bool hasTempo();
+		float getBPM();
+		float getPeriodMs();
+		uint64_t getBeatTimeStamp();
+		int getNumBeats();
+
+	private:
+		void clear();
+		int updateTempo(float intervalMs);
+
+		// ring buffer of the last frames with running sums for the mean and variance
+		float frames[MAESTROBUFFSIZE];
+		int frameNdx;
+		int numFrames;
+		double sum;
+		double sumSq;
+		// the last two frames, since a peak is detected one frame after it occurs
+		float prevVal;
+		float prevPrevVal;
+		uint64_t prevTimeStamp;
+		// the minimum threshold is set by the user, the adaptive one is derived from the buffer
+		std::atomic<float> minThresh;
+		std::atomic<float> sensitivity;
+		std::atomic<bool> resetRequested;
+		uint64_t beatTimeStamp; // in microseconds
+		bool beatDetected;
+		int numBeats; // beats counted by the last detected beat, more than one if beats were missed before it
+		// Kalman filter state, the estimated beat period in ms and its variance
+		float periodMs;
+		float periodVariance;
+		bool tempoEstimated;
+};
+
+#endif
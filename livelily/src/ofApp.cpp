@@ -6,6 +6,7 @@
 #include <cmath> // to add abs()
 #include <utility> // to add pair and make_pair
 #include <sstream> // to create a string from vector<string>
+#include <thread> // to lay out the score of each instrument in parallel
 
 /**************************************************************/
 /********************* Main OF class **************************/
@@ -26,6 +27,10 @@ void ofApp::setup()
 	unsigned int framerate = 60;
 
 	sequencer.setup(&sharedData);
+	tracePlayer.setup(HOST, OFSENDPORT, &sequencer.midiOut, &sequencer.midiOuts);
+#ifdef USEPYO
+	tracePlayer.setPyo(&sharedData.pyo);
+#endif
 
     // define audio properties
     sampleRate = 48000;
@@ -63,6 +68,7 @@ void ofApp::setup()
 
 	//oscReceiver.setup(OSCPORT);
 	oscReceiverIsSet = false;
+	partSyncer.setup();
 	// waiting time to receive a response from a score part server is one frame at 60 FPS
 	scorePartResponseTime = (uint64_t)((1000.0 / 60.0) + 0.5);
 
@@ -141,7 +147,6 @@ void ofApp::setup()
 	sharedData.beatVizTimeStamp = 0;
 	sharedData.beatVizStepsPerMs = (float)BEATVIZBRIGHTNESS / ((float)sharedData.tempoMs[0] / 4.0);
 	sharedData.beatVizRampStart = sharedData.tempoMs[0] / 4;
-	sharedData.beatUpdated = false;
 	sharedData.noteWidth = 0;
 	sharedData.noteHeight = 0;
 	sharedData.allStaffDiffs = 0;
@@ -149,6 +154,10 @@ void ofApp::setup()
 
 	// various score variables
 	scoreOrientation = 0;
+	pianoRollBars = std::make_pair(-1, -1);
+	pianoRollDirty = true;
+	projectionMonitor = projectionWindowMonitor = PROJECTIONCLOSED;
+	scoreFboDirty = true;
 	scoreXOffset = sharedData.screenWidth / 2;
 	scoreYOffset = 0;
 	scoreXStartPnt = 0;
@@ -184,16 +193,22 @@ void ofApp::setup()
 	maestroValNdx = 0;
 	maestroInitialized = false;
 	maestroBeatsIn = 1;
-	maestroValThresh = 7.5;
-	maestroTimeStamp = ofGetElapsedTimeMillis();
+	maestro.setThreshold(7.5);
 	maestroAddress = "/maestro";
 	maestroToggleAddress = "/toggle";
 	maestroLevareAddress = "/levare";
+	setOscRoutes();
+
+	latencyDumpFile = "";
+	latencyDumpInterval = 0;
+	latencyDumpTimeStamp = 0;
 
 	sharedData.pyStdoutStr = "";
 	sharedData.pyStdoutStrNdx = 0;
-	sharedData.typePyStrCharByChar = true;
+	sharedData.typePyStrCharByChar = false;
 	sharedData.typePyStrLineByLine = false;
+	sharedData.typePyStrBulk = true;
+	sharedData.typePyStrAnimRate = 0;
 	sharedData.typePyStr = false;
 	sharedData.whichPyPane = 0;
 	sharedData.pyStdoutKeyModNdx = 0;
@@ -314,7 +329,9 @@ void ofApp::setup()
 	commandsMap[livelily]['s']["\\setinaudiodev"] = ofColor::fuchsia;
 	commandsMap[livelily]['s']["\\setoutaudiodev"] = ofColor::fuchsia;
 	commandsMap[livelily]['s']["\\samplerate"] = ofColor::fuchsia;
+	commandsMap[livelily]['s']["\\stats"] = ofColor::fuchsia;
 	commandsMap[livelily]['t']["\\tempo"] = ofColor::fuchsia;
+	commandsMap[livelily]['t']["\\trace"] = ofColor::fuchsia;
 	commandsMap[livelily]['t']["\\tenuto"] = ofColor::fuchsia;
 	commandsMap[livelily]['t']["\\time"] = ofColor::fuchsia;
 	commandsMap[livelily]['t']["\\tuplet"] = ofColor::fuchsia;
@@ -331,13 +348,18 @@ void ofApp::setup()
 	commandsMap[livelily]['b']["bind"] = ofColor::violet;
 	commandsMap[livelily]['b']["beattype"] = ofColor::violet;
 	commandsMap[livelily]['b']["beatsin"] = ofColor::violet;
+	commandsMap[livelily]['b']["bench"] = ofColor::violet;
 	commandsMap[livelily]['c']["clear"] = ofColor::violet;
 	commandsMap[livelily]['c']["colors"] = ofColor::violet;
 	commandsMap[livelily]['c']["cursor"] = ofColor::violet;
 	commandsMap[livelily]['c']["correct"] = ofColor::violet;
+	commandsMap[livelily]['c']["cancel"] = ofColor::violet;
 	commandsMap[livelily]['d']["delay"] = ofColor::violet;
+	commandsMap[livelily]['d']["dynramp"] = ofColor::violet;
+	commandsMap[livelily]['d']["dynrate"] = ofColor::violet;
 	commandsMap[livelily]['f']["fullscreen"] = ofColor::violet;
 	commandsMap[livelily]['g']["goto"] = ofColor::violet;
+	commandsMap[livelily]['g']["glissrate"] = ofColor::violet;
 	commandsMap[livelily]['h']["hide"] = ofColor::violet;
 	commandsMap[livelily]['i']["inanimate"] = ofColor::violet;
 	commandsMap[livelily]['i']["init"] = ofColor::violet;
@@ -351,8 +373,11 @@ void ofApp::setup()
 	commandsMap[livelily]['n']["numbars"] = ofColor::violet;
 	commandsMap[livelily]['o']["onrelease"] = ofColor::violet;
 	commandsMap[livelily]['p']["play"] = ofColor::violet;
+	commandsMap[livelily]['p']["project"] = ofColor::violet;
 	commandsMap[livelily]['r']["release"] = ofColor::violet;
 	commandsMap[livelily]['r']["recenter"] = ofColor::violet;
+	commandsMap[livelily]['r']["record"] = ofColor::violet;
+	commandsMap[livelily]['r']["render"] = ofColor::violet;
 	commandsMap[livelily]['s']["stop"] =  ofColor::violet;
 	commandsMap[livelily]['s']["stopnow"] =  ofColor::violet;
 	commandsMap[livelily]['s']["sendmidi"] = ofColor::violet;
@@ -362,6 +387,7 @@ void ofApp::setup()
 	commandsMap[livelily]['s']["sendto"] = ofColor::violet;
 	commandsMap[livelily]['s']["show"] = ofColor::violet;
 	commandsMap[livelily]['s']["showbeat"] = ofColor::violet;
+	commandsMap[livelily]['s']["sensitivity"] = ofColor::violet;
 	commandsMap[livelily]['t']["traverse"] = ofColor::violet;
 	commandsMap[livelily]['t']["transpose"] = ofColor::violet;
 	commandsMap[livelily]['t']["toggleaddr"] = ofColor::violet;
@@ -378,6 +404,7 @@ void ofApp::setup()
 	commandsMap[livelily]['b']["beat"] = ofColor::skyBlue;
 	commandsMap[livelily]['b']["bass"] = ofColor::skyBlue;
 	commandsMap[livelily]['b']["barstart"] = ofColor::skyBlue;
+	commandsMap[livelily]['b']["bulk"] = ofColor::skyBlue;
 	commandsMap[livelily]['c']["char"] = ofColor::skyBlue;
 	commandsMap[livelily]['f']["framerate"] = ofColor::skyBlue;
 	commandsMap[livelily]['f']["fr"] = ofColor::skyBlue;
@@ -396,6 +423,7 @@ void ofApp::setup()
 	commandsMap[livelily]['p']["pianoroll"] = ofColor::skyBlue;
 	commandsMap[livelily]['r']["reset"] = ofColor::skyBlue;
 	commandsMap[livelily]['s']["scope"] = ofColor::skyBlue;
+	commandsMap[livelily]['s']["save"] = ofColor::skyBlue;
 	commandsMap[livelily]['t']["treble"] = ofColor::skyBlue;
 	commandsMap[livelily]['t']["tempo"] = ofColor::skyBlue;
 
@@ -1134,148 +1162,43 @@ void ofApp::setup()
 //--------------------------------------------------------------
 void ofApp::update()
 {
-    // check for OSC messages
-	static float prevVal = 0;
-	while (oscReceiver.hasWaitingMessages()) {
-		ofxOscMessage m;
-		oscReceiver.getNextMessage(m);
-		std::string address = m.getAddress();
-		if (address == maestroAddress) {
-			if (!sequencer.isThreadRunning() && sharedData.setBeatAnimation) {
-				sharedData.beatAnimate = true;
-				sharedData.setBeatAnimation = false;
-			}
-			float val = m.getArgAsFloat(maestroValNdx);
-			if (receivingMaestro) {
-				if (val > maestroValThresh) {
-					if (!sharedData.beatUpdated && ofGetElapsedTimeMillis() - maestroTimeStamp > MAESTROTHRESH) {
-						if (maestroInitialized) {
-							int bar = getPlayingBarIndex();
-							sharedData.beatCounter++;
-							if (sharedData.beatCounter >= sharedData.numerator[bar]) {
-								sharedData.beatCounter = 0;
-								sharedData.thisBarIndex++;
-								if (sharedData.thisBarIndex >= sharedData.loopData[sharedData.loopIndex].size()) {
-									sharedData.thisBarIndex = 0;
-								}
-								bar = getPlayingBarIndex();
-							}
-							sharedData.BPMTempi[bar] = msToBPM(ofGetElapsedTimeMillis() - maestroTimeStamp);
-							sendBeatVizInfo(bar);
-						}
-						else {
-							maestroInitialized = true;
-						}
-						sharedData.beatUpdated = true;
-						maestroTimeStamp = ofGetElapsedTimeMillis();
-						//cout << sharedData.beatCounter << endl;
-						//printVector(maestroVec);
-						float accum = 0;
-						for (auto it = maestroVec.begin(); it != maestroVec.end(); ++it) {
-							accum += *it;
-						}
-						accum /= (float)maestroVec.size();
-						//cout << "accum: " << accum << endl;
-						maestroVec.clear();
-					}
-				}
-				else {
-					sharedData.beatUpdated = false;
-					if (prevVal != 0) {
-						maestroVec.push_back(abs(val - prevVal));
-					}
-					prevVal = val;
-				}
-			}
-		}
-		else if (address == maestroToggleAddress) {
-			if (m.getArgType(0) == OFXOSC_TYPE_INT32) {
-				int val = m.getArgAsInt32(0);
-				if (val) receivingMaestro = true;
-				else receivingMaestro = false;
-			}
-			else if (m.getArgType(0) == OFXOSC_TYPE_FLOAT) {
-				int val = (int)m.getArgAsFloat(0);
-				if (val) receivingMaestro = true;
-				else receivingMaestro = false;
-			}
-			else if (m.getArgType(0) == OFXOSC_TYPE_TRUE || m.getArgType(0) == OFXOSC_TYPE_FALSE) {
-				receivingMaestro = m.getArgAsBool(0);
-			}
-			if (!receivingMaestro) {
-				maestroInitialized = false;
-			}
-			else {
-				parseString("\\score.beatsin " + std::to_string(maestroBeatsIn), 1, 1); // dummy 2nd and 3rd args
-			}
-		}
-		else if (address == maestroLevareAddress) {
-			maestroBeatsIn = m.getArgAsInt32(0);
-		}
-		else {
-			for (std::map<int, std::string>::iterator it = fromOscAddr.begin(); it != fromOscAddr.end(); ++it) {
-				if (address.substr(0, it->second.size()) == it->second) {
-					int whichPaneOsc = it->first;
-					std::map<int, Editor>::iterator editIt = editors.find(whichPaneOsc);
-					if (editIt != editors.end()) {
-						if (m.getArgType(0) == OFXOSC_TYPE_STRING) {
-							std::string oscStr = m.getArgAsString(0);
-							for (unsigned i = 0; i < oscStr.size(); i++) {
-								if (address.find("/press") != std::string::npos) {
-									editIt->second.fromOscPress((int)oscStr.at(i));
-								}
-								else if (address.find("/release") != std::string::npos) {
-									editIt->second.fromOscRelease((int)oscStr.at(i));
-								}
-							}
-						}
-						else if (m.getArgType(0) == OFXOSC_TYPE_INT32) {
-							size_t numArgs = m.getNumArgs();
-							for (size_t j = 0; j < numArgs; j++) {
-								int oscVal = (int)m.getArgAsInt32(j);
-								if (address.find("/press") != std::string::npos) {
-									editIt->second.fromOscPress(oscVal);
-								}
-								else if (address.find("/release") != std::string::npos) {
-									editIt->second.fromOscRelease(oscVal);
-								}
-							}
-						}
-						else if (m.getArgType(0) == OFXOSC_TYPE_INT64) {
-							size_t numArgs = m.getNumArgs();
-							for (size_t j = 0; j < numArgs; j++) {
-								int oscVal = (int)m.getArgAsInt64(j);
-								if (address.find("/press") != std::string::npos) {
-									editIt->second.fromOscPress(oscVal);
-								}
-								else if (address.find("/release") != std::string::npos) {
-									editIt->second.fromOscRelease(oscVal);
-								}
-							}
-						}
-						else if (m.getArgType(0) == OFXOSC_TYPE_FLOAT) {
-							size_t numArgs = m.getNumArgs();
-							for (size_t j = 0; j < numArgs; j++) {
-								int oscVal = (int)m.getArgAsFloat(j);
-								if (address.find("/press") != std::string::npos) {
-									editIt->second.fromOscPress(oscVal);
-								}
-								else if (address.find("/release") != std::string::npos) {
-									editIt->second.fromOscRelease(oscVal);
-								}
-							}
-						}
-						else {
-							cout << "unknown OSC message type\n";
-						}
-					}
-					break;
-				}
-			}
+	// the projection window is opened and closed here, outside of the event that parsed the command
+	if (projectionWindow && projectionMonitor != projectionWindowMonitor) {
+		closeProjectionWindow();
+	}
+	if (!projectionWindow && projectionMonitor != PROJECTIONCLOSED) {
+		openProjectionWindow();
+	}
+    // check for OSC messages queued by the OSC receiving thread
+	TimedOscMessage oscMsg;
+	while (oscReceiver.queue.pop(oscMsg)) {
+		switch (oscMsg.route) {
+			case maestroBeatRoute:
+				maestroBeat(oscMsg.m);
+				break;
+			case maestroToggleRoute:
+				maestroToggleOsc(oscMsg.m);
+				break;
+			case maestroLevareRoute:
+				maestroBeatsIn = oscMsg.m.getArgAsInt32(0);
+				break;
+			case editorPressRoute:
+				editorOsc(oscMsg.m, oscMsg.pane, true);
+				break;
+			case editorReleaseRoute:
+				editorOsc(oscMsg.m, oscMsg.pane, false);
+				break;
+			case syncRoute:
+				requestPartSync(oscMsg.m.getRemoteHost(), oscMsg.m.getArgAsInt32(0));
+				break;
+			case statsRoute:
+				sendLatencyStats(oscMsg.m.getRemoteHost(), oscMsg.m.getArgAsInt32(0));
+				break;
+			default:
+				break;
 		}
 	}
 
-
 	// check if any instrument has a delay for receiving OSC messages
 	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
 		if (it->second.oscFifo.size() > 0) {
@@ -1306,33 +1229,43 @@ void ofApp::update()
 			sequencer.start();
 		}
 	}
+	// the parts that requested a sync and whose instruments are matched get the snapshot of their state
+	PartSyncRequest syncRequest;
+	while (partSyncer.matched.tryReceive(syncRequest)) {
+		syncPart(syncRequest);
+	}
 	
-	if (sharedData.typePyStr && ((sharedData.pyStdoutStrNdx == 0 && !ctrlPressed && !shiftPressed) || sharedData.pyStdoutStrNdx > 0)) {
-		if (sharedData.typePyStrCharByChar) {
-			pyStdoutStrKeyModifier keyMod = checkPyStdoutKeyModifier(sharedData.pyStdoutStrNdx);
-			sharedData.pyStdoutStrNdx += keyMod.ndxInc;
-			if (keyMod.isModifier) {
-				handleKeyModifier(keyMod);
-			}
-			else {
-				int charToType = (int)sharedData.pyStdoutStr[sharedData.pyStdoutStrNdx];
-				if (sharedData.pyStdoutStr[sharedData.pyStdoutStrNdx] == '\n') {
-					charToType = 13;
-				}
-				if (sharedData.whichPyPane == whichPane) {
-					keyPressed(charToType);
-				}
-				else {
-					keyPressedOsc(charToType, sharedData.whichPyPane);
-				}
-				sharedData.pyStdoutStrNdx++;
-			}
-			if (sharedData.pyStdoutStrNdx >= sharedData.pyStdoutStr.size()) {
-				sharedData.pyStdoutStr.clear();
-				sharedData.pyStdoutStrNdx = 0;
-				sharedData.typePyStr = false;
+#ifdef USEPYO
+	// pass the output of the Python interpreter thread to the pane that sent the code
+	if (pyoSet) {
+		PyoResponse pyoResponse;
+		while (sharedData.pyo.poll(pyoResponse)) {
+			for (auto it = editors.begin(); it != editors.end(); ++it) {
+				if (it->second.pyoResponse(pyoResponse.id, pyoResponse.type, pyoResponse.cancelled, pyoResponse.text)) break;
 			}
 		}
+		// stdout that doesn't belong to a request, e.g. printed by a bound method, goes to the console
+		std::vector<std::string> pyStdout = sharedData.pyo.getStdout();
+		for (auto it = pyStdout.begin(); it != pyStdout.end(); ++it) {
+			cout << *it;
+		}
+	}
+#endif
+
+	// the pane a Python string is typed in might have been removed in the meantime
+	if (sharedData.typePyStr && editors.find(sharedData.whichPyPane) == editors.end()) {
+		cout << "pane " << sharedData.whichPyPane+1 << " doesn't exist, dropping Python output" << endl;
+		sharedData.pyStdoutStr.clear();
+		sharedData.pyStdoutStrNdx = 0;
+		sharedData.typePyStr = false;
+	}
+	if (sharedData.typePyStr && ((sharedData.pyStdoutStrNdx == 0 && !ctrlPressed && !shiftPressed) || sharedData.pyStdoutStrNdx > 0)) {
+		if (sharedData.typePyStrBulk) {
+			typePyStdoutBulk();
+		}
+		else if (sharedData.typePyStrCharByChar) {
+			typePyStdoutChar();
+		}
 		else if (sharedData.typePyStrLineByLine) {
 			// check if we have a key modifier at the very beginning
 			if (sharedData.pyStdoutStrVecNdx == 0 && sharedData.pyStdoutKeyModNdxs.size() > 0 && sharedData.pyStdoutStrVecNdx == sharedData.pyStdoutKeyModNdxs[sharedData.pyStdoutKeyModNdx]) {
@@ -1367,7 +1300,7 @@ void ofApp::update()
 			std::vector<pyStdoutStrKeyModifier> keyModifiers;
 			// run through the indexes of the angle brackets and test each one separately for a key modifier
 			for (auto it = angleBracketNdxs.begin(); it != angleBracketNdxs.end(); ++it) {
-				keyModifiers.push_back(checkPyStdoutKeyModifier(*it));
+				keyModifiers.push_back(checkPyStdoutKeyModifier(sharedData.pyStdoutStr, *it));
 				if (keyModifiers.back().isModifier) {
 					hasModifiers = true;
 				}
@@ -1426,24 +1359,149 @@ void ofApp::update()
 	}
 
 	if (sharedData.showScope) {
-		scopeWaveformLeft.clear();
-		scopeWaveformRight.clear();
-		scopeRms = scopeBuffer.getRMSAmplitude();
-		for(size_t i = 0; i < scopeBuffer.getNumFrames(); i++) {
-			float sampleLeft = scopeBuffer.getSample(i, 0);
-			float xLeft = ofMap(i, 0, scopeBuffer.getNumFrames(), scoreXOffset, scoreBackgroundWidth+scoreXOffset);
-			float yLeft = ((sampleLeft * (scoreBackgroundHeight / 2)) * scopeRms) + (scoreBackgroundHeight / 2);
-			float sampleRight = scopeBuffer.getSample(i, 1);
-			float xRight = ofMap(i, 0, scopeBuffer.getNumFrames(), scoreXOffset, scoreBackgroundWidth+scoreXOffset);
-			float yRight = ((sampleRight * (scoreBackgroundHeight / 2)) * scopeRms) + (scoreBackgroundHeight / 2);
-			if (scoreOrientation == 1) {
-				yLeft += scoreYOffset;
-				yRight += scoreYOffset;
+		updateScope();
+	}
+
+	if (latencyDumpInterval > 0 && ofGetElapsedTimeMillis() - latencyDumpTimeStamp >= latencyDumpInterval) {
+		dumpLatencyStats();
+		latencyDumpTimeStamp = ofGetElapsedTimeMillis();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::setOscRoutes()
+{
+	// map every OSC address we listen to, to a route type and a pane index
+	// this is called at setup and whenever one of the addresses changes
+	// so that each incoming message is dispatched with a single lookup
+	std::unordered_map<std::string, std::pair<int, int>> oscRoutes;
+	oscRoutes[maestroAddress] = std::make_pair(maestroRoute, 0);
+	oscRoutes[maestroToggleAddress] = std::make_pair(maestroToggleRoute, 0);
+	oscRoutes[maestroLevareAddress] = std::make_pair(maestroLevareRoute, 0);
+	oscRoutes["/sync"] = std::make_pair(syncRoute, 0);
+	// the OSC receiver is started only by \fromosc, \maestro, or an instrument that is a score part
+	// so /stats queries are answered only after one of these, while \print stats always works
+	oscRoutes["/stats"] = std::make_pair(statsRoute, 0);
+	for (auto it = fromOscAddr.begin(); it != fromOscAddr.end(); ++it) {
+		oscRoutes[it->second + "/press"] = std::make_pair(editorPressRoute, it->first);
+		oscRoutes[it->second + "/release"] = std::make_pair(editorReleaseRoute, it->first);
+	}
+	oscReceiver.setRoutes(oscRoutes);
+}
+
+//--------------------------------------------------------------
+bool ofApp::maestroOsc(ofxOscMessage& m, uint64_t timeStamp, TimedOscMessage& beat)
+{
+	// this is called from the OSC receiving thread, with the arrival time of the message in microseconds
+	// only the beat detection runs here, the beat is passed to update() which owns the score counters
+	// the tempo is passed as the first argument of the beat message, -1 if it's not estimated yet
+	// and the number of beats to count as the second, which includes any beat the tracker inferred as missed
+	if (!receivingMaestro) return false;
+	float val = m.getArgAsFloat(maestroValNdx);
+	if (!maestro.process(val, timeStamp)) return false;
+	beat.m.clear();
+	beat.m.setAddress(m.getAddress());
+	beat.m.addFloatArg(maestro.hasTempo() ? maestro.getBPM() : -1);
+	beat.m.addIntArg(maestro.getNumBeats());
+	beat.timeStamp = maestro.getBeatTimeStamp();
+	beat.route = maestroBeatRoute;
+	beat.pane = -1;
+	return true;
+}
+
+//--------------------------------------------------------------
+void ofApp::maestroBeat(ofxOscMessage& m)
+{
+	scoreFboDirty = true;
+	if (!sequencer.isThreadRunning() && sharedData.setBeatAnimation) {
+		sharedData.beatAnimate = true;
+		sharedData.setBeatAnimation = false;
+	}
+	// the beat might have been queued just before the maestro was turned off
+	if (!receivingMaestro) return;
+	// the first beat only initializes the tracker, counting starts from the next one
+	if (!maestroInitialized) {
+		maestroInitialized = true;
+		return;
+	}
+	int bar = getPlayingBarIndex();
+	for (int i = 0; i < m.getArgAsInt32(1); i++) {
+		sharedData.beatCounter++;
+		if (sharedData.beatCounter >= sharedData.numerator[bar]) {
+			sharedData.beatCounter = 0;
+			sharedData.thisBarIndex++;
+			if (sharedData.thisBarIndex >= sharedData.loopData[sharedData.loopIndex].size()) {
+				sharedData.thisBarIndex = 0;
 			}
-			scopeWaveformLeft.addVertex(xLeft, yLeft);
-			scopeWaveformRight.addVertex(xRight, yRight);
+			bar = getPlayingBarIndex();
+		}
+	}
+	if (m.getArgAsFloat(0) > 0) {
+		sharedData.BPMTempi[bar] = (int)(m.getArgAsFloat(0) + 0.5);
+	}
+	sendBeatVizInfo(bar);
+}
+
+//--------------------------------------------------------------
+void ofApp::maestroToggleOsc(ofxOscMessage& m)
+{
+	if (m.getArgType(0) == OFXOSC_TYPE_INT32) {
+		int val = m.getArgAsInt32(0);
+		if (val) receivingMaestro = true;
+		else receivingMaestro = false;
+	}
+	else if (m.getArgType(0) == OFXOSC_TYPE_FLOAT) {
+		int val = (int)m.getArgAsFloat(0);
+		if (val) receivingMaestro = true;
+		else receivingMaestro = false;
+	}
+	else if (m.getArgType(0) == OFXOSC_TYPE_TRUE || m.getArgType(0) == OFXOSC_TYPE_FALSE) {
+		receivingMaestro = m.getArgAsBool(0);
+	}
+	if (!receivingMaestro) {
+		maestroInitialized = false;
+		maestro.reset();
+	}
+	else {
+		parseString("\\score.beatsin " + std::to_string(maestroBeatsIn), 1, 1); // dummy 2nd and 3rd args
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::editorOsc(ofxOscMessage& m, int pane, bool press)
+{
+	std::map<int, Editor>::iterator editIt = editors.find(pane);
+	if (editIt == editors.end()) return;
+	std::vector<int> keys;
+	if (m.getArgType(0) == OFXOSC_TYPE_STRING) {
+		std::string oscStr = m.getArgAsString(0);
+		for (unsigned i = 0; i < oscStr.size(); i++) {
+			keys.push_back((int)oscStr.at(i));
+		}
+	}
+	else if (m.getArgType(0) == OFXOSC_TYPE_INT32) {
+		for (size_t j = 0; j < m.getNumArgs(); j++) {
+			keys.push_back((int)m.getArgAsInt32(j));
+		}
+	}
+	else if (m.getArgType(0) == OFXOSC_TYPE_INT64) {
+		for (size_t j = 0; j < m.getNumArgs(); j++) {
+			keys.push_back((int)m.getArgAsInt64(j));
+		}
+	}
+	else if (m.getArgType(0) == OFXOSC_TYPE_FLOAT) {
+		for (size_t j = 0; j < m.getNumArgs(); j++) {
+			keys.push_back((int)m.getArgAsFloat(j));
 		}
 	}
+	else {
+		cout << "unknown OSC message type\n";
+		return;
+	}
+	for (int key : keys) {
+		if (press) editIt->second.fromOscPress(key);
+		else editIt->second.fromOscRelease(key);
+	}
 }
 
 /********************* drawing functions ***********************/
@@ -1451,6 +1509,10 @@ void ofApp::update()
 void ofApp::draw()
 {
 	ofSetLineWidth(lineWidth);
+	// the piano roll is drawn before the panes, because it hides the notes outside it under strips of the background
+	if (!sharedData.showNotes && sharedData.showPianoRoll) {
+		drawPianoRoll();
+	}
 	for (std::map<int, Editor>::iterator it = editors.begin(); it != editors.end(); ++it) {
 		it->second.drawText();
 		// draw the pane separator for panes that do not touch the traceback printing area
@@ -1487,13 +1549,22 @@ void ofApp::draw()
 			paneHeight = sharedData.tracebackBase / (float)it->second;
 		}
 	}
-	if (sharedData.showNotes) {
-		drawScore();
+	// when the score is projected, it is drawn once to an FBO, which is then drawn by both windows
+	// it is drawn again only when something the score shows might have changed, even if the main window shows something else
+	if (projectionWindow && (scoreFboDirty || sequencer.isThreadRunning() || sharedData.beatViz)) {
+		drawScoreToFbo();
+		scoreFboDirty = false;
 	}
-	else if (sharedData.showPianoRoll) {
-		drawPianoRoll();
+	if (sharedData.showNotes) {
+		if (projectionWindow) {
+			ofSetColor(255);
+			scoreFbo.draw(scoreXOffset, scoreYOffset);
+		}
+		else {
+			drawScore();
+		}
 	}
-	else if (sharedData.showScope) {
+	else if (sharedData.showScope && !sharedData.showPianoRoll) {
 		drawScope();
 	}
 	// draw the pane separator for panes that do touch the traceback printing area
@@ -1730,6 +1801,21 @@ void ofApp::drawScore()
 		sharedData.numBars = 1;
 	}
 	//--------------- end of horizontal score view variables --------------
+	// lay out the bars about to be shown, and prefetch the ones that follow in the loop
+	// together with the first bars of the loop that is coming up
+	std::vector<int> barsToShow;
+	int loopSize = (int)sharedData.loopData[sharedData.loopIndex].size();
+	for (int i = 0; i < std::min(sharedData.numBars + LAYOUTLOOKAHEAD, loopSize); i++) {
+		barsToShow.push_back(sharedData.loopData[sharedData.loopIndex][(ndx + i) % loopSize]);
+	}
+	if (sharedData.tempLoopIndex != sharedData.loopIndex && sharedData.loopData.find(sharedData.tempLoopIndex) != sharedData.loopData.end()) {
+		std::vector<int>& nextLoop = sharedData.loopData[sharedData.tempLoopIndex];
+		for (int i = 0; i < std::min(sharedData.numBars, (int)nextLoop.size()); i++) {
+			barsToShow.push_back(nextLoop[i]);
+		}
+	}
+	layoutBars(barsToShow);
+	scoreBatch.clear();
 	//---------------- variables for the beat visualization ---------------
 	float beatPulseStartX = 0, beatPulseEndX = 0, noteSize, beatPulseSizeX;
 	float beatPulsePosX = 0;
@@ -1978,7 +2064,7 @@ void ofApp::drawScore()
 				bool drawTempoLocal = (showTempo && drawTempo ? true : false);
 				if (showBar) {
 					it->second.drawStaff(bar, staffOffsetX, yStartPnt, scoreYOffset, drawClef, drawMeter, drawLoopStartEnd, drawTempoLocal);
-					it->second.drawNotes(bar, i, &sharedData.loopData[insertNaturalsNdx], notesOffsetX, yStartPnt, scoreYOffset, animate, notesXCoef);
+					it->second.drawNotes(bar, insertNaturalsNdx, i, &sharedData.loopData[insertNaturalsNdx], notesOffsetX, yStartPnt, scoreYOffset, animate, notesXCoef);
 				}
 				yStartPnt += (sharedData.allStaffDiffs + (sharedData.staffLinesDist * 2));
 				j++;
@@ -1993,6 +2079,7 @@ void ofApp::drawScore()
 			//prevNotesOffsetX = notesOffsetX;
 			//prevBar = bar;
 		}
+		scoreBatch.draw();
 	}
 	// once done drawing the score, draw the line that separates it from the editor
 	// this is important in case of changing the color of the score, to clearly separate the two
@@ -2014,6 +2101,76 @@ void ofApp::drawScore()
 	}
 }
 
+//--------------------------------------------------------------
+void ofApp::drawScoreToFbo()
+{
+	// the FBO has the size of the score area of the main window, so the layout of the score is the same in both windows
+	if (!scoreFbo.isAllocated() || (int)scoreFbo.getWidth() != (int)scoreBackgroundWidth || (int)scoreFbo.getHeight() != (int)scoreBackgroundHeight) {
+		scoreFbo.allocate((int)scoreBackgroundWidth, (int)scoreBackgroundHeight, GL_RGBA, PROJECTIONNUMSAMPLES);
+	}
+	scoreFbo.begin();
+	ofClear(scoreBackgroundColor * brightnessCoeff);
+	ofPushMatrix();
+	ofTranslate(-scoreXOffset, -scoreYOffset);
+	drawScore();
+	ofPopMatrix();
+	scoreFbo.end();
+}
+
+//--------------------------------------------------------------
+void ofApp::drawProjection()
+{
+	ofBackground(scoreBackgroundColor * brightnessCoeff);
+	if (!scoreFbo.isAllocated() || scoreFbo.getWidth() == 0 || scoreFbo.getHeight() == 0) return;
+	// fit the score in the window, keeping its proportions
+	float scale = std::min((float)ofGetWidth() / scoreFbo.getWidth(), (float)ofGetHeight() / scoreFbo.getHeight());
+	float width = scoreFbo.getWidth() * scale;
+	float height = scoreFbo.getHeight() * scale;
+	ofSetColor(255);
+	scoreFbo.draw((ofGetWidth() - width) / 2, (ofGetHeight() - height) / 2, width, height);
+}
+
+//--------------------------------------------------------------
+void ofApp::openProjectionWindow()
+{
+	std::shared_ptr<ofAppBaseWindow> mainWindow = ofGetCurrentWindow();
+	ofGLFWWindowSettings settings;
+	settings.setSize((int)scoreBackgroundWidth, (int)scoreBackgroundHeight);
+	settings.title = "LiveLily score";
+	// the context is shared so that the projection window can draw the texture of the FBO
+	settings.shareContextWith = mainWindow;
+	if (projectionMonitor != PROJECTIONWINDOWED) {
+		settings.monitor = projectionMonitor;
+		settings.windowMode = OF_FULLSCREEN;
+	}
+	projectionWindow = ofCreateWindow(settings);
+	projectionWindowMonitor = projectionMonitor;
+	projectionListeners.push(projectionWindow->events().draw.newListener([this](ofEventArgs&) { drawProjection(); }));
+	projectionListeners.push(projectionWindow->events().exit.newListener([this](ofEventArgs&) { projectionWindowClosed(); }));
+	scoreFboDirty = true;
+	// creating a window makes its context current, but the main window hasn't been drawn yet in this frame
+	mainWindow->makeCurrent();
+	ofGetMainLoop()->setCurrentWindow(mainWindow);
+}
+
+//--------------------------------------------------------------
+void ofApp::closeProjectionWindow()
+{
+	projectionListeners.unsubscribeAll();
+	// the main loop closes the window on its next iteration
+	projectionWindow->setWindowShouldClose();
+	projectionWindow.reset();
+}
+
+//--------------------------------------------------------------
+void ofApp::projectionWindowClosed()
+{
+	// the window was closed from its title bar, and the main loop is already closing it
+	projectionListeners.unsubscribeAll();
+	projectionWindow.reset();
+	projectionMonitor = PROJECTIONCLOSED;
+}
+
 //--------------------------------------------------------------
 void ofApp::drawPianoRoll()
 {
@@ -2021,49 +2178,9 @@ void ofApp::drawPianoRoll()
 	// draw the background of the piano roll
 	ofSetColor(backgroundColor * brightnessCoeff);
 	ofDrawRectangle(scoreXOffset, scoreYOffset, scoreBackgroundWidth, scoreBackgroundHeight);
-	// draw a white rectangle that will be the white keys of the piano
-	ofSetColor(ofColor::white * brightnessCoeff);
-	if (scoreOrientation == 0) {
-		ofDrawRectangle(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
-				scoreYOffset,
-				sharedData.pianoRollKeysWidth,
-				scoreBackgroundHeight);
-	}
-	else {
-		ofDrawRectangle(0,
-				scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight,
-				scoreBackgroundWidth,
-				sharedData.pianoRollKeysHeight);
-	}
-	// then draw the black keys
-	ofSetColor(0);
-	for (int i = 0; i < sharedData.pianoRollNumWhiteKeys; i++) {
-		int iMod = i % 7;
-		if (scoreOrientation == 0) {
-			if (iMod != 0 && iMod != 4 && i < sharedData.pianoRollNumWhiteKeys - 1) {
-				ofDrawRectangle(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
-						scoreYOffset+((i+1)*sharedData.pianoRollKeysHeight)-(sharedData.pianoRollKeysHeight/3),
-						(sharedData.pianoRollKeysWidth/3)*2,
-						(sharedData.pianoRollKeysHeight/3)*2);
-			}
-		}
-		else {
-			if (iMod != 1 && iMod != 4 && i < sharedData.pianoRollNumWhiteKeys - 1) {
-				ofDrawRectangle(scoreXOffset+((i+1)*sharedData.pianoRollKeysWidth)-(sharedData.pianoRollKeysWidth/3),
-						scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight,
-						(sharedData.pianoRollKeysWidth/3)*2,
-						(sharedData.pianoRollKeysHeight/3)*2);
-			}
-		}
-	}
-	// if the background of the editor is white, draw a black line to separate the clavier from the background
-	if (backgroundColor == ofColor::white) {
-		ofDrawLine(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
-				scoreYOffset,
-				scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
-				scoreYOffset+scoreBackgroundHeight);
-	}
-	// then draw the notes of all instruments
+	// the keys are kept in meshes that are only rebuilt when the sizes change
+	if (pianoRollDirty) buildPianoRollKeys();
+	// first draw the notes of all instruments
 	if (sharedData.instruments.size() > 0 && sharedData.loopData.size() > 0) {
 		uint64_t timeStamp = ofGetElapsedTimeMillis();
 		// the movement of the notes depends on the tempo of the currently playing bar
@@ -2072,6 +2189,7 @@ void ofApp::drawPianoRoll()
 		// but as the notes roll, we start showing the next bar too
 		// so we need two bars (or the same bar twice, in case of a single-bar loop)
 		// hence the two iteration loop below
+		std::pair<int, int> bars;
 		for (int i = 0; i < 2; i++) {
 			int bar = sharedData.loopData[sharedData.loopIndex][sharedData.thisBarIndex];
 			if (mustUpdateScore && sharedData.thisBarIndex == sharedData.loopData[sharedData.loopIndex].size()-1 && i > 0) {
@@ -2092,216 +2210,284 @@ void ofApp::drawPianoRoll()
 						bar = sharedData.loopData[sharedData.loopIndex][sharedData.thisBarIndex+1];
 					}
 				}
+				bars.second = bar;
 			}
-			for (auto instIt = sharedData.instruments.begin(); instIt != sharedData.instruments.end(); ++instIt) {
-				ofSetColor(instIt->second.getColor() * brightnessCoeff);
-				float posAccum = 0;
-				// safety test to ensure the bar we're trying to display actually exists
-				if (instIt->second.notes.find(bar) == instIt->second.notes.end()) {
+			else {
+				bars.first = bar;
+			}
+		}
+		if (pianoRollDirty || bars != pianoRollBars) {
+			pianoRollBars = bars;
+			buildPianoRollNotes();
+			pianoRollDirty = false;
+		}
+		float rollLength = (scoreOrientation == 0 ? scoreBackgroundWidth - sharedData.pianoRollKeysWidth : scoreBackgroundHeight - sharedData.pianoRollKeysHeight);
+		float scroll = 0;
+		if (sequencer.isThreadRunning()) {
+			// advance the notes according to elapsed time since the start of the bar
+			scroll = (rollLength * (timeStamp - sharedData.pianoRollTimeStamp)) / (sharedData.tempoMs[thisBar] * sharedData.numerator[thisBar]);
+		}
+		ofPushMatrix();
+		if (scoreOrientation == 0) ofTranslate(scroll, 0);
+		else ofTranslate(0, scroll);
+		pianoRollNotes.draw();
+		ofPopMatrix();
+		// the notes that haven't rolled in yet, and those that have rolled past the clavier
+		// are hidden under strips of the window background at both sides of the piano roll
+		// the panes are drawn after this, so the strips don't cover their text
+		ofSetColor(backgroundColor * brightnessCoeff);
+		if (scoreOrientation == 0) {
+			ofDrawRectangle(scoreXOffset - rollLength, scoreYOffset, rollLength, scoreBackgroundHeight);
+			ofDrawRectangle(scoreXOffset + scoreBackgroundWidth, scoreYOffset, rollLength, scoreBackgroundHeight);
+		}
+		else {
+			ofDrawRectangle(scoreXOffset, scoreYOffset - rollLength, scoreBackgroundWidth, rollLength);
+			ofDrawRectangle(scoreXOffset, scoreYOffset + scoreBackgroundHeight, scoreBackgroundWidth, rollLength);
+		}
+	}
+	// the clavier is drawn over the notes that have reached it
+	pianoRollKeys.draw();
+	if (sharedData.instruments.size() > 0 && sharedData.loopData.size() > 0) {
+		// highlight the active notes on the clavier
+		if (sequencer.isThreadRunning()) {
+			for (auto it = pianoRollHighlights.begin(); it != pianoRollHighlights.end(); ++it) {
+				if (!sharedData.instruments[it->inst].getSeqToggle() || it->noteNdx != sharedData.instruments[it->inst].getBarDataCounter()) {
 					continue;
 				}
-				for (size_t j = 0; j < instIt->second.notes.at(bar).size(); j++) {
-					float noteWidthHeight = (float)instIt->second.durs.at(bar).at(j) * sharedData.pianoRollMinDur;
-					float durPercentage = instIt->second.durPercentages[instIt->second.articulations[bar][j][0]];
-					std::vector<std::pair<float, float>> vp;
-					for (size_t k = 0; k < instIt->second.notes.at(bar).at(j).size(); k++) {
-						int note = (int)instIt->second.notes.at(bar).at(j).at(k);
-						if (note == -1) continue; // -1 is rest
-						int octave = (note / 12) - 1;
-						int oneOctaveNote = note % 12;
-						if (oneOctaveNote < 9) octave--; // since we start from A, we must subtract one octave for all notes below A
-						if (note >= LOWESTKEY && note <= HIGHESTKEY) {
-							float xPos;
-							float yPos;
-							if (scoreOrientation == 0) {
-								xPos = scoreXOffset + scoreBackgroundWidth - sharedData.pianoRollKeysWidth - posAccum - noteWidthHeight;
-								// add the ADSR release trigger part to the X position, as this part is removed from the rectangle width
-								xPos += (noteWidthHeight * (1 - durPercentage));
-								if (sequencer.isThreadRunning()) {
-									// advance X position according to elapsed time since start of sequencer
-									xPos += (((scoreBackgroundWidth - sharedData.pianoRollKeysWidth) * (timeStamp - sharedData.pianoRollTimeStamp)) / (sharedData.tempoMs[thisBar] * sharedData.numerator[thisBar]));
-								}
-								yPos = scoreBackgroundHeight - (float)(sharedData.pianoRollTwelveToSevenMap[(oneOctaveNote+3)%12] * sharedData.pianoRollKeysHeight) - ((sharedData.pianoRollKeysHeight/3)*2);
-								float yPosOffset = 0;
-								float heightDivisor = 3;
-								// if the note is an accidental
-								if (std::find(sharedData.pianoRollAccidentalKeys.begin(), sharedData.pianoRollAccidentalKeys.end(), oneOctaveNote) != sharedData.pianoRollAccidentalKeys.end()) {
-									yPos -= (sharedData.pianoRollKeysHeight / 2);
-									yPosOffset = sharedData.pianoRollKeysHeight / 6;
-								}
-								else {
-									// C and F
-									if (oneOctaveNote == 0 || oneOctaveNote == 5) {
-										if (note == HIGHESTKEY) {
-											yPosOffset = sharedData.pianoRollKeysHeight / 3;
-											heightDivisor = 2;
-										}
-										else {
-											yPosOffset = 0;
-										}
-									}
-									// E and B
-									else if (oneOctaveNote == 4 || oneOctaveNote == 11) {
+				ofSetColor(it->color);
+				ofDrawRectangle(it->key);
+				// for natural notes, we need to draw an extra rectangle that will fill the rest of the key
+				if (!it->accidental) ofDrawRectangle(it->restOfKey);
+				// the outline of the accidental keys is drawn once the key is highlighted
+				else drawBlackKeysOutline(it->key.x, it->key.y);
+			}
+		}
+	}
+	// then draw the lines that separate the keys
+	pianoRollKeyLines.draw();
+	// draw a line that separates the piano roll from the editor
+	ofSetColor(foregroundColor * brightnessCoeff);
+	if (scoreOrientation == 0 && scoreXOffset > 0) {
+		ofDrawLine(scoreXOffset, 0, scoreXOffset, scoreBackgroundHeight);
+	}
+	else if (scoreYOffset > 0) {
+		ofDrawLine(0, scoreYOffset, scoreBackgroundWidth, scoreYOffset);
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::buildPianoRollKeys()
+{
+	pianoRollKeys.clear();
+	pianoRollKeyLines.clear();
+	// a white rectangle that will be the white keys of the piano
+	ofColor whiteKeysColor = ofColor::white * brightnessCoeff;
+	if (scoreOrientation == 0) {
+		pianoRollKeys.addRectangle(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
+				scoreYOffset,
+				sharedData.pianoRollKeysWidth,
+				scoreBackgroundHeight,
+				whiteKeysColor);
+	}
+	else {
+		pianoRollKeys.addRectangle(0,
+				scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight,
+				scoreBackgroundWidth,
+				sharedData.pianoRollKeysHeight,
+				whiteKeysColor);
+	}
+	// then the black keys
+	for (int i = 0; i < sharedData.pianoRollNumWhiteKeys; i++) {
+		int iMod = i % 7;
+		if (scoreOrientation == 0) {
+			if (iMod != 0 && iMod != 4 && i < sharedData.pianoRollNumWhiteKeys - 1) {
+				pianoRollKeys.addRectangle(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
+						scoreYOffset+((i+1)*sharedData.pianoRollKeysHeight)-(sharedData.pianoRollKeysHeight/3),
+						(sharedData.pianoRollKeysWidth/3)*2,
+						(sharedData.pianoRollKeysHeight/3)*2,
+						ofColor(0));
+			}
+		}
+		else {
+			if (iMod != 1 && iMod != 4 && i < sharedData.pianoRollNumWhiteKeys - 1) {
+				pianoRollKeys.addRectangle(scoreXOffset+((i+1)*sharedData.pianoRollKeysWidth)-(sharedData.pianoRollKeysWidth/3),
+						scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight,
+						(sharedData.pianoRollKeysWidth/3)*2,
+						(sharedData.pianoRollKeysHeight/3)*2,
+						ofColor(0));
+			}
+		}
+	}
+	// if the background of the editor is white, draw a black line to separate the clavier from the background
+	if (backgroundColor == ofColor::white) {
+		pianoRollKeyLines.addLine(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
+				scoreYOffset,
+				scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
+				scoreYOffset+scoreBackgroundHeight,
+				ofColor(0));
+	}
+	// and the lines that separate the keys, which are drawn on top of the highlighted keys
+	ofColor linesColor = backgroundColor * brightnessCoeff;
+	if (backgroundColor == ofColor::white) linesColor = ofColor(0);
+	for (int i = 1; i < sharedData.pianoRollNumWhiteKeys; i++) {
+		int iMod = i % 7;
+		if (scoreOrientation == 0) {
+			float lineXOffset = 0;
+			// for the lines on top of black keys, draw a shorter line
+			if (iMod != 1 && iMod != 5) {
+				lineXOffset = (sharedData.pianoRollKeysWidth / 3) * 2;
+			}
+			pianoRollKeyLines.addLine(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth+lineXOffset,
+					scoreYOffset+(i*sharedData.pianoRollKeysHeight),
+					scoreXOffset+scoreBackgroundWidth,
+					scoreYOffset+(i*sharedData.pianoRollKeysHeight),
+					linesColor);
+		}
+		else {
+			float lineYOffset = 0;
+			if (iMod != 2 && iMod != 5) {
+				lineYOffset = (sharedData.pianoRollKeysHeight / 3) * 2;
+			}
+			pianoRollKeyLines.addLine(scoreXOffset+(i*sharedData.pianoRollKeysWidth),
+					scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight+lineYOffset,
+					scoreXOffset+(i*sharedData.pianoRollKeysWidth),
+					scoreYOffset+scoreBackgroundHeight,
+					linesColor);
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::buildPianoRollNotes()
+{
+	// the notes are placed where they are when their bar starts, and drawPianoRoll() translates them as the bar plays
+	// the first bar ends at the clavier and the second one comes right before it
+	pianoRollNotes.clear();
+	pianoRollHighlights.clear();
+	float rollLength = (scoreOrientation == 0 ? scoreBackgroundWidth - sharedData.pianoRollKeysWidth : scoreBackgroundHeight - sharedData.pianoRollKeysHeight);
+	for (int i = 0; i < 2; i++) {
+		int bar = (i == 0 ? pianoRollBars.first : pianoRollBars.second);
+		for (auto instIt = sharedData.instruments.begin(); instIt != sharedData.instruments.end(); ++instIt) {
+			ofColor color = instIt->second.getColor() * brightnessCoeff;
+			float posAccum = 0;
+			// safety test to ensure the bar we're trying to display actually exists
+			if (instIt->second.notes.find(bar) == instIt->second.notes.end()) {
+				continue;
+			}
+			for (size_t j = 0; j < instIt->second.notes.at(bar).size(); j++) {
+				float noteWidthHeight = (float)instIt->second.durs.at(bar).at(j) * sharedData.pianoRollMinDur;
+				float durPercentage = instIt->second.durPercentages[instIt->second.articulations[bar][j][0]];
+				for (size_t k = 0; k < instIt->second.notes.at(bar).at(j).size(); k++) {
+					int note = (int)instIt->second.notes.at(bar).at(j).at(k);
+					if (note == -1) continue; // -1 is rest
+					int octave = (note / 12) - 1;
+					int oneOctaveNote = note % 12;
+					if (oneOctaveNote < 9) octave--; // since we start from A, we must subtract one octave for all notes below A
+					if (note >= LOWESTKEY && note <= HIGHESTKEY) {
+						bool isAccidental = std::find(sharedData.pianoRollAccidentalKeys.begin(), sharedData.pianoRollAccidentalKeys.end(), oneOctaveNote) != sharedData.pianoRollAccidentalKeys.end();
+						// only the notes of the bar that reaches the clavier highlight its keys
+						PianoRollHighlight highlight;
+						highlight.inst = instIt->first;
+						highlight.noteNdx = (int)j;
+						highlight.color = color;
+						highlight.accidental = isAccidental;
+						if (scoreOrientation == 0) {
+							float xPos = scoreXOffset + scoreBackgroundWidth - sharedData.pianoRollKeysWidth - posAccum - noteWidthHeight;
+							// add the ADSR release trigger part to the X position, as this part is removed from the rectangle width
+							xPos += (noteWidthHeight * (1 - durPercentage));
+							if (i > 0) xPos -= rollLength;
+							float yPos = scoreBackgroundHeight - (float)(sharedData.pianoRollTwelveToSevenMap[(oneOctaveNote+3)%12] * sharedData.pianoRollKeysHeight) - ((sharedData.pianoRollKeysHeight/3)*2);
+							float yPosOffset = 0;
+							float heightDivisor = 3;
+							// if the note is an accidental
+							if (isAccidental) {
+								yPos -= (sharedData.pianoRollKeysHeight / 2);
+								yPosOffset = sharedData.pianoRollKeysHeight / 6;
+							}
+							else {
+								// C and F
+								if (oneOctaveNote == 0 || oneOctaveNote == 5) {
+									if (note == HIGHESTKEY) {
 										yPosOffset = sharedData.pianoRollKeysHeight / 3;
+										heightDivisor = 2;
 									}
-									// D, G and A
 									else {
 										yPosOffset = 0;
-										if (note != LOWESTKEY) {
-											heightDivisor = 6;
-										}
 									}
 								}
-								yPos -= ((octave * 7) * sharedData.pianoRollKeysHeight);
-								float noteWidth = noteWidthHeight * durPercentage;
-								if (i == 0) {
-									float noteWidthDiff = noteWidth - (scoreXOffset + scoreBackgroundWidth - sharedData.pianoRollKeysWidth - xPos);
-									if (noteWidthDiff > 0) noteWidth -= noteWidthDiff;
+								// E and B
+								else if (oneOctaveNote == 4 || oneOctaveNote == 11) {
+									yPosOffset = sharedData.pianoRollKeysHeight / 3;
 								}
+								// D, G and A
 								else {
-									xPos -= (scoreBackgroundWidth - sharedData.pianoRollKeysWidth);
-									noteWidth = std::min(noteWidth, xPos - (scoreXOffset - noteWidth));
-									xPos = std::max(xPos, scoreXOffset);
-								}
-								if (noteWidth > 0) {
-									ofDrawRectangle(xPos, yPos, noteWidth, sharedData.pianoRollKeysHeight/3);
-									// highlight the active note on the clavier
-									if (sequencer.isThreadRunning() && instIt->second.getSeqToggle() && bar == thisBar && (int)j == instIt->second.getBarDataCounter()) {
-										ofDrawRectangle(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
-												yPos-yPosOffset,
-												(sharedData.pianoRollKeysWidth/3)*2,
-												(sharedData.pianoRollKeysHeight/heightDivisor)*2);
-										// for natural notes, we need to draw an extra rectangle that will fill the rest of the key
-										if (std::find(sharedData.pianoRollAccidentalKeys.begin(), sharedData.pianoRollAccidentalKeys.end(), oneOctaveNote) == sharedData.pianoRollAccidentalKeys.end()) {
-											ofDrawRectangle(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth+((sharedData.pianoRollKeysWidth/3)*2),
-													yPos-(sharedData.pianoRollKeysHeight/3),
-													sharedData.pianoRollKeysWidth/3,
-													sharedData.pianoRollKeysHeight);
-										}
-										else {
-											// push back the X/Y coordinates for the outline of the accidental key can be drawn
-											// once all other keys (including highlighted keys) are drawn
-											vp.push_back(std::make_pair(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth, yPos-yPosOffset));
-										}
+									yPosOffset = 0;
+									if (note != LOWESTKEY) {
+										heightDivisor = 6;
 									}
 								}
 							}
+							yPos -= ((octave * 7) * sharedData.pianoRollKeysHeight);
+							pianoRollNotes.addRectangle(xPos, yPos, noteWidthHeight * durPercentage, sharedData.pianoRollKeysHeight/3, color);
+							highlight.key.set(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth,
+									yPos-yPosOffset,
+									(sharedData.pianoRollKeysWidth/3)*2,
+									(sharedData.pianoRollKeysHeight/heightDivisor)*2);
+							highlight.restOfKey.set(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth+((sharedData.pianoRollKeysWidth/3)*2),
+									yPos-(sharedData.pianoRollKeysHeight/3),
+									sharedData.pianoRollKeysWidth/3,
+									sharedData.pianoRollKeysHeight);
+						}
+						else {
+							float xPos = (float)(sharedData.pianoRollTwelveToSevenMap[(oneOctaveNote+3)%12] * sharedData.pianoRollKeysWidth) + ((sharedData.pianoRollKeysWidth/3));
+							float yPos = scoreYOffset + scoreBackgroundHeight - sharedData.pianoRollKeysHeight - posAccum - noteWidthHeight;
+							// add the ADSR release trigger part to the Y position, as this part is removed from the rectangle height
+							yPos += (noteWidthHeight * (1 - durPercentage));
+							if (i > 0) yPos -= rollLength;
+							float xPosOffset = 0;
+							// the following variable is for highlighting active keys on the clavier
+							float widthDivisor = 3;
+							// if the note is an accidental
+							if (isAccidental) {
+								xPos += (sharedData.pianoRollKeysWidth / 2);
+								xPosOffset = sharedData.pianoRollKeysWidth / 6;
+							}
 							else {
-								xPos = (float)(sharedData.pianoRollTwelveToSevenMap[(oneOctaveNote+3)%12] * sharedData.pianoRollKeysWidth) + ((sharedData.pianoRollKeysWidth/3));
-								yPos = scoreYOffset + scoreBackgroundHeight - sharedData.pianoRollKeysHeight - posAccum - noteWidthHeight;
-								// add the ADSR release trigger part to the Y position, as this part is removed from the rectangle height
-								yPos += (noteWidthHeight * (1 - durPercentage));
-								float xPosOffset = 0;
-								// the following variable is for highlighting active keys on the clavier
-								float widthDivisor = 3;
-								if (sequencer.isThreadRunning()) {
-									// advance Y position according to elapsed time since start of sequencer
-									yPos += (((scoreBackgroundHeight-sharedData.pianoRollKeysHeight) * (timeStamp-sharedData.pianoRollTimeStamp)) / (sharedData.tempoMs[thisBar]*sharedData.numerator[thisBar]));
-								}
-								// if the note is an accidental
-								if (std::find(sharedData.pianoRollAccidentalKeys.begin(), sharedData.pianoRollAccidentalKeys.end(), oneOctaveNote) != sharedData.pianoRollAccidentalKeys.end()) {
-									xPos += (sharedData.pianoRollKeysWidth / 2);
-									xPosOffset = sharedData.pianoRollKeysWidth / 6;
-								}
-								else {
-									// C and F
-									if (oneOctaveNote == 0 || oneOctaveNote == 5) {
-										xPosOffset = sharedData.pianoRollKeysWidth / 3;
-										if (note == HIGHESTKEY) {
-											widthDivisor = 1;
-										}
-									}
-									// D, G and A and not E or B
-									else if (oneOctaveNote != 4 && oneOctaveNote != 11) {
-										if (note == LOWESTKEY) {
-											xPosOffset = sharedData.pianoRollKeysWidth / 3;
-										}
-										else {
-											widthDivisor = 6;
-										}
+								// C and F
+								if (oneOctaveNote == 0 || oneOctaveNote == 5) {
+									xPosOffset = sharedData.pianoRollKeysWidth / 3;
+									if (note == HIGHESTKEY) {
+										widthDivisor = 1;
 									}
 								}
-								xPos += ((octave * 7) * sharedData.pianoRollKeysWidth);
-								float noteHeight = noteWidthHeight * durPercentage;
-								if (i == 0) {
-									float noteHeightDiff = noteHeight - (scoreYOffset + scoreBackgroundHeight - sharedData.pianoRollKeysHeight - yPos);
-									if (noteHeightDiff > 0) noteHeight -= noteHeightDiff;
-								}
-								else {
-									yPos -= (scoreBackgroundHeight - sharedData.pianoRollKeysHeight);
-									noteHeight = std::min(noteHeight, yPos - (scoreYOffset - noteHeight));
-									yPos = std::max(yPos, scoreYOffset);
-								}
-								if (noteHeight > 0) {
-									ofDrawRectangle(xPos, yPos, sharedData.pianoRollKeysWidth/3, noteHeight);
-									// highlight the active note on the clavier
-									if (sequencer.isThreadRunning() && instIt->second.getSeqToggle() && bar == thisBar && (int)j == instIt->second.getBarDataCounter()) {
-										ofDrawRectangle(xPos-xPosOffset,
-												scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight,
-												(sharedData.pianoRollKeysWidth/widthDivisor)*2,
-												(sharedData.pianoRollKeysHeight/3)*2);
-										// for natural notes, we need to draw an extra rectangle that will fill the rest of the key
-										if (std::find(sharedData.pianoRollAccidentalKeys.begin(), sharedData.pianoRollAccidentalKeys.end(), oneOctaveNote) == sharedData.pianoRollAccidentalKeys.end()) {
-											ofDrawRectangle(xPos-(sharedData.pianoRollKeysWidth/3),
-													scoreYOffset+scoreBackgroundHeight-(sharedData.pianoRollKeysHeight/3),
-													sharedData.pianoRollKeysWidth,
-													sharedData.pianoRollKeysHeight/3);
-										}
-										else {
-											// push back the X/Y coordinates for the outline of the accidental key can be drawn
-											// once all other keys (including highlighted keys) are drawn
-											vp.push_back(std::make_pair(xPos-xPosOffset, scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight));
-										}
+								// D, G and A and not E or B
+								else if (oneOctaveNote != 4 && oneOctaveNote != 11) {
+									if (note == LOWESTKEY) {
+										xPosOffset = sharedData.pianoRollKeysWidth / 3;
+									}
+									else {
+										widthDivisor = 6;
 									}
 								}
 							}
+							xPos += ((octave * 7) * sharedData.pianoRollKeysWidth);
+							pianoRollNotes.addRectangle(xPos, yPos, sharedData.pianoRollKeysWidth/3, noteWidthHeight * durPercentage, color);
+							highlight.key.set(xPos-xPosOffset,
+									scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight,
+									(sharedData.pianoRollKeysWidth/widthDivisor)*2,
+									(sharedData.pianoRollKeysHeight/3)*2);
+							highlight.restOfKey.set(xPos-(sharedData.pianoRollKeysWidth/3),
+									scoreYOffset+scoreBackgroundHeight-(sharedData.pianoRollKeysHeight/3),
+									sharedData.pianoRollKeysWidth,
+									sharedData.pianoRollKeysHeight/3);
 						}
+						if (i == 0) pianoRollHighlights.push_back(highlight);
 					}
-					if (!vp.empty()) {
-						for (std::pair<float, float> p : vp) {
-							drawBlackKeysOutline(p.first, p.second);
-						}
-					}
-					posAccum += noteWidthHeight;
 				}
+				posAccum += noteWidthHeight;
 			}
 		}
 	}
-	// then draw the lines that separate the keys
-	ofSetColor(backgroundColor * brightnessCoeff);
-	if (backgroundColor == ofColor::white) ofSetColor(0);
-	for (int i = 1; i < sharedData.pianoRollNumWhiteKeys; i++) {
-		int iMod = i % 7;
-		if (scoreOrientation == 0) {
-			float lineXOffset = 0;
-			// for the lines on top of black keys, draw a shorter line
-			if (iMod != 1 && iMod != 5) {
-				lineXOffset = (sharedData.pianoRollKeysWidth / 3) * 2;
-			}
-			ofDrawLine(scoreXOffset+scoreBackgroundWidth-sharedData.pianoRollKeysWidth+lineXOffset,
-					scoreYOffset+(i*sharedData.pianoRollKeysHeight),
-					scoreXOffset+scoreBackgroundWidth,
-					scoreYOffset+(i*sharedData.pianoRollKeysHeight));
-		}
-		else {
-			float lineYOffset = 0;
-			if (iMod != 2 && iMod != 5) {
-				lineYOffset = (sharedData.pianoRollKeysHeight / 3) * 2;
-			}
-			ofDrawLine(scoreXOffset+(i*sharedData.pianoRollKeysWidth),
-					scoreYOffset+scoreBackgroundHeight-sharedData.pianoRollKeysHeight+lineYOffset,
-					scoreXOffset+(i*sharedData.pianoRollKeysWidth),
-					scoreYOffset+scoreBackgroundHeight);
-		}
-	}
-	// draw a line that separates the piano roll from the editor
-	ofSetColor(foregroundColor * brightnessCoeff);
-	if (scoreOrientation == 0 && scoreXOffset > 0) {
-		ofDrawLine(scoreXOffset, 0, scoreXOffset, scoreBackgroundHeight);
-	}
-	else if (scoreYOffset > 0) {
-		ofDrawLine(0, scoreYOffset, scoreBackgroundWidth, scoreYOffset);
-	}
 }
 
 //--------------------------------------------------------------
@@ -2327,6 +2513,71 @@ void ofApp::drawBlackKeysOutline(float xPos, float yPos)
 	}
 }
 
+//--------------------------------------------------------------
+void ofApp::updateScope()
+{
+	// keep the latest frames pushed by the audio thread, shifting the older ones to the left
+	size_t numFrames = (size_t)bufferSize;
+	if (scopeLeft.size() != numFrames) {
+		scopeLeft.assign(numFrames, 0);
+		scopeRight.assign(numFrames, 0);
+	}
+	ScopeFrame frames[SCOPECHUNKSIZE];
+	size_t numPopped;
+	while ((numPopped = scopeQueue.pop(frames, SCOPECHUNKSIZE)) > 0) {
+		size_t first = (numPopped > numFrames ? numPopped - numFrames : 0);
+		size_t numNew = numPopped - first;
+		std::copy(scopeLeft.begin()+numNew, scopeLeft.end(), scopeLeft.begin());
+		std::copy(scopeRight.begin()+numNew, scopeRight.end(), scopeRight.begin());
+		for (size_t i = 0; i < numNew; i++) {
+			scopeLeft[numFrames-numNew+i] = frames[first+i].left;
+			scopeRight[numFrames-numNew+i] = frames[first+i].right;
+		}
+	}
+	float sum = 0;
+	for (size_t i = 0; i < numFrames; i++) {
+		sum += (scopeLeft[i] * scopeLeft[i]) + (scopeRight[i] * scopeRight[i]);
+	}
+	scopeRms = (numFrames > 0 ? sqrt(sum / (float)(numFrames * 2)) : 0);
+	decimateScope(scopeLeft, scopeWaveformLeft);
+	decimateScope(scopeRight, scopeWaveformRight);
+}
+
+//--------------------------------------------------------------
+void ofApp::decimateScope(const std::vector<float>& samples, ofPolyline& waveform)
+{
+	// when there are more samples than pixels, every pixel column gets a vertex
+	// for the minimum and the maximum of its samples, so peaks are not lost
+	waveform.clear();
+	size_t numFrames = samples.size();
+	if (numFrames == 0) return;
+	size_t numColumns = std::max((size_t)1, (size_t)scoreBackgroundWidth);
+	float halfHeight = scoreBackgroundHeight / 2;
+	float yOffset = halfHeight + (scoreOrientation == 1 ? scoreYOffset : 0);
+	float scale = halfHeight * scopeRms;
+	if (numFrames <= numColumns) {
+		float xStep = scoreBackgroundWidth / (float)numFrames;
+		for (size_t i = 0; i < numFrames; i++) {
+			waveform.addVertex(scoreXOffset + (i * xStep), (samples[i] * scale) + yOffset);
+		}
+		return;
+	}
+	const float *data = samples.data();
+	for (size_t col = 0; col < numColumns; col++) {
+		size_t start = col * numFrames / numColumns;
+		size_t end = (col + 1) * numFrames / numColumns;
+		float minVal = data[start];
+		float maxVal = data[start];
+		for (size_t i = start+1; i < end; i++) {
+			minVal = std::min(minVal, data[i]);
+			maxVal = std::max(maxVal, data[i]);
+		}
+		float x = scoreXOffset + (float)col;
+		waveform.addVertex(x, (minVal * scale) + yOffset);
+		waveform.addVertex(x, (maxVal * scale) + yOffset);
+	}
+}
+
 //--------------------------------------------------------------
 void ofApp::drawScope()
 {
@@ -2486,10 +2737,12 @@ void ofApp::executeKeyPressed(int key)
 			else if (key == 61 && editors[whichPane].isCtrlPressed() && editors[whichPane].isAltPressed()) { // + (actually =)
 				brightnessCoeff += 0.01;
 				if (brightnessCoeff > 1) brightnessCoeff = 1;
+				pianoRollDirty = true;
 			}
 			else if (key == 45 && editors[whichPane].isCtrlPressed() && editors[whichPane].isAltPressed()) { // -
 				brightnessCoeff -= 0.01;
 				if (brightnessCoeff < 0) brightnessCoeff = 0;
+				pianoRollDirty = true;
 			}
 	    	else if (key == 102 && editors[whichPane].isCtrlPressed()) { // f
 				if (editors[whichPane].getInserting()) {
@@ -2697,14 +2950,15 @@ void ofApp::keyReleased(int key)
 
 //--------------------------------------------------------------
 // the following two functions are used to check for key modifiers received from a Python pane
-pyStdoutStrKeyModifier ofApp::checkPyStdoutKeyModifier(int ndx)
+pyStdoutStrKeyModifier ofApp::checkPyStdoutKeyModifier(const std::string& str, int ndx)
 {
 	pyStdoutStrKeyModifier keyMod = {false, 0, 0, 0};
-	if (sharedData.pyStdoutStr[ndx] == '<' && ((ndx > 0 && sharedData.pyStdoutStr[ndx-1] != '\\') || ndx == 0)) {
-		if (sharedData.pyStdoutStr.substr(ndx).find(">") == std::string::npos) {
+	if (str[ndx] == '<' && ((ndx > 0 && str[ndx-1] != '\\') || ndx == 0)) {
+		size_t closingNdx = str.find(">", ndx);
+		if (closingNdx == std::string::npos) {
 			return keyMod;
 		}
-		std::string s = sharedData.pyStdoutStr.substr(ndx+1, sharedData.pyStdoutStr.substr(ndx+1).find(">"));
+		std::string s = str.substr(ndx+1, closingNdx-ndx-1);
 		int modifierKey = 0;
 		int action = 0;
 		if (s.compare("SHIFT_DOWN") == 0) {
@@ -2763,6 +3017,82 @@ void ofApp::handleKeyModifier(pyStdoutStrKeyModifier modifierStruct)
 	}
 }
 
+//--------------------------------------------------------------
+void ofApp::typePyStdoutChar()
+{
+	// types the next character of a string printed by a Python pane, or applies the key modifier found there
+	pyStdoutStrKeyModifier keyMod = checkPyStdoutKeyModifier(sharedData.pyStdoutStr, sharedData.pyStdoutStrNdx);
+	sharedData.pyStdoutStrNdx += keyMod.ndxInc;
+	if (keyMod.isModifier) {
+		handleKeyModifier(keyMod);
+	}
+	else {
+		int charToType = (int)sharedData.pyStdoutStr[sharedData.pyStdoutStrNdx];
+		if (sharedData.pyStdoutStr[sharedData.pyStdoutStrNdx] == '\n') {
+			charToType = 13;
+		}
+		if (sharedData.whichPyPane == whichPane) {
+			keyPressed(charToType);
+		}
+		else {
+			keyPressedOsc(charToType, sharedData.whichPyPane);
+		}
+		sharedData.pyStdoutStrNdx++;
+	}
+	if (sharedData.pyStdoutStrNdx >= sharedData.pyStdoutStr.size()) {
+		sharedData.pyStdoutStr.clear();
+		sharedData.pyStdoutStrNdx = 0;
+		sharedData.typePyStr = false;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::typePyStdoutBulk()
+{
+	// types the whole string printed by a Python pane in one go, instead of one character per frame
+	// runs of plain characters are inserted with one call to the pane
+	// line breaks, control characters, key modifiers, and characters typed while Ctrl or Alt is pressed
+	// go through the key handling one by one, so shortcuts work as in char mode
+	int firstLine = editors[sharedData.whichPyPane].getCursorLineIndex();
+	while (sharedData.typePyStr) {
+		// a shortcut typed from Python might remove the pane
+		std::map<int, Editor>::iterator editorIt = editors.find(sharedData.whichPyPane);
+		if (editorIt == editors.end()) {
+			sharedData.pyStdoutStr.clear();
+			sharedData.pyStdoutStrNdx = 0;
+			sharedData.typePyStr = false;
+			return;
+		}
+		Editor& editor = editorIt->second;
+		size_t runEnd = sharedData.pyStdoutStrNdx;
+		// keys sent over OSC to another pane are still sent one by one
+		bool sendsKeys = (sharedData.whichPyPane == whichPane && editor.getSendKeys());
+		if (editor.getInserting() && !editor.isTypingShell() && !editor.isCtrlPressed() && !editor.isAltPressed() && !sendsKeys) {
+			while (runEnd < sharedData.pyStdoutStr.size()) {
+				unsigned char c = (unsigned char)sharedData.pyStdoutStr[runEnd];
+				if (c == '<' || c == 127 || (c < 32 && c != '\t')) break;
+				runEnd++;
+			}
+		}
+		if (runEnd > sharedData.pyStdoutStrNdx) {
+			mutex.lock();
+			editor.insertString(sharedData.pyStdoutStr.substr(sharedData.pyStdoutStrNdx, runEnd-sharedData.pyStdoutStrNdx));
+			mutex.unlock();
+			sharedData.pyStdoutStrNdx = runEnd;
+			if (sharedData.pyStdoutStrNdx >= sharedData.pyStdoutStr.size()) {
+				sharedData.pyStdoutStr.clear();
+				sharedData.pyStdoutStrNdx = 0;
+				sharedData.typePyStr = false;
+			}
+		}
+		else {
+			typePyStdoutChar();
+		}
+	}
+	std::map<int, Editor>::iterator editorIt = editors.find(sharedData.whichPyPane);
+	if (editorIt != editors.end()) editorIt->second.startTypingAnim(firstLine, sharedData.typePyStrAnimRate);
+}
+
 /********************* panes functions ************************/
 //--------------------------------------------------------------
 void ofApp::addPane(int key)
@@ -3022,7 +3352,7 @@ void ofApp::parseStrings(int index, int numLines)
 			// then add a rest for any instrument that is not included in the bar
 			fillInMissingInsts(barIndex);
 			// if we create a bar, create a loop with this bar only
-			sharedData.loopData[barIndex] = {barIndex};
+			setLoopData(barIndex, {barIndex});
 			// check if no time has been specified and set the default 4/4
 			if (sharedData.numerator.find(barIndex) == sharedData.numerator.end()) {
 				sharedData.numerator[barIndex] = 4;
@@ -3030,9 +3360,8 @@ void ofApp::parseStrings(int index, int numLines)
 			}
 			setScoreNotes(barIndex);
 			if (!parsingBars) {
-				// then set the note positions and calculate the staff positions
-				setNotePositions(barIndex);
-				calculateStaffPositions(barIndex, false);
+				// the note positions and the staff positions are calculated when the bar is about to be shown
+				setLayoutDirty(barIndex);
 			}
 			barError = false;
 			for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
@@ -3067,12 +3396,10 @@ void ofApp::parseStrings(int index, int numLines)
 			parseStrings(index, numLines);
 		}
 		else {
-			int barIndex = sharedData.barsIndexes["\\"+multiBarsName+"-1"];
-			setNotePositions(barIndex, barsIterCounter);
 			for (int i = 0; i < barsIterCounter; i++) {
-				barIndex = sharedData.barsIndexes["\\"+multiBarsName+"-"+std::to_string(i+1)];
+				int barIndex = sharedData.barsIndexes["\\"+multiBarsName+"-"+std::to_string(i+1)];
+				setLayoutDirty(barIndex);
 				sendBarToParts(barIndex);
-				calculateStaffPositions(barIndex, false);
 			}
 			parsingBars = false;
 			firstInstForBarsSet = false;
@@ -3099,6 +3426,8 @@ void ofApp::parseStrings(int index, int numLines)
 //--------------------------------------------------------------
 std::pair<int, std::string> ofApp::parseString(std::string str, int lineNum, int numLines)
 {
+	// any command might change what the score shows
+	scoreFboDirty = true;
 	if (str.length() == 0) return std::make_pair(0, "");
 	if (startsWith(str, "%")) return std::make_pair(0, "");
 	// strip white spaces
@@ -3923,10 +4252,82 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 		if (!cmdInput.isMainCmd) {
 			return genError("\\print can only be a top command");
 		}
+		if (cmdInput.inputVec.size() == 2 && cmdInput.inputVec[1].compare("stats") == 0) {
+			return genNote(getLatencyStatsStr());
+		}
 		std::vector<std::string> v = {cmdInput.inputVec.begin()+1, cmdInput.inputVec.end()};
 		return genNote(genStrFromVec(v));
 	}
 
+	else if (startsWith(cmdInput.inputVec[0], "\\stats.")) {
+		std::vector<std::string> v = tokenizeString(cmdInput.inputVec[0], ".");
+		if (v[1].compare("reset") == 0) {
+			if (cmdInput.inputVec.size() > 1) {
+				return genError("\\stats.reset takes no arguments");
+			}
+			sequencer.resetLatency();
+		}
+		else if (v[1].compare("dump") == 0) {
+			if (cmdInput.inputVec.size() == 2 && cmdInput.inputVec[1].compare("off") == 0) {
+				latencyDumpInterval = 0;
+				return cmdOutput;
+			}
+			if (cmdInput.inputVec.size() != 3) {
+				return genError("\\stats.dump takes two arguments, the CSV file and the interval in seconds, or \"off\"");
+			}
+			if (!isFloat(cmdInput.inputVec[2]) || stof(cmdInput.inputVec[2]) <= 0) {
+				return genError("dump interval must be a positive number of seconds");
+			}
+			latencyDumpFile = cmdInput.inputVec[1];
+			latencyDumpInterval = (uint64_t)(stof(cmdInput.inputVec[2]) * 1000);
+			latencyDumpTimeStamp = ofGetElapsedTimeMillis();
+		}
+		else {
+			return genError("\\stats takes only \"reset\" and \"dump\" as second level commands");
+		}
+	}
+
+	else if (startsWith(cmdInput.inputVec[0], "\\trace.")) {
+		std::vector<std::string> v = tokenizeString(cmdInput.inputVec[0], ".");
+		if (v[1].compare("record") == 0) {
+			if (cmdInput.inputVec.size() != 2) {
+				return genError("\\trace.record takes one argument, the file to record to");
+			}
+			if (sequencer.isRendering()) {
+				return genError("can't record a trace while the sequencer is rendering");
+			}
+			if (!sequencer.tracer.start(cmdInput.inputVec[1], ofGetElapsedTimeMicros(), false)) {
+				return genError("could not open " + cmdInput.inputVec[1] + " for writing");
+			}
+		}
+		else if (v[1].compare("play") == 0) {
+			if (cmdInput.inputVec.size() != 2) {
+				return genError("\\trace.play takes one argument, the trace file to play");
+			}
+			if (sequencer.isThreadRunning()) {
+				return genError("can't play a trace while the sequencer is running");
+			}
+			if (!tracePlayer.play(cmdInput.inputVec[1])) {
+				return genError(cmdInput.inputVec[1] + " is not a trace file");
+			}
+		}
+		else if (v[1].compare("stop") == 0) {
+			if (cmdInput.inputVec.size() > 1) {
+				return genError("\\trace.stop takes no arguments");
+			}
+			tracePlayer.stop();
+			if (sequencer.tracer.isRecording()) {
+				sequencer.tracer.stop();
+				if (sequencer.tracer.getNumDropped() > 0) {
+					return genWarning(std::to_string(sequencer.tracer.getNumDropped()) + " events were dropped from the trace");
+				}
+			}
+		}
+		else {
+			return genError("\\trace takes only \"record\", \"play\", and \"stop\" as second level commands");
+		}
+	}
+
 	else if (cmdInput.inputVec[0].compare("\\osc") == 0) {
 		if (cmdInput.inputVec.size() < 2) {
 			return genError("\\osc command takes one argument, the name of the OSC client");
@@ -3993,10 +4394,12 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 				commandsMap[livelily][it->second.getName()[0]].erase("\\" + it->second.getName());
 			}
 			sharedData.instruments.clear();
+			pianoRollDirty = true;
 			sharedData.instrumentIndexes.clear();
 			sharedData.instrumentIndexesOrdered.clear();
 			sharedData.numInstruments = 0;
 			sharedData.barsIndexes.clear();
+			prevBarsIndexes.clear();
 			sharedData.loopData.clear();
 			sharedData.loopsIndexes.clear();
 			sharedData.loopsOrdered.clear();
@@ -4006,6 +4409,8 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 			sharedData.grouppedOSCClients.clear();
 			sharedData.distBetweenBeats.clear();
 			instrumentOSCHostPorts.clear();
+			partSettings.clear();
+			partGroups.clear();
 			instGroups.clear();
 			tempLines.clear();
 			allBars.clear();
@@ -4118,6 +4523,21 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 			m.addStringArg(cmdInput.inputVec[i]);
 		}
 		sendToParts(m, false);
+		// a group that includes an instrument of an earlier group redefines it, so only the new one is kept for syncing parts
+		for (auto it = partGroups.begin(); it != partGroups.end();) {
+			bool overlaps = false;
+			for (size_t i = 0; i < it->getNumArgs() && !overlaps; i++) {
+				for (size_t j = 0; j < m.getNumArgs(); j++) {
+					if (it->getArgAsString(i) == m.getArgAsString(j)) {
+						overlaps = true;
+						break;
+					}
+				}
+			}
+			if (overlaps) it = partGroups.erase(it);
+			else ++it;
+		}
+		partGroups.push_back(m);
 		if (!groupName.empty()) {
 			instGroups[groupName] = {cmdInput.inputVec.begin()+1, cmdInput.inputVec.end()-1};
 			commandsMap[livelily][groupName.substr(1)[0]][groupName] = ofColor::lightSteelBlue;
@@ -4373,6 +4793,7 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 			fromOscAddr[whichPane] = "/livelily" + std::to_string(whichPane+1);
 		}
 		fromOsc[whichPane] = true;
+		setOscRoutes();
 		if (!oscReceiverIsSet) {
 			oscReceiver.setup(OSCPORT);
 			oscReceiverIsSet = true;
@@ -4823,6 +5244,7 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 			int error = sharedData.instruments[i].setDuration(subcommand, (float)percentage/10.0);
 			if (error) return genError("unknown duration second level command");
 		}
+		pianoRollDirty = true;
 		if (percentage == 100) {
 			return genWarning("percentage to \\dur." + subcommand + " set to 100\% of Note On duration");
 		}
@@ -4977,14 +5399,31 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 	}
 
 	else if (cmdInput.inputVec[0].compare("\\pystr") == 0) {
-		if (cmdInput.inputVec.size() != 2) {
-			return genError("\\pystr command takes one argument, the typing mode");
+		if (cmdInput.inputVec.size() < 2 || cmdInput.inputVec.size() > 3) {
+			return genError("\\pystr command takes one argument, the typing mode, and an optional animation rate for bulk mode");
+		}
+		if (cmdInput.inputVec.size() == 3 && cmdInput.inputVec[1].compare("bulk") != 0) {
+			return genError("only bulk mode of \\pystr takes an animation rate");
 		}
 		if (cmdInput.inputVec[1].compare("char") == 0) {
 			sharedData.typePyStrCharByChar = true;
+			sharedData.typePyStrBulk = false;
 		}
 		else if (cmdInput.inputVec[1].compare("line") == 0) {
 			sharedData.typePyStrCharByChar = false;
+			sharedData.typePyStrBulk = false;
+		}
+		else if (cmdInput.inputVec[1].compare("bulk") == 0) {
+			float animRate = 0;
+			if (cmdInput.inputVec.size() == 3) {
+				if (!isFloat(cmdInput.inputVec[2])) {
+					return genError("animation rate must be a number, in lines per second");
+				}
+				animRate = std::max(0.0f, (float)stof(cmdInput.inputVec[2]));
+			}
+			sharedData.typePyStrCharByChar = false;
+			sharedData.typePyStrBulk = true;
+			sharedData.typePyStrAnimRate = animRate;
 		}
 		else {
 			return genError(cmdInput.inputVec[1] + ": unknown argument to \\pystr");
@@ -5180,12 +5619,24 @@ CmdOutput ofApp::parseCommand(CmdInput cmdInput, int lineNum, int numLines)
 #ifdef USEPYO
 					if (cmdInput.inputVec.size() > 1) {
 						std::string pyoStr = genStrFromVec({cmdInput.inputVec.begin()+1, cmdInput.inputVec.end()});
-						sharedData.pyo.exec(pyoStr.c_str(), 1);
+						sharedData.pyo.request(pyoStr, 1);
+					}
+#endif
+				}
+				else if (v[1].compare("cancel") == 0) {
+					if (!pyoSet) {
+						return genError("python has not been initialized");
 					}
+					if (cmdInput.inputVec.size() > 1) {
+						return genError("\\python.cancel takes no arguments");
+					}
+#ifdef USEPYO
+					// interrupt the running Python code and discard the queued one
+					sharedData.pyo.cancel();
 #endif
 				}
 				else {
-					return genError("\\python takes only \"send\" as a second level command");
+					return genError("\\python takes only \"send\" and \"cancel\" as second level commands");
 				}
 			}
 		}
@@ -6717,6 +7168,14 @@ std::pair<int, std::string> ofApp::parseMelodicLine(std::vector<std::string> tok
 		}
 	}
 
+	// determine the duration of every note within a crescendo or diminuendo in ms
+	// so the sequencer can stream the dynamic from this note's value to the next one
+	for (i = 0; i < dynamicsRampCounter; i++) {
+		for (j = dynamicsRampIndexes.at(i).first; j < dynamicsRampIndexes.at(i).second; j++) {
+			midiDynamicsRampDurs.at(j) = (int)((double)dursData.at(j) * (sharedData.tempo[barIndex]));
+		}
+	}
+
 	// now we can create a vector of pairs with the indexes of the slurs
 	int numSlurStarts = 0, numSlurStops = 0;
 	for (i = 0; i < numNotesVertical; i++) {
@@ -6822,7 +7281,7 @@ std::pair<int, std::string> ofApp::parseBarLoop(std::string str, int lineNum, in
 		}
 		// find the last index of the stored loops and store the vector we just created to the value of loopData
 		int loopNdx = getLastLoopIndex();
-		sharedData.loopData[loopNdx] = thisBarIndexes;
+		setLoopData(loopNdx, thisBarIndexes);
 		return std::make_pair(0, "");
 	}
 	size_t multIndex = wildCardStr.find("*");
@@ -6967,7 +7426,7 @@ std::pair<int, std::string> ofApp::parseBarLoop(std::string str, int lineNum, in
 	}
 	// find the last index of the stored loops and store the vector we just created to the value of loopData
 	int loopNdx = getLastLoopIndex();
-	sharedData.loopData[loopNdx] = thisBarIndexes;
+	setLoopData(loopNdx, thisBarIndexes);
 	if (restOfCommand.size() > 0) {
 		// falsify this so that the name of the loop is treated properly in parseString()
 		// otherwise, parseString() will again call this function
@@ -7059,6 +7518,12 @@ std::pair<bool, CmdOutput> ofApp::isInstrument(std::vector<std::string>& origina
 					}
 					if (commands.size() == 3 && commands[2].compare("python") == 0) {
 						sharedData.instruments[lastInstrumentIndex].setSendToPython(true);
+#ifdef USEPYO
+						// the frequency and amplitude methods of the Python object with the instrument's name
+						// are resolved once, and the sequencer sends raw floats to them
+						sharedData.instruments[lastInstrumentIndex].pyoFreqBinding = sharedData.pyo.bind(sharedData.instruments[lastInstrumentIndex].getName(), "setFreq");
+						sharedData.instruments[lastInstrumentIndex].pyoAmpBinding = sharedData.pyo.bind(sharedData.instruments[lastInstrumentIndex].getName(), "setAmp");
+#endif
 						return std::make_pair(instrumentExists, cmdOutput);
 					}
 					std::string remoteIP;
@@ -7107,6 +7572,11 @@ std::pair<bool, CmdOutput> ofApp::isInstrument(std::vector<std::string>& origina
 					sharedData.instruments[lastInstrumentIndex].sendToPart = true;
 					sharedData.instruments[lastInstrumentIndex].scorePartSender.setup(remoteIP, port);
 					numScorePartSenders++;
+					// listen for sync requests from the part
+					if (!oscReceiverIsSet) {
+						oscReceiver.setup(OSCPORT);
+						oscReceiverIsSet = true;
+					}
 					ofxOscMessage m;
 					m.setAddress("/initinst");
 					m.addIntArg(lastInstrumentIndex);
@@ -7322,6 +7792,63 @@ std::pair<bool, CmdOutput> ofApp::isInstrument(std::vector<std::string>& origina
 					int delayTime = stoi(commands[2]);
 					sharedData.instruments[lastInstrumentIndex].setDelay((int64_t)delayTime);
 				}
+				else if (commands[1].compare("dynramp") == 0) {
+					if (!hasDot) {
+						return std::make_pair(instrumentExists, genError("\"dynramp\" is a second level command, must be concatenated to instrument name with a dot"));
+					}
+					if (commands.size() != 3) {
+						return std::make_pair(instrumentExists, genError("\"dynramp\" command takes one argument, default, cc7, cc11, pressure, or off"));
+					}
+					if (commands[2].compare("default") == 0) {
+						sharedData.instruments[lastInstrumentIndex].setDynamicsRampOutput(Instrument::dynRampDefault);
+					}
+					else if (commands[2].compare("cc7") == 0 || commands[2].compare("cc11") == 0 || commands[2].compare("pressure") == 0) {
+						if (!sharedData.instruments[lastInstrumentIndex].isMidi()) {
+							return std::make_pair(instrumentExists, genError(commands[2] + " can only be used with MIDI instruments"));
+						}
+						if (commands[2].compare("cc7") == 0) sharedData.instruments[lastInstrumentIndex].setDynamicsRampOutput(Instrument::dynRampCC7);
+						else if (commands[2].compare("cc11") == 0) sharedData.instruments[lastInstrumentIndex].setDynamicsRampOutput(Instrument::dynRampCC11);
+						else sharedData.instruments[lastInstrumentIndex].setDynamicsRampOutput(Instrument::dynRampPressure);
+					}
+					else if (commands[2].compare("off") == 0) {
+						sharedData.instruments[lastInstrumentIndex].setDynamicsRampOutput(Instrument::dynRampOff);
+					}
+					else {
+						return std::make_pair(instrumentExists, genError("unknown argument to \"dynramp\""));
+					}
+				}
+				else if (commands[1].compare("dynrate") == 0) {
+					if (!hasDot) {
+						return std::make_pair(instrumentExists, genError("\"dynrate\" is a second level command, must be concatenated to instrument name with a dot"));
+					}
+					if (commands.size() != 3) {
+						return std::make_pair(instrumentExists, genError("\"dynrate\" command takes one argument, the control rate of crescendi and diminuendi in milliseconds"));
+					}
+					if (!isNumber(commands[2])) {
+						return std::make_pair(instrumentExists, genError(commands[2] + " is not a number"));
+					}
+					int dynRate = stoi(commands[2]);
+					if (dynRate <= 0) {
+						return std::make_pair(instrumentExists, genError("dynamics ramp control rate must be greater than zero"));
+					}
+					sharedData.instruments[lastInstrumentIndex].setDynamicsRampRate((int64_t)dynRate);
+				}
+				else if (commands[1].compare("glissrate") == 0) {
+					if (!hasDot) {
+						return std::make_pair(instrumentExists, genError("\"glissrate\" is a second level command, must be concatenated to instrument name with a dot"));
+					}
+					if (commands.size() != 3) {
+						return std::make_pair(instrumentExists, genError("\"glissrate\" command takes one argument, the control rate of glissandi in milliseconds"));
+					}
+					if (!isNumber(commands[2])) {
+						return std::make_pair(instrumentExists, genError(commands[2] + " is not a number"));
+					}
+					int glissRate = stoi(commands[2]);
+					if (glissRate <= 0) {
+						return std::make_pair(instrumentExists, genError("glissando control rate must be greater than zero"));
+					}
+					sharedData.instruments[lastInstrumentIndex].setGlissRate((int64_t)glissRate);
+				}
 				else {
 					if (parsingBars && barsIterCounter == 1 && !firstInstForBarsSet) {
 						firstInstForBarsIndex = lastInstrumentIndex;
@@ -8304,14 +8831,13 @@ void ofApp::sendBarToParts(int barIndex)
 	ofxOscMessage m;
 	m.setAddress("/bar");
 	m.addStringArg(sharedData.barsOrdered[barIndex]);
+	m.addIntArg(barIndex); // the parts map this to their own index of the bar, used by /copyline
 	sendToParts(m, false);
 	m.clear();
+	int prevBarIndex = getPrevDefinitionIndex(barIndex);
 	for (auto inst = sharedData.instruments.begin(); inst != sharedData.instruments.end(); ++inst) {
 		if (inst->second.sendToPart) {
-			m.setAddress("/line");
-			m.addStringArg(inst->second.barLines[barIndex]);
-			inst->second.scorePartSender.sendMessage(m, false);
-			m.clear();
+			inst->second.scorePartSender.sendMessage(genLineMessage(inst->first, barIndex, prevBarIndex), false);
 		}
 	}
 	m.setAddress("/bar");
@@ -8339,7 +8865,7 @@ void ofApp::sendSizeToPart(int instNdx, int size)
 	ofxOscMessage m;
 	m.setAddress("/size");
 	m.addIntArg(size);
-	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
+	sendSettingToPart(instNdx, m);
 }
 
 //--------------------------------------------------------------
@@ -8348,7 +8874,7 @@ void ofApp::sendNumBarsToPart(int instNdx, int numBars)
 	ofxOscMessage m;
 	m.setAddress("/numbars");
 	m.addIntArg(numBars);
-	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
+	sendSettingToPart(instNdx, m);
 }
 
 //--------------------------------------------------------------
@@ -8357,7 +8883,7 @@ void ofApp::sendAccOffsetToPart(int instNdx, float accOffset)
 	ofxOscMessage m;
 	m.setAddress("/accoffset");
 	m.addFloatArg(accOffset);
-	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
+	sendSettingToPart(instNdx, m);
 }
 
 //--------------------------------------------------------------
@@ -8376,7 +8902,7 @@ void ofApp::sendScoreChangeToPart(int instNdx, bool scoreChange)
 	ofxOscMessage m;
 	m.setAddress("/scorechange");
 	m.addBoolArg(scoreChange);
-	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
+	sendSettingToPart(instNdx, m);
 	m.clear();
 }
 
@@ -8386,28 +8912,272 @@ void ofApp::sendChangeBeatColorToPart(int instNdx, bool changeBeatColor)
 	ofxOscMessage m;
 	m.setAddress("/beatcolor");
 	m.addBoolArg(changeBeatColor);
+	sendSettingToPart(instNdx, m);
+	m.clear();
+}
+
+//--------------------------------------------------------------
+void ofApp::sendFullscreenToPart(int instNdx, bool fullscreen)
+{
+	ofxOscMessage m;
+	m.setAddress("/fullscreen");
+	m.addBoolArg(fullscreen);
+	sendSettingToPart(instNdx, m);
+	m.clear();
+}
+
+//--------------------------------------------------------------
+void ofApp::sendCursorToPart(int instNdx, bool cursor)
+{
+	ofxOscMessage m;
+	m.setAddress("/cursor");
+	m.addBoolArg(cursor);
+	sendSettingToPart(instNdx, m);
+	m.clear();
+}
+
+//--------------------------------------------------------------
+void ofApp::sendSettingToPart(int instNdx, ofxOscMessage m)
+{
+	// keep the last message of each setting so it can be sent again if the part needs to sync
+	partSettings[instNdx][m.getAddress()] = m;
 	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
+}
+
+//--------------------------------------------------------------
+int ofApp::getPrevDefinitionIndex(int barIndex)
+{
+	// if a bar redefines an existing one, the parts already have the previous definition
+	// this can be reused as long as the meter is the same, since that affects the note positions
+	auto prevBarIt = prevBarsIndexes.find(barIndex);
+	if (prevBarIt == prevBarsIndexes.end()) return -1;
+	int prevBarIndex = prevBarIt->second;
+	if (sharedData.numerator[barIndex] != sharedData.numerator[prevBarIndex] ||
+			sharedData.denominator[barIndex] != sharedData.denominator[prevBarIndex]) {
+		return -1;
+	}
+	return prevBarIndex;
+}
+
+//--------------------------------------------------------------
+ofxOscMessage ofApp::genLineMessage(int instNdx, int barIndex, int prevBarIndex)
+{
+	// if the line and clef of this instrument haven't changed since the previous definition of the bar
+	// we tell its part to copy it, so it doesn't parse and lay out its notes again
+	ofxOscMessage m;
+	Instrument& inst = sharedData.instruments[instNdx];
+	auto prevLine = inst.barLines.find(prevBarIndex);
+	if (prevBarIndex > -1 && prevLine != inst.barLines.end() &&
+			prevLine->second.compare(inst.barLines[barIndex]) == 0 &&
+			inst.getClef(barIndex) == inst.getClef(prevBarIndex)) {
+		m.setAddress("/copyline");
+		m.addStringArg("\\"+inst.getName());
+		m.addIntArg(prevBarIndex);
+		// in case the part missed the previous definition, it parses the line instead
+		m.addStringArg(inst.barLines[barIndex]);
+	}
+	else {
+		m.setAddress("/line");
+		m.addStringArg(inst.barLines[barIndex]);
+	}
+	return m;
+}
+
+//--------------------------------------------------------------
+void ofApp::requestPartSync(std::string host, int port)
+{
+	// a part that starts or reconnects while we're running requests the current state
+	// its host is matched to the hosts of the instruments by the sync thread, as resolving them can block
+	PartSyncRequest request;
+	request.host = host;
+	request.port = port;
+	for (auto it = instrumentOSCHostPorts.begin(); it != instrumentOSCHostPorts.end(); ++it) {
+		if (it->second.second == port) request.instHosts[it->first] = it->second.first;
+	}
+	if (request.instHosts.empty()) return;
+	partSyncer.push(request);
+}
+
+//--------------------------------------------------------------
+void ofApp::syncPart(PartSyncRequest& request)
+{
+	// we stream all the bars and loops of the matched instruments
+	// in the order they were created, so that the indexes in the part match ours
+	// the messages are sent by the sync thread, and end with the number of messages before /synced
+	// so the part can tell whether any of them were lost
+	std::vector<int> instNdxs;
+	for (int instNdx : request.instNdxs) {
+		// an instrument might have been cleared since the request was matched
+		if (sharedData.instruments.find(instNdx) != sharedData.instruments.end()) instNdxs.push_back(instNdx);
+	}
+	if (instNdxs.size() == 0) return;
+	std::vector<ofxOscMessage>& messages = request.messages;
+	messages.clear();
+	ofxOscMessage m;
+	for (int instNdx : instNdxs) {
+		m.setAddress("/initinst");
+		m.addIntArg(instNdx);
+		m.addStringArg(sharedData.instruments[instNdx].getName());
+		messages.push_back(m);
+		m.clear();
+	}
+	for (ofxOscMessage group : partGroups) {
+		messages.push_back(group);
+	}
+	for (int instNdx : instNdxs) {
+		for (auto it = partSettings[instNdx].begin(); it != partSettings[instNdx].end(); ++it) {
+			messages.push_back(it->second);
+		}
+	}
+	for (auto it = sharedData.loopsOrdered.begin(); it != sharedData.loopsOrdered.end(); ++it) {
+		int index = it->first;
+		if (sharedData.barsOrdered.find(index) == sharedData.barsOrdered.end()) {
+			m.setAddress("/loop");
+			m.addStringArg(it->second);
+			m.addIntArg(index);
+			for (unsigned i = 0; i < sharedData.loopData[index].size(); i++) {
+				m.addIntArg(sharedData.loopData[index].at(i));
+			}
+			messages.push_back(m);
+			m.clear();
+			continue;
+		}
+		m.setAddress("/bar");
+		m.addStringArg(sharedData.barsOrdered[index]);
+		m.addIntArg(index);
+		messages.push_back(m);
+		m.clear();
+		// the meter and tempo are sent as lines, so the part parses them the same way as in a bar definition
+		m.setAddress("/line");
+		m.addStringArg("\\time " + std::to_string(sharedData.numerator[index]) + "/" + std::to_string(sharedData.denominator[index]));
+		messages.push_back(m);
+		m.clear();
+		m.setAddress("/line");
+		m.addStringArg("\\tempo " + std::to_string(sharedData.tempoBaseForScore[index]) + (sharedData.BPMDisplayHasDot[index] ? "." : "") +
+				" = " + std::to_string(sharedData.BPMTempi[index]));
+		messages.push_back(m);
+		m.clear();
+		int prevBarIndex = getPrevDefinitionIndex(index);
+		for (int instNdx : instNdxs) {
+			m.setAddress("/clef");
+			m.addStringArg("\\"+sharedData.instruments[instNdx].getName());
+			m.addIntArg(sharedData.instruments[instNdx].getClef(index));
+			messages.push_back(m);
+			m.clear();
+			if (sharedData.instruments[instNdx].barLines.find(index) != sharedData.instruments[instNdx].barLines.end()) {
+				messages.push_back(genLineMessage(instNdx, index, prevBarIndex));
+			}
+		}
+		m.setAddress("/bar");
+		m.addIntArg(0);
+		messages.push_back(m);
+		m.clear();
+	}
+	m.setAddress("/synced");
+	m.addIntArg((int)messages.size());
+	messages.push_back(m);
+	m.clear();
+	// the messages below are also sent by the sequencer while it runs, so the part doesn't count them
+	m.setAddress("/loopndx");
+	m.addIntArg(sharedData.loopIndex);
+	messages.push_back(m);
+	m.clear();
+	m.setAddress("/seq");
+	m.addBoolArg(sequencer.isThreadRunning());
+	messages.push_back(m);
 	m.clear();
+	int countdown = sequencer.getPartsCountdown();
+	if (countdown > 0) {
+		m.setAddress("/countdown");
+		m.addIntArg(countdown);
+	}
+	else {
+		m.setAddress("/nocountdown");
+		m.addIntArg(1); // dummy arg
+	}
+	messages.push_back(m);
+	partSyncer.push(request);
+}
+
+//--------------------------------------------------------------
+static const char *latencyOutputNames[latencyNumOutputs] = {"osc", "midi", "pyo"};
+
+//--------------------------------------------------------------
+std::string ofApp::getLatencyStatsStr()
+{
+	// one line per instrument and output that has sent anything, followed by the totals per output
+	std::string str = "";
+	LatencyHistogram totals[latencyNumOutputs];
+	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
+		for (int i = 0; i < latencyNumOutputs; i++) {
+			const LatencyHistogram& hist = it->second.latency[i];
+			if (hist.getCount() == 0) continue;
+			totals[i].add(hist);
+			if (str.size() > 0) str += "\n";
+			str += it->second.getName() + " " + latencyOutputNames[i] + ": " + std::to_string(hist.getCount()) + " events, mean " +
+				std::to_string((int64_t)hist.getMean()) + "us, p50 " + std::to_string(hist.getPercentile(50)) + "us, p99 " +
+				std::to_string(hist.getPercentile(99)) + "us, max " + std::to_string(hist.getMax()) + "us";
+		}
+	}
+	if (str.size() == 0) return "no events have been sent yet";
+	for (int i = 0; i < latencyNumOutputs; i++) {
+		if (totals[i].getCount() == 0) continue;
+		str += "\nall " + std::string(latencyOutputNames[i]) + ": " + std::to_string(totals[i].getCount()) + " events, mean " +
+			std::to_string((int64_t)totals[i].getMean()) + "us, p50 " + std::to_string(totals[i].getPercentile(50)) + "us, p99 " +
+			std::to_string(totals[i].getPercentile(99)) + "us, max " + std::to_string(totals[i].getMax()) + "us";
+	}
+	return str;
 }
 
 //--------------------------------------------------------------
-void ofApp::sendFullscreenToPart(int instNdx, bool fullscreen)
+void ofApp::sendLatencyStats(std::string host, int port)
 {
+	// reply to a /stats query with one message per instrument and output
+	// with the name, the output, the number of events, and the mean, median, 99th percentile and maximum in microseconds
+	ofxOscSender sender;
+	sender.setup(host, port);
 	ofxOscMessage m;
-	m.setAddress("/fullscreen");
-	m.addBoolArg(fullscreen);
-	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
-	m.clear();
+	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
+		for (int i = 0; i < latencyNumOutputs; i++) {
+			const LatencyHistogram& hist = it->second.latency[i];
+			if (hist.getCount() == 0) continue;
+			m.setAddress("/stats");
+			m.addStringArg(it->second.getName());
+			m.addStringArg(latencyOutputNames[i]);
+			m.addInt64Arg((int64_t)hist.getCount());
+			m.addFloatArg((float)hist.getMean());
+			m.addInt64Arg(hist.getPercentile(50));
+			m.addInt64Arg(hist.getPercentile(99));
+			m.addInt64Arg(hist.getMax());
+			sender.sendMessage(m, false);
+			m.clear();
+		}
+	}
 }
 
 //--------------------------------------------------------------
-void ofApp::sendCursorToPart(int instNdx, bool cursor)
+void ofApp::dumpLatencyStats()
 {
-	ofxOscMessage m;
-	m.setAddress("/cursor");
-	m.addBoolArg(cursor);
-	sharedData.instruments[instNdx].scorePartSender.sendMessage(m, false);
-	m.clear();
+	// append a row per instrument and output, so the file holds the cumulative statistics over time
+	bool writeHeader = !std::ifstream(latencyDumpFile.c_str()).good();
+	std::ofstream file(latencyDumpFile.c_str(), std::ios::app);
+	if (!file.is_open()) {
+		cout << "could not open " << latencyDumpFile << " for the timing statistics, stopping the dump" << endl;
+		latencyDumpInterval = 0;
+		return;
+	}
+	if (writeHeader) file << "time_ms,instrument,output,count,min_us,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+	uint64_t now = ofGetElapsedTimeMillis();
+	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
+		for (int i = 0; i < latencyNumOutputs; i++) {
+			const LatencyHistogram& hist = it->second.latency[i];
+			if (hist.getCount() == 0) continue;
+			file << now << "," << it->second.getName() << "," << latencyOutputNames[i] << "," << hist.getCount() << ","
+				<< hist.getMin() << "," << hist.getMean() << "," << hist.getPercentile(50) << "," << hist.getPercentile(90) << ","
+				<< hist.getPercentile(99) << "," << hist.getPercentile(99.9) << "," << hist.getMax() << "\n";
+		}
+	}
+	file.close();
 }
 
 /******************** debugging functions *********************/
@@ -8839,6 +9609,10 @@ int ofApp::storeNewBar(std::string barName)
 		sharedData.numerator[barIndex] = 4;
 		sharedData.denominator[barIndex] = 4;
 	}
+	auto prevDefinition = sharedData.barsIndexes.find(barName);
+	if (prevDefinition != sharedData.barsIndexes.end()) {
+		prevBarsIndexes[barIndex] = prevDefinition->second;
+	}
 	sharedData.barsIndexes[barName] = barIndex;
 	sharedData.loopsIndexes[barName] = barIndex;
 	sharedData.loopsOrdered[barIndex] = barName;
@@ -8960,6 +9734,7 @@ void ofApp::deleteLastBar()
 	commandsMap[livelily][sharedData.loopsOrdered[bar].substr(1)[0]].erase(sharedData.loopsOrdered[bar]);
 	sharedData.loopsOrdered.erase(bar);
 	sharedData.loopsVariants.erase(bar);
+	prevBarsIndexes.erase(bar);
 	// sharedData.barLines is a std::map<std::string, std::string> so we get the correct key
 	// from the sharedData.barsOrdered std::map using the bar index as the key
 	sharedData.barLines.erase(sharedData.barsOrdered[bar]);
@@ -9296,6 +10071,16 @@ CmdOutput ofApp::functionFuncs(std::vector<std::string>& originalCommands)
 }
 
 /************* bar/loop index querying functions **************/
+//--------------------------------------------------------------
+void ofApp::setLoopData(int loopNdx, const std::vector<int>& bars)
+{
+	sharedData.loopData[loopNdx] = bars;
+	// the natural signs stored for the positions of this loop were searched in the bars it had before
+	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
+		it->second.invalidateLoopNaturalSigns(loopNdx);
+	}
+}
+
 //--------------------------------------------------------------
 int ofApp::getLastLoopIndex()
 {
@@ -9651,6 +10436,72 @@ CmdOutput ofApp::scoreCommands(std::vector<std::string>& originalCommands, int l
 		sequencer.setFinish(true);
 	}
 
+	else if (commands[0].compare("render") == 0) {
+		// runs the sequencer faster than real time and writes its output to a trace file
+		if (commands.size() != 3) {
+			return genError("\"render\" takes two arguments, the trace file and the duration in seconds");
+		}
+		if (!isFloat(commands[2]) || stof(commands[2]) <= 0) {
+			return genError("render duration must be a positive number of seconds");
+		}
+		if (sequencer.isThreadRunning()) {
+			return genError("can't render while the sequencer is running");
+		}
+		if (!sequencer.render(commands[1], (uint64_t)(stof(commands[2]) * 1000000))) {
+			return genError("could not open " + commands[1] + " for writing");
+		}
+	}
+
+	else if (commands[0].compare("bench") == 0) {
+		// times the layout passes and the drawing of the notes on synthetic scores
+		// and compares them to the baseline saved with "bench save", if there is one
+		if (commands.size() > 2 || (commands.size() == 2 && commands[1].compare("save") != 0)) {
+			return genError("\"bench\" takes no arguments, or \"save\" to store the results as the baseline");
+		}
+		float staffLength = scoreBackgroundWidth - sharedData.blankSpace - scoreXStartPnt;
+		scoreBench.setup(sharedData.scoreFontSize, sharedData.staffLinesDist, staffLength,
+				staffLength - (sharedData.staffLinesDist * NOTESXOFFSETCOEF));
+		scoreBench.run(scoreBatch);
+		std::string baselineFile = ofToDataPath(BENCHBASELINEFILE);
+		if (commands.size() == 2) {
+			if (!scoreBench.save(baselineFile)) {
+				return genError("could not open " + baselineFile + " for writing");
+			}
+			return genNote(scoreBench.getResultsStr() + "\nsaved as the baseline");
+		}
+		std::string regressions;
+		if (!scoreBench.compare(baselineFile, regressions)) {
+			return genNote(scoreBench.getResultsStr() + "\nno baseline to compare to, save one with \"bench save\"");
+		}
+		if (regressions.size() > 0) {
+			return genWarning(scoreBench.getResultsStr() + "\nslower than the baseline:\n" + regressions);
+		}
+		return genNote(scoreBench.getResultsStr());
+	}
+
+	else if (commands[0].compare("project") == 0) {
+		// projects the score to a second window, optionally full screen on a monitor
+		if (commands.size() > 2) {
+			return genError("\"project\" takes up to one argument, a monitor index or \"off\"");
+		}
+		if (commands.size() == 1) {
+			projectionMonitor = PROJECTIONWINDOWED;
+		}
+		else if (commands[1].compare("off") == 0) {
+			if (!projectionWindow) {
+				return genWarning("the score is not projected");
+			}
+			projectionMonitor = PROJECTIONCLOSED;
+		}
+		else if (isNumber(commands[1])) {
+			projectionMonitor = stoi(commands[1]);
+		}
+		else {
+			return genError("\"project\" takes a monitor index or \"off\"");
+		}
+		// the window is opened or closed in update(), and an open window is opened again if its monitor changes
+	}
+
 	else if (commands[0].compare("beatsin") == 0) {
 		if (commands.size() < 2) {
 			return genError("\"beatsin\" takes a number for beat countdown");
@@ -9902,6 +10753,7 @@ void ofApp::showScore(int ndx)
 			sharedData.showNotes = false;
 			sharedData.showPianoRoll = true;
 			sharedData.showScope = false;
+			pianoRollDirty = true;
 			break;
 		case 2:
 			sharedData.showNotes = false;
@@ -9943,6 +10795,7 @@ CmdOutput ofApp::maestroCommands(std::vector<std::string>& originalCommands, int
 				return genError("\"mainaddr\" takes one argument, the OSC address to receive sensor data");
 			}
 			maestroAddress = commands[i+1];
+			setOscRoutes();
 			if (!maestroToggleSet) receivingMaestro = true;
 			if (!oscReceiverIsSet) {
 				oscReceiver.setup(OSCPORT);
@@ -9956,6 +10809,7 @@ CmdOutput ofApp::maestroCommands(std::vector<std::string>& originalCommands, int
 				return genError("\"toggleaddr\" takes one argument, the OSC address to receive a 0 or 1");
 			}
 			maestroToggleAddress = commands[i+1];
+			setOscRoutes();
 			maestroToggleSet = true;
 			if (!oscReceiverIsSet) {
 				oscReceiver.setup(OSCPORT);
@@ -9969,6 +10823,7 @@ CmdOutput ofApp::maestroCommands(std::vector<std::string>& originalCommands, int
 				return genError("\"reset\" takes one argument, the OSC address to receive sensor data");
 			}
 			maestroLevareAddress = commands[i+1];
+			setOscRoutes();
 			if (!oscReceiverIsSet) {
 				oscReceiver.setup(OSCPORT);
 				oscReceiverIsSet = true;
@@ -10006,13 +10861,28 @@ CmdOutput ofApp::maestroCommands(std::vector<std::string>& originalCommands, int
 			if (val < 0) {
 				return genError("maestro beat threshold must be positive");
 			}
-			maestroValThresh = val;
+			maestro.setThreshold(val);
 			if (!oscReceiverIsSet) {
 				oscReceiver.setup(OSCPORT);
 				oscReceiverIsSet = true;
 			}
 			i++;
 		}
+
+		else if (commands[i].compare("sensitivity") == 0) {
+			if (commands.size() < i + 2) {
+				return genError("\"sensitivity\" takes one argument, the number of standard deviations a peak must exceed the mean of the recent values");
+			}
+			if (!isFloat(commands[i+1])) {
+				return genError("argument to \"sensitivity\" must be a number");
+			}
+			float val = stof(commands[i+1]);
+			if (val < 0) {
+				return genError("maestro sensitivity must be positive");
+			}
+			maestro.setSensitivity(val);
+			i++;
+		}
 	}
 	return cmdOutput;
 }
@@ -10028,6 +10898,7 @@ bool ofApp::isScoreVisible()
 void ofApp::initializeInstrument(std::string instName)
 {
 	int maxInstIndex = (int)sharedData.instruments.size();
+	pianoRollDirty = true;
 	sharedData.instrumentIndexes[instName] = maxInstIndex;
 	sharedData.instruments[maxInstIndex] = Instrument();
 	sharedData.instruments[maxInstIndex].setID(maxInstIndex);
@@ -10239,18 +11110,44 @@ void ofApp::resetScoreYOffset()
 }
 
 //--------------------------------------------------------------
-void ofApp::setNotePositions(int barIndex)
+void ofApp::setLayoutDirty(int barIndex)
 {
 	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
-		if (!it->second.getCopied(barIndex)) it->second.setNotePositions(barIndex);
+		if (!it->second.getCopied(barIndex)) it->second.setLayoutDirty(barIndex);
 	}
 }
 
 //--------------------------------------------------------------
-void ofApp::setNotePositions(int barIndex, int numBars)
+void ofApp::layoutBars(const std::vector<int>& bars)
 {
+	// lay out the bars that are out of date, and then update the staff positions to fit them
+	std::vector<Instrument*> insts;
 	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
-		if (!it->second.getCopied(barIndex)) it->second.setNotePositions(barIndex, numBars);
+		if (it->second.hasLayoutDirty(bars)) insts.push_back(&it->second);
+	}
+	if (insts.empty()) return;
+	// the layout of each instrument is independent of the others, so instruments are laid out in parallel
+	// a layout pass of a bar reads its neighbouring bars, so the bars of an instrument are laid out by a single thread
+	// the fonts are only measured on this thread, when the notes are set or the font size changes
+	std::atomic<size_t> nextInst(0);
+	auto layout = [&]() {
+		size_t i;
+		while ((i = nextInst.fetch_add(1)) < insts.size()) {
+			insts[i]->layoutDirtyBars(bars);
+		}
+	};
+	size_t numThreads = std::min((size_t)std::max(1u, std::thread::hardware_concurrency()), insts.size());
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < numThreads; i++) {
+		workers.push_back(std::thread(layout));
+	}
+	layout();
+	// all the layouts are done before returning, so the next draw never sees a partial one
+	for (auto it = workers.begin(); it != workers.end(); ++it) {
+		it->join();
+	}
+	for (auto it = bars.begin(); it != bars.end(); ++it) {
+		calculateStaffPositions(*it, false);
 	}
 }
 
@@ -10308,6 +11205,7 @@ void ofApp::calculateStaffPositions(int bar, bool windowChanged)
 //--------------------------------------------------------------
 void ofApp::swapScorePosition(int orientation)
 {
+	pianoRollDirty = true;
 	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
 		it->second.setScoreOrientation(orientation);
 	}
@@ -10446,6 +11344,7 @@ void ofApp::swapScorePosition(int orientation)
 //--------------------------------------------------------------
 void ofApp::setScoreSizes()
 {
+	scoreFboDirty = true;
 	// for a 35 font size the staff lines distance is 10
 	sharedData.longestInstNameWidth = 0;
 	for (auto it = sharedData.instruments.begin(); it != sharedData.instruments.end(); ++it) {
@@ -10459,11 +11358,12 @@ void ofApp::setScoreSizes()
 	scoreXStartPnt = sharedData.longestInstNameWidth + (sharedData.blankSpace * 1.5);
 	setScoreCoords();
 	if (sharedData.barsIndexes.size() > 0) {
+		// the Notes objects mark the bars whose layout is affected by the new sizes
+		// and these are laid out again when they are about to be shown
 		for (auto it = sharedData.barsIndexes.begin(); it != sharedData.barsIndexes.end(); ++it) {
 			for (auto it2 = sharedData.instruments.begin(); it2 != sharedData.instruments.end(); ++it2) {
 				it2->second.setMeter(it->second, sharedData.numerator[it->second],
 						sharedData.denominator[it->second], sharedData.numBeats[it->second]);
-				it2->second.setNotePositions(it->second);
 			}
 		}
 	}
@@ -10498,6 +11398,11 @@ void ofApp::exit()
 {
 	// should print a warning message first
 	sequencer.stopNow();
+	sequencer.tracer.stop();
+	tracePlayer.stop();
+	if (projectionWindow) closeProjectionWindow();
+	if (oscReceiverIsSet) oscReceiver.stop();
+	partSyncer.stop();
 	ofxOscMessage m;
 	m.setAddress("/exit");
 	m.addIntArg(1);
@@ -10556,6 +11461,7 @@ void ofApp::mouseExited(int x, int y)
 void ofApp::resizeWindow()
 {
 	setPaneCoords();
+	pianoRollDirty = true;
 	if (scoreOrientation == 0) {
 		scoreBackgroundWidth = sharedData.screenWidth / 2;
 		scoreBackgroundHeight = sharedData.tracebackBase - cursorHeight;
@@ -10573,6 +11479,7 @@ void ofApp::resizeWindow()
 	}
 	resetScoreYOffset();
 	setScoreSizes();
+	layoutBars({getLastBarIndex()});
 	calculateStaffPositions(getLastBarIndex(), true);
 }
 
@@ -10628,8 +11535,21 @@ void ofApp::audioOut(ofSoundBuffer & buffer)
 #ifdef USEPYO
 	if (pyoSet) {
 		// process and get new audio samples from pyo
-		sharedData.pyo.process(&buffer[0]);
-		if (sharedData.showScope) scopeBuffer = buffer;
+		sharedData.pyo.process(&buffer[0], ofGetElapsedTimeMicros());
+		if (sharedData.showScope) {
+			// pass the output to the oscilloscope without allocating or locking
+			ScopeFrame frames[SCOPECHUNKSIZE];
+			size_t numChannels = buffer.getNumChannels();
+			size_t rightChan = (numChannels > 1 ? 1 : 0);
+			for (size_t i = 0; i < buffer.getNumFrames(); i += SCOPECHUNKSIZE) {
+				size_t numFrames = std::min((size_t)SCOPECHUNKSIZE, buffer.getNumFrames() - i);
+				for (size_t j = 0; j < numFrames; j++) {
+					frames[j].left = buffer[(i+j)*numChannels];
+					frames[j].right = buffer[((i+j)*numChannels)+rightChan];
+				}
+				scopeQueue.push(frames, numFrames);
+			}
+		}
 	}
 #endif
 }
@@ -10853,6 +11773,8 @@ Function::~Function()
 void Sequencer::setup(SharedData *sData)
 {
 	sharedData = sData;
+	latencyResetRequested = false;
+	partsCountdown = 0;
 	runSequencer = false;
 	updateSequencer = false;
 	sequencerUpdated = false;
@@ -10872,6 +11794,9 @@ void Sequencer::setup(SharedData *sData)
 	countdown = false;
 	countdownCounter = 0;
 	midiTuneVal = 440;
+	offline = false;
+	virtualTime = 0;
+	renderEndTime = 0;
 	oscSender.setup(HOST, OFSENDPORT);
 	timer.setPeriodicEvent(100000); // 100 us
 }
@@ -10905,12 +11830,12 @@ void Sequencer::setSendMidiClock(bool sendMidiClockState)
 void Sequencer::sendAllNotesOff()
 {
 	for (std::map<int, Instrument>::iterator it = sharedData->instruments.begin(); it != sharedData->instruments.end(); ++it) {
-		if (it->second.isMidi()) midiOut.sendControlChange(it->second.getMidiChan(), 120, 0);
+		if (it->second.isMidi()) sendMidi(-1, 0xB0 + it->second.getMidiChan() - 1, 120, 0, 3);
 		else {
 			ofxOscMessage m;
 			m.setAddress("/" + it->second.getName() + "/dynamics");
 			m.addIntArg(0);
-			oscSender.sendMessage(m, false);
+			sendOsc(m);
 			m.clear();
 		}
 	}
@@ -10933,14 +11858,24 @@ void Sequencer::stop()
 //--------------------------------------------------------------
 void Sequencer::stopNow()
 {
+	// the thread is joined before the notes off are sent, so that only one thread sends and traces at a time
+	// at the end of an offline render this is called from the sequencer thread, which is then only told to stop
+	if (isCurrentThread()) stopThread();
+	else waitForThread(true);
+	// a reset that was requested too late for the thread to see it
+	if (latencyResetRequested.exchange(false)) resetLatencyHistograms();
 	sendAllNotesOff();
-	stopThread();
-	if (sendMidiClock) midiOut.sendMidiByte(0xFC); // Stop MIDI byte
+	if (sendMidiClock) sendMidi(-1, 0xFC, 0, 0, 1); // Stop MIDI byte
 	if (!mustStopCalled) onNextStartMidiByte = 0xFB; // Continue MIDI byte
 	else mustStopCalled = false;
 	runSequencer = sequencerRunning = false;
 	beatCounter = 0;
 	sendSequencerStateToParts(false);
+	if (offline) {
+		tracer.stop();
+		restoreSnapshot();
+		offline = false;
+	}
 }
 
 //--------------------------------------------------------------
@@ -11021,145 +11956,431 @@ float Sequencer::mapVal(float inVal, float fromLow, float fromHigh, float toLow,
 //--------------------------------------------------------------
 void Sequencer::startGlissando(int instNdx, int bar, int barDataCounter)
 {
-	sharedData->instruments.at(instNdx).setGlissandoStart(true);
-	sharedData->instruments.at(instNdx).glissStart.clear();
-	sharedData->instruments.at(instNdx).glissEnd.clear();
-	sharedData->instruments.at(instNdx).glissSteps.clear();
-	// if the isntrument sends MIDI, then we have to determine the pitch bend value we need to cover
-	// but we should bare in mind that the user might have set a specific tuning
-	// in which case we have to compensate for that
-	int note = sharedData->instruments.at(instNdx).getBarDataCounter();
-	auto itBegin = sharedData->instruments.at(instNdx).notes.at(bar).at(note).begin();
-	auto itEnd = sharedData->instruments.at(instNdx).notes.at(bar).at(note).end();
-	for (auto it = itBegin; it != itEnd; ++it) {
-		sharedData->instruments.at(instNdx).glissStart.push_back(*it);
-	}
-	int nextNote = sharedData->instruments.at(instNdx).getBarDataCounter() + 1;
+	// the whole glissando is rendered here to a table of output values, one frame every glissRate ms
+	// so that runGlissando() only has to look up the current frame and send it
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	int note = inst.getBarDataCounter();
+	int nextNote = note + 1;
 	int nextBar = bar;
-	if (nextNote >= (int)sharedData->instruments.at(instNdx).notes.at(bar).size()) {
+	if (nextNote >= (int)inst.notes.at(bar).size()) {
 		nextNote = 0;
 		nextBar++;
 		if (nextBar >= (int)sharedData->loopData.at(sharedData->loopIndex).size()) {
 			nextBar = 1; // 1 because 0 is the default first bar with a 4/4 tacet
 		}
 	}
-	itBegin = sharedData->instruments.at(instNdx).notes.at(nextBar).at(nextNote).begin();
-	itEnd = sharedData->instruments.at(instNdx).notes.at(nextBar).at(nextNote).end();
-	for (auto it = itBegin; it != itEnd; ++it) {
-		sharedData->instruments.at(instNdx).glissEnd.push_back(*it);
-	}
+	const std::vector<float>& glissStart = inst.notes.at(bar).at(note);
+	const std::vector<float>& glissEnd = inst.notes.at(nextBar).at(nextNote);
 	// make sure both vectors have data
-	if (sharedData->instruments.at(instNdx).glissStart.empty() || sharedData->instruments.at(instNdx).glissEnd.empty()) {
-		sharedData->instruments.at(instNdx).setGlissandoStart(false);
+	if (glissStart.empty() || glissEnd.empty()) {
+		inst.setGlissandoStart(false);
 		return;
 	}
-	// check if the two vectors dont't have the same size
-	if (sharedData->instruments.at(instNdx).glissStart.size() != sharedData->instruments.at(instNdx).glissEnd.size()) {
-		int diff = (int)sharedData->instruments.at(instNdx).glissStart.size() - (int)sharedData->instruments.at(instNdx).glissEnd.size();
-		if (diff < 0) {
-			for (int i = diff; i < 0; i++) {
-				sharedData->instruments.at(instNdx).glissEnd.pop_back();
-			}
-		}
-		else {
-			int numNotesPerGliss = (int)sharedData->instruments.at(instNdx).glissStart.size() / (int)sharedData->instruments.at(instNdx).glissEnd.size();
-			int remainingNotes = (int)sharedData->instruments.at(instNdx).glissStart.size() % (int)sharedData->instruments.at(instNdx).glissEnd.size();
-			size_t endSize = sharedData->instruments.at(instNdx).glissEnd.size();
-			float lastNote = sharedData->instruments.at(instNdx).glissEnd.back();
-			std::vector<float> v = {sharedData->instruments.at(instNdx).glissEnd.begin(), sharedData->instruments.at(instNdx).glissEnd.end()};
-			for (size_t i = 0; i < endSize; i++) {
-				// j starts from 1 because we alreary have one note stored in the vector, so we want to add the remaining
-				// for example, if we have a glissando from five notes to two, the end vector should change to five
-				// which means that the parent loop will run twice, and the loop below once, which results in adding two elements
-				// the remaining one element is added further down in the loop with remainingNotes
-				for (int j = 1; j < numNotesPerGliss; j++) {
-					// insert elements instead of pushing back to maintain a more balanced glissando where notes don't mingle
-					sharedData->instruments.at(instNdx).glissEnd.insert(sharedData->instruments.at(instNdx).glissEnd.begin()+(i*numNotesPerGliss)+j, v.at(i));
-				}
-			}
-			for (int i = 0; i < remainingNotes; i++) {
-				sharedData->instruments.at(instNdx).glissEnd.push_back(lastNote);
-			}
-		}
-	}
-	std::vector<int> glissNumSteps;
-	for (size_t i = 0; i < sharedData->instruments.at(instNdx).glissStart.size(); i++) {
-		float glissSpan = sharedData->instruments.at(instNdx).glissEnd.at(i) - sharedData->instruments.at(instNdx).glissStart.at(i);
-		if (sharedData->instruments.at(instNdx).isMidi() && (glissSpan > 12 || glissSpan < -12)) {
+	// in MIDI we can't have polyphony in glissandi because this is done with the Pitch Bend message
+	// and that is a single message for the entire instrument, so we use the first voice only
+	int numVoices = (inst.isMidi() ? 1 : (int)glissStart.size());
+	// if there are more start than end notes, each end note is the target of numNotesPerGliss start notes
+	// in the order they are written so that notes don't mingle, and the remaining start notes go to the last end note
+	// if there are fewer start notes, the extra end notes are ignored
+	int numNotesPerGliss = std::max(1, (int)glissStart.size() / (int)glissEnd.size());
+	int64_t durMs = (int64_t)inst.glissDursMs.at(bar).at(note);
+	int64_t rate = std::max((int64_t)1, inst.getGlissRate());
+	int numFrames = (int)(durMs / rate) + 1;
+	inst.glissTable.resize(numFrames * numVoices);
+	for (int i = 0; i < numVoices; i++) {
+		int endNdx = std::min(i / numNotesPerGliss, (int)glissEnd.size()-1);
+		float glissSpan = glissEnd.at(endNdx) - glissStart.at(i);
+		if (inst.isMidi() && (glissSpan > 12 || glissSpan < -12)) {
 			if (glissSpan > 0) glissSpan = 12;
 			else glissSpan = -12;
 		}
-		float glissStep = glissSpan / ((float)sharedData->instruments.at(instNdx).glissDursMs.at(bar).at(note) / (float)GLISSGRAIN);
-		int numSteps = abs(glissSpan / glissStep);
-		sharedData->instruments.at(instNdx).glissSteps.push_back(glissStep);
-		glissNumSteps.push_back(numSteps);
+		for (int frame = 0; frame < numFrames; frame++) {
+			float pos = (numFrames > 1 ? (float)frame / (float)(numFrames-1) : 1.0);
+			if (inst.isMidi()) {
+				// the pitch bend covers the distance from the starting note
+				inst.glissTable[frame*numVoices+i] = mapVal(glissSpan * pos, -12, 12, -8192, 8191);
+			}
+			else {
+				float midiNote = glissStart.at(i) + (glissSpan * pos);
+				if (inst.sendMIDI() && !inst.sendToPython()) inst.glissTable[frame*numVoices+i] = midiNote;
+				else inst.glissTable[frame*numVoices+i] = midiToFreq(midiNote);
+			}
+		}
 	}
-	sharedData->instruments.at(instNdx).glissDurMs = sharedData->instruments.at(instNdx).glissDursMs.at(bar).at(note);
-	sharedData->instruments.at(instNdx).glissCounter = 0;
-	int glissMaxNumSteps = *std::max_element(glissNumSteps.begin(), glissNumSteps.end());
-	sharedData->instruments.at(instNdx).glissTimeDiff = sharedData->instruments.at(instNdx).glissDurMs / glissMaxNumSteps;
-	sharedData->instruments.at(instNdx).glissTimeStamp = ofGetElapsedTimeMillis();
-	sharedData->instruments.at(instNdx).glissStartTimeStamp = ofGetElapsedTimeMillis();
+	inst.glissAddress = "/" + inst.getName() + "/note";
+	inst.glissNumVoices = numVoices;
+	inst.glissNumFrames = numFrames;
+	inst.glissFrame = -1;
+	inst.glissDurMs = durMs;
+	inst.glissStartTimeStamp = (int64_t)now();
+	inst.setGlissandoStart(true);
+	addControlRamp(instNdx);
 }
 
 //--------------------------------------------------------------
-void Sequencer::runGlissando(int instNdx, int bar)
+void Sequencer::runGlissando(int instNdx)
 {
 	// here we run a glissando that has been started by the function above
-	int64_t timeStamp = ofGetElapsedTimeMillis();
-	int64_t diff = timeStamp - sharedData->instruments.at(instNdx).glissTimeStamp;
-	if (sharedData->instruments.at(instNdx).getGlissandoStart() &&
-			(sharedData->instruments.at(instNdx).glissCounter == 0 || (diff >= sharedData->instruments.at(instNdx).glissTimeDiff))) {
-		// here we run the glissando, and when we reach its target, we set the glissandoStart to false
-		if (sharedData->instruments.at(instNdx).isMidi()) {
-			// in MIDI we can't have polyphony in glissandi because this is done with the Pitch Bend message
-			// and that is a single message for the entire instrument
-			// so we take the first item of the glissStart and other vectors
-			float midiNote = sharedData->instruments.at(instNdx).glissStart.at(0) + (sharedData->instruments.at(instNdx).glissSteps.at(0) * sharedData->instruments.at(instNdx).glissCounter);
-			midiOuts[midiPortsMap[sharedData->instruments.at(instNdx).getMidiPort()]].sendPitchBend(sharedData->instruments.at(instNdx).getMidiChan(), mapVal(midiNote, -12, 12, -8192, 8191));
+	// the frame is derived from the elapsed time, so a late tick doesn't delay the rest of the glissando
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	int64_t elapsed = ((int64_t)now() - inst.glissStartTimeStamp) / 1000;
+	int frame = (int)std::min((int64_t)inst.glissNumFrames-1, elapsed / std::max((int64_t)1, inst.getGlissRate()));
+	if (elapsed >= inst.glissDurMs) frame = inst.glissNumFrames - 1;
+	if (frame <= inst.glissFrame) return;
+	inst.glissFrame = frame;
+	const float *values = &inst.glissTable[frame*inst.glissNumVoices];
+	if (inst.isMidi()) {
+		sendMidi(midiPortsMap[inst.getMidiPort()], 0xE0 + inst.getMidiChan() - 1, (int)values[0] & 0x7F, ((int)values[0] >> 7) & 0x7F, 3);
+	}
+	else if (inst.sendToPython()) {
+#ifdef USEPYO
+		pushPyoParam(inst.pyoFreqBinding, values, inst.glissNumVoices, (uint64_t)(inst.glissStartTimeStamp + (frame * inst.getGlissRate() * 1000)));
+#endif
+	}
+	else {
+		ofxOscMessage m;
+		m.setAddress(inst.glissAddress);
+		for (int i = 0; i < inst.glissNumVoices; i++) {
+			m.addFloatArg(values[i]);
 		}
-		else {
-			ofxOscMessage m;
-			std::string s = "";
-			m.setAddress("/" + sharedData->instruments.at(instNdx).getName() + "/note");
-			if (sharedData->instruments.at(instNdx).sendToPython() && sharedData->instruments.at(instNdx).glissStart.size() > 1) {
-				s += "[";
-			}
-			for (size_t i = 0; i < sharedData->instruments.at(instNdx).glissStart.size(); i++) {
-				float midiNote = sharedData->instruments.at(instNdx).glissStart.at(i) + (sharedData->instruments.at(instNdx).glissSteps.at(i) * sharedData->instruments.at(instNdx).glissCounter);
-				if (sharedData->instruments.at(instNdx).sendToPython()) {
+		sendOsc(m);
+	}
+	// when we reach the target of the glissando we set the glissandoStart to false
+	if (frame == inst.glissNumFrames - 1) {
+		inst.setGlissandoStart(false);
+	}
+}
+
+//--------------------------------------------------------------
+void Sequencer::startDynamicsRamp(int instNdx, int bar, int barDataCounter)
+{
+	// the parser stores the dynamic the ramp is heading to and its duration for every note within a crescendo or diminuendo
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	if (inst.getDynamicsRampOutput() == Instrument::dynRampOff) return;
+	inst.dynRampStartVal = inst.dynamics.at(bar).at(barDataCounter);
+	inst.dynRampEndVal = getDynamicsRampTarget(instNdx, bar, barDataCounter);
+	inst.dynRampDurMs = inst.midiDynamicsRampDurs.at(bar).at(barDataCounter);
+	inst.dynRampStartTimeStamp = (int64_t)now();
+	inst.dynRampFrame = 0; // the first value has already been sent with the note
+	inst.setDynamicsRampStart(true);
+	addControlRamp(instNdx);
+}
+
+//--------------------------------------------------------------
+void Sequencer::runDynamicsRamp(int instNdx)
+{
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	int64_t elapsed = ((int64_t)now() - inst.dynRampStartTimeStamp) / 1000;
+	int64_t rate = std::max((int64_t)1, inst.getDynamicsRampRate());
+	int frame = (int)(std::min(elapsed, inst.dynRampDurMs) / rate);
+	bool done = elapsed >= inst.dynRampDurMs;
+	if (frame <= inst.dynRampFrame && !done) return;
+	inst.dynRampFrame = frame;
+	float pos = (done ? 1.0 : (float)elapsed / (float)inst.dynRampDurMs);
+	float val = inst.dynRampStartVal + ((inst.dynRampEndVal - inst.dynRampStartVal) * pos);
+	int midiVal = std::min(127, std::max(0, (int)((val * 127.0) + 0.5)));
+	if (done) inst.setDynamicsRampStart(false);
+	if (sendsDynamicsController(instNdx)) {
+		sendDynamicsController(instNdx, val);
+	}
+	else if (inst.sendToPython()) {
 #ifdef USEPYO
-					if (i > 0) s += ",";
-					s += std::to_string(midiToFreq(midiNote));
+		pushPyoParam(inst.pyoAmpBinding, &val, 1, (uint64_t)(inst.dynRampStartTimeStamp + (std::min(elapsed, inst.dynRampDurMs) * 1000)));
 #endif
-				}
-				else {
-					if (sharedData->instruments.at(instNdx).sendMIDI()) m.addFloatArg(midiNote);
-					else m.addFloatArg(midiToFreq(midiNote));
-				}
-			}
-			if (sharedData->instruments.at(instNdx).sendToPython()) {
+	}
+	else {
+		ofxOscMessage m;
+		m.setAddress("/" + inst.getName() + "/dynamics");
+		if (inst.sendMIDI()) m.addIntArg(midiVal);
+		else m.addFloatArg(val);
+		sendOsc(m);
+	}
+}
+
+//--------------------------------------------------------------
+float Sequencer::getDynamicsRampTarget(int instNdx, int bar, int barDataCounter)
+{
+	// a ramp heads to the dynamic of the next note, which the parser stores for all notes but the last of a bar
+	// for the last note, the next one is the first of the bar the sequencer plays next
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	if (barDataCounter < (int)inst.dynamics.at(bar).size() - 1) return inst.dynamicsRamps.at(bar).at(barDataCounter);
+	// thisBarIndex has already moved to the next bar of the loop, which is the first of the next loop if one has been called
+	int loop = sharedData->loopIndex;
+	unsigned barNdx = thisBarIndex;
+	if (updateSequencer && thisBarIndex == 0) loop = sharedData->tempLoopIndex;
+	auto loopIt = sharedData->loopData.find(loop);
+	if (loopIt == sharedData->loopData.end() || barNdx >= loopIt->second.size()) return inst.dynamicsRamps.at(bar).at(barDataCounter);
+	auto nextBar = inst.dynamics.find(loopIt->second.at(barNdx));
+	if (nextBar == inst.dynamics.end() || nextBar->second.empty()) return inst.dynamicsRamps.at(bar).at(barDataCounter);
+	return nextBar->second.at(0);
+}
+
+//--------------------------------------------------------------
+bool Sequencer::sendsDynamicsController(int instNdx)
+{
+	// MIDI instruments ramp with CC 11 by default, other instruments only if a MIDI output has been set for their ramps
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	if (inst.getDynamicsRampOutput() == Instrument::dynRampOff) return false;
+	return inst.isMidi() || inst.getDynamicsRampOutput() != Instrument::dynRampDefault;
+}
+
+//--------------------------------------------------------------
+void Sequencer::sendDynamicsController(int instNdx, float val)
+{
+	// MIDI values are sent only when they change
+	Instrument& inst = sharedData->instruments.at(instNdx);
+	int midiVal = std::min(127, std::max(0, (int)((val * 127.0) + 0.5)));
+	if (midiVal == inst.dynRampLastMidiVal) return;
+	inst.dynRampLastMidiVal = midiVal;
+	int port = midiPortsMap[inst.getMidiPort()];
+	switch (inst.getDynamicsRampOutput()) {
+		case Instrument::dynRampCC7:
+			sendMidi(port, 0xB0 + inst.getMidiChan() - 1, 7, midiVal, 3);
+			break;
+		case Instrument::dynRampPressure:
+			sendMidi(port, 0xD0 + inst.getMidiChan() - 1, midiVal, 0, 2);
+			break;
+		default:
+			sendMidi(port, 0xB0 + inst.getMidiChan() - 1, 11, midiVal, 3);
+			break;
+	}
+}
+
+//--------------------------------------------------------------
+void Sequencer::addControlRamp(int instNdx)
+{
+	if (std::find(rampInsts.begin(), rampInsts.end(), instNdx) == rampInsts.end()) {
+		rampInsts.push_back(instNdx);
+	}
+}
+
+//--------------------------------------------------------------
+void Sequencer::recordLatency(int instNdx)
+{
+	// the lateness of a step is the time from when it should have fired to when its messages are out
+	// which is meaningless when rendering on the virtual clock
+	if (offline) return;
+	Instrument& inst = sharedData->instruments[instNdx];
+	int64_t lateness = (int64_t)now() - (int64_t)inst.getTimeStamp() - inst.getDelayTime();
+	int output = latencyOsc;
+	if (inst.isMidi()) output = latencyMidi;
+	else if (inst.sendToPython()) output = latencyPyo;
+	inst.latency[output].record(lateness);
+}
+
+//--------------------------------------------------------------
+void Sequencer::resetLatency()
+{
+	// the sequencer thread is the only writer of the histograms, so it's asked to clear them while it runs
+	if (isThreadRunning()) latencyResetRequested = true;
+	else resetLatencyHistograms();
+}
+
+//--------------------------------------------------------------
+void Sequencer::resetLatencyHistograms()
+{
+	for (auto it = sharedData->instruments.begin(); it != sharedData->instruments.end(); ++it) {
+		for (int i = 0; i < latencyNumOutputs; i++) {
+			it->second.latency[i].reset();
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void Sequencer::sendOsc(ofxOscMessage& m)
+{
+	if (!offline) oscSender.sendMessage(m, false);
+	if (tracer.isRecording()) tracer.recordOsc(now(), m);
+}
+
+//--------------------------------------------------------------
+void Sequencer::sendMidi(int port, int status, int data1, int data2, int numBytes)
+{
+	// port is the index in midiOuts, or -1 for midiOut
+	if (!offline) {
+		std::vector<unsigned char> bytes = {(unsigned char)status, (unsigned char)data1, (unsigned char)data2};
+		bytes.resize(numBytes);
+		if (port < 0) midiOut.sendMidiBytes(bytes);
+		else midiOuts[port].sendMidiBytes(bytes);
+	}
+	if (tracer.isRecording()) tracer.recordMidi(now(), port, (unsigned char)status, (unsigned char)data1, (unsigned char)data2, numBytes);
+}
+
 #ifdef USEPYO
-				if (s[0] == '[') s += "]";
-				std::string pyoStr = sharedData->instruments.at(instNdx).getName() + ".setFreq(" + s + ")";
-				sharedData->pyo.exec(pyoStr.c_str(), 0);
+//--------------------------------------------------------------
+void Sequencer::pushPyoParam(int binding, const float *values, int len, uint64_t timeStamp)
+{
+	if (!offline) sharedData->pyo.pushParam(binding, values, len, timeStamp);
+	if (tracer.isRecording()) tracer.recordPyo(now(), binding, values, len, timeStamp);
+}
 #endif
-			}
-			else {
-				oscSender.sendMessage(m, false);
-			}
+
+//--------------------------------------------------------------
+void Sequencer::callBoundFunction(std::string name)
+{
+	// bound functions are called when rendering too, as they might change what follows
+	if (tracer.isRecording()) tracer.recordFunction(now(), name);
+	((ofApp*)ofGetAppPtr())->parseString(name, 1, 1);
+}
+
+//--------------------------------------------------------------
+uint64_t Sequencer::now()
+{
+	if (offline) return virtualTime;
+	return ofGetElapsedTimeMicros();
+}
+
+//--------------------------------------------------------------
+bool Sequencer::render(std::string fileName, uint64_t durUs)
+{
+	// run the sequencer on a virtual clock that jumps from event to event
+	// with all its output going to a trace file instead of the OSC, MIDI, and Pyo outputs
+	virtualTime = ofGetElapsedTimeMicros();
+	if (!tracer.start(fileName, virtualTime, true)) return false;
+	// the render moves the playback position like playing does, so it is put back when the render stops
+	saveSnapshot();
+	renderEndTime = virtualTime + durUs;
+	sharedData->PPQNTimeStamp = virtualTime;
+	offline = true;
+	start();
+	return true;
+}
+
+//--------------------------------------------------------------
+void Sequencer::saveSnapshot()
+{
+	renderSnapshot.thisBarIndex = thisBarIndex;
+	renderSnapshot.beatCounter = beatCounter;
+	renderSnapshot.tickCounter = tickCounter;
+	renderSnapshot.onNextStartMidiByte = onNextStartMidiByte;
+	renderSnapshot.firstIter = firstIter;
+	renderSnapshot.endOfBar = endOfBar;
+	renderSnapshot.sendBeatVizInfoCounter = sendBeatVizInfoCounter;
+	renderSnapshot.finished = finished;
+	renderSnapshot.mustStop = mustStop;
+	renderSnapshot.mustStopCalled = mustStopCalled;
+	renderSnapshot.muteChecked = muteChecked;
+	renderSnapshot.countdown = countdown;
+	renderSnapshot.countdownCounter = countdownCounter;
+	renderSnapshot.updateSequencer = updateSequencer;
+	renderSnapshot.sequencerUpdated = sequencerUpdated;
+	renderSnapshot.sharedThisBarIndex = sharedData->thisBarIndex;
+	renderSnapshot.sharedBeatCounter = sharedData->beatCounter;
+	renderSnapshot.loopIndex = sharedData->loopIndex;
+	renderSnapshot.barCounter = sharedData->barCounter;
+	renderSnapshot.animate = sharedData->animate;
+	renderSnapshot.setAnimation = sharedData->setAnimation;
+	renderSnapshot.beatAnimate = sharedData->beatAnimate;
+	renderSnapshot.setBeatAnimation = sharedData->setBeatAnimation;
+	renderSnapshot.beatViz = sharedData->beatViz;
+	renderSnapshot.drawLoopStartEnd = sharedData->drawLoopStartEnd;
+	renderSnapshot.prevNumBars = sharedData->prevNumBars;
+	renderSnapshot.prevPosition = sharedData->prevPosition;
+	renderSnapshot.PPQNCounter = sharedData->PPQNCounter;
+	renderSnapshot.PPQNTimeStamp = sharedData->PPQNTimeStamp;
+	renderSnapshot.instruments.clear();
+	for (auto it = sharedData->instruments.begin(); it != sharedData->instruments.end(); ++it) {
+		renderSnapshot.instruments[it->first] = it->second.getSeqState();
+	}
+}
+
+//--------------------------------------------------------------
+void Sequencer::restoreSnapshot()
+{
+	thisBarIndex = renderSnapshot.thisBarIndex;
+	beatCounter = renderSnapshot.beatCounter;
+	tickCounter = renderSnapshot.tickCounter;
+	onNextStartMidiByte = renderSnapshot.onNextStartMidiByte;
+	firstIter = renderSnapshot.firstIter;
+	endOfBar = renderSnapshot.endOfBar;
+	sendBeatVizInfoCounter = renderSnapshot.sendBeatVizInfoCounter;
+	finished = renderSnapshot.finished;
+	mustStop = renderSnapshot.mustStop;
+	mustStopCalled = renderSnapshot.mustStopCalled;
+	muteChecked = renderSnapshot.muteChecked;
+	countdown = renderSnapshot.countdown;
+	countdownCounter = renderSnapshot.countdownCounter;
+	updateSequencer = renderSnapshot.updateSequencer;
+	sequencerUpdated = renderSnapshot.sequencerUpdated;
+	sharedData->thisBarIndex = renderSnapshot.sharedThisBarIndex;
+	sharedData->beatCounter = renderSnapshot.sharedBeatCounter;
+	sharedData->loopIndex = renderSnapshot.loopIndex;
+	sharedData->barCounter = renderSnapshot.barCounter;
+	sharedData->animate = renderSnapshot.animate;
+	sharedData->setAnimation = renderSnapshot.setAnimation;
+	sharedData->beatAnimate = renderSnapshot.beatAnimate;
+	sharedData->setBeatAnimation = renderSnapshot.setBeatAnimation;
+	sharedData->beatViz = renderSnapshot.beatViz;
+	sharedData->drawLoopStartEnd = renderSnapshot.drawLoopStartEnd;
+	sharedData->prevNumBars = renderSnapshot.prevNumBars;
+	sharedData->prevPosition = renderSnapshot.prevPosition;
+	sharedData->PPQNCounter = renderSnapshot.PPQNCounter;
+	sharedData->PPQNTimeStamp = renderSnapshot.PPQNTimeStamp;
+	// instruments created during the render keep the state they were created with
+	for (auto it = renderSnapshot.instruments.begin(); it != renderSnapshot.instruments.end(); ++it) {
+		auto inst = sharedData->instruments.find(it->first);
+		if (inst != sharedData->instruments.end()) inst->second.setSeqState(it->second);
+	}
+	// ramps that were still running when the render ended must not continue in the next play
+	rampInsts.clear();
+}
+
+//--------------------------------------------------------------
+bool Sequencer::isRendering()
+{
+	return offline;
+}
+
+//--------------------------------------------------------------
+void Sequencer::advanceVirtualTime()
+{
+	// the earliest of the next beat, the next step of any instrument, the next MIDI clock
+	// and the next frame of any control ramp is where something can happen next
+	if (!sequencerRunning || firstIter) return;
+	int bar = sharedData->loopData[sharedData->loopIndex][sharedData->thisBarIndex];
+	uint64_t next = tickCounter + (uint64_t)(sharedData->tempoMs[bar] * 1000);
+	if (!countdown) {
+		if (sendMidiClock && sharedData->PPQNCounter < sharedData->PPQN) {
+			next = std::min(next, sharedData->PPQNTimeStamp + sharedData->PPQNPerUs[bar]);
+		}
+		// ramps are run on millisecond frames
+		if (!rampInsts.empty()) next = std::min(next, virtualTime + 1000);
+		for (auto it = sharedData->instruments.begin(); it != sharedData->instruments.end(); ++it) {
+			uint64_t stepTime;
+			if (it->second.hasNotesInBar(bar) && it->second.getNextStepTime(bar, stepTime)) {
+				next = std::min(next, stepTime);
+			}
+		}
+	}
+	// always move forward, in case an event is due but didn't fire
+	virtualTime = std::max(next, virtualTime + 1);
+}
+
+//--------------------------------------------------------------
+void Sequencer::runControlRamps()
+{
+	// glissandi and dynamics ramps of all instruments are run from the same sequencer tick
+	// visiting only the instruments that have one active, which are removed once they're done
+	size_t i = 0;
+	while (i < rampInsts.size()) {
+		Instrument& inst = sharedData->instruments.at(rampInsts[i]);
+		if (inst.getGlissandoStart()) runGlissando(rampInsts[i]);
+		if (inst.getDynamicsRampStart()) runDynamicsRamp(rampInsts[i]);
+		if (!inst.getGlissandoStart() && !inst.getDynamicsRampStart()) {
+			rampInsts.erase(rampInsts.begin()+i);
 		}
-		sharedData->instruments.at(instNdx).glissCounter++;
-		if ((int64_t)ofGetElapsedTimeMillis() - sharedData->instruments.at(instNdx).glissStartTimeStamp >= sharedData->instruments.at(instNdx).glissDurMs) {
-			sharedData->instruments.at(instNdx).setGlissandoStart(false);
+		else {
+			i++;
 		}
-		sharedData->instruments.at(instNdx).glissTimeStamp = timeStamp - (diff - sharedData->instruments.at(instNdx).glissTimeDiff);
 	}
 }
 
 //--------------------------------------------------------------
 void Sequencer::sendToParts(ofxOscMessage m, bool delay)
 {
+	// score parts follow the wall clock, so they are left out when rendering
+	// they are not traced either, as the trace player sends all OSC records to the OSC output of the sequencer
+	if (offline) return;
 	for (auto it = sharedData->grouppedOSCClients.begin(); it != sharedData->grouppedOSCClients.end(); ++it) {
 		if (sharedData->instruments[*it].hasDelay() && delay) {
 			std::pair<ofxOscMessage, unsigned long> p = std::make_pair(m, ofGetElapsedTimeMillis());
@@ -11194,6 +12415,7 @@ void Sequencer::sendLoopIndexToParts()
 //--------------------------------------------------------------
 void Sequencer::sendStopCountdownToParts()
 {
+	partsCountdown = 0;
 	ofxOscMessage m;
 	m.setAddress("/nocountdown");
 	m.addIntArg(1); // dummy arg
@@ -11204,6 +12426,7 @@ void Sequencer::sendStopCountdownToParts()
 //--------------------------------------------------------------
 void Sequencer::sendCountdownToParts(int countdown)
 {
+	partsCountdown = countdown;
 	ofxOscMessage m;
 	m.setAddress("/countdown");
 	m.addIntArg(countdown);
@@ -11211,6 +12434,12 @@ void Sequencer::sendCountdownToParts(int countdown)
 	m.clear();
 }
 
+//--------------------------------------------------------------
+int Sequencer::getPartsCountdown()
+{
+	return partsCountdown;
+}
+
 //--------------------------------------------------------------
 void Sequencer::sendFinishToParts(bool finishState)
 {
@@ -11225,7 +12454,17 @@ void Sequencer::sendFinishToParts(bool finishState)
 void Sequencer::threadedFunction()
 {
 	while (isThreadRunning()) {
-		timer.waitNext();
+		if (offline) {
+			advanceVirtualTime();
+			if (virtualTime >= renderEndTime) {
+				stopNow();
+				return;
+			}
+		}
+		else {
+			timer.waitNext();
+		}
+		if (latencyResetRequested.exchange(false)) resetLatencyHistograms();
 		if (runSequencer && !sequencerRunning) {
 			int bar = sharedData->loopData[sharedData->loopIndex][sharedData->thisBarIndex];
 			// in here we calculate the number of beats on a microsecond basis
@@ -11256,20 +12495,22 @@ void Sequencer::threadedFunction()
 			m.clear();
 			sequencerRunning = true;
 			runSequencer = false;
-			if (sendMidiClock) midiOut.sendMidiByte(onNextStartMidiByte);
+			if (sendMidiClock) sendMidi(-1, onNextStartMidiByte, 0, 0, 1);
 			firstIter = true;
 			endOfBar = false;
 			sendBeatVizInfoCounter = 0;
 			for (auto instMapIt = sharedData->instruments.begin(); instMapIt != sharedData->instruments.end(); ++instMapIt) {
 				instMapIt->second.initSeqToggle();
 				instMapIt->second.setFirstIter(true);
+				// the controller of the dynamics ramps is sent with the first note, whatever it was left at
+				instMapIt->second.dynRampLastMidiVal = -1;
 			}
 			thisBarIndex = sharedData->thisBarIndex;
 			sendSequencerStateToParts(true);
 		}
 
 		if (sequencerRunning) {
-			uint64_t timeStamp = ofGetElapsedTimeMicros();
+			uint64_t timeStamp = now();
 			int bar = sharedData->loopData[sharedData->loopIndex][sharedData->thisBarIndex];
 			int prevBar = sharedData->loopData[sharedData->loopIndex][((int)sharedData->thisBarIndex - 1 < 0 ? (int)sharedData->loopData[sharedData->loopIndex].size()-1 : sharedData->thisBarIndex-1)];
 			// check if we're at the beginning of the loop
@@ -11337,7 +12578,7 @@ void Sequencer::threadedFunction()
 						// binding a function to the number of instruments + 2, binds to the end
 						if (func->second.getBoundInst() == (int)sharedData->instruments.size() + 2 && sharedData->beatCounter == 0) {
 							//((ofApp*)ofGetAppPtr())->parseCommand(((ofApp*)ofGetAppPtr())->genCmdInput(func->second.getName()), 1, 1);
-							((ofApp*)ofGetAppPtr())->parseString(func->second.getName(), 1, 1);
+							callBoundFunction(func->second.getName());
 						}
 					}
 					finished = false;
@@ -11405,7 +12646,7 @@ void Sequencer::threadedFunction()
 						// binding to the number of instruments, binds a function to the pulse of the beat
 						if (func->second.getBoundInst() == (int)sharedData->instruments.size()) {
 							//((ofApp*)ofGetAppPtr())->parseCommand(((ofApp*)ofGetAppPtr())->genCmdInput(func->second.getName()), 1, 1);
-							((ofApp*)ofGetAppPtr())->parseString(func->second.getName(), 1, 1);
+							callBoundFunction(func->second.getName());
 						}
 					}
 					if (!(sharedData->beatCounter == 0 && mustStop)) sendBeatVizInfo(bar);
@@ -11433,18 +12674,18 @@ void Sequencer::threadedFunction()
 						// binding a function to the number of instruments + 1, binds to the start of each bar
 						if (func->second.getBoundInst() == (int)sharedData->instruments.size() + 1 && sharedData->beatCounter == 0) {
 							//((ofApp*)ofGetAppPtr())->parseCommand(((ofApp*)ofGetAppPtr())->genCmdInput(func->second.getName()), 1, 1);
-							((ofApp*)ofGetAppPtr())->parseString(func->second.getName(), 1, 1);
+							callBoundFunction(func->second.getName());
 						}
 						// binding to the number of instruments, binds a function to the pulse of the beat
 						else if (func->second.getBoundInst() == (int)sharedData->instruments.size()) {
 							//((ofApp*)ofGetAppPtr())->parseCommand(((ofApp*)ofGetAppPtr())->genCmdInput(func->second.getName()), 1, 1);
-							((ofApp*)ofGetAppPtr())->parseString(func->second.getName(), 1, 1);
+							callBoundFunction(func->second.getName());
 						}
 						// binding to the number of instruments + 3, binds a function to the start of the loop
 						else if (func->second.getBoundInst() == (int)sharedData->instruments.size() + 3 && \
 								sharedData->thisBarIndex == 0 && sharedData->beatCounter == 0) {
 							//((ofApp*)ofGetAppPtr())->parseCommand(((ofApp*)ofGetAppPtr())->genCmdInput(func->second.getName()), 1, 1);
-							((ofApp*)ofGetAppPtr())->parseString(func->second.getName(), 1, 1);
+							callBoundFunction(func->second.getName());
 						}
 					}
 				}
@@ -11475,21 +12716,22 @@ void Sequencer::threadedFunction()
 			if (!countdown) {
 				// send MIDI clock, if set
 				// need to calculate the number of steps
-				uint64_t midiClockTimeStamp = ofGetElapsedTimeMicros();
+				uint64_t midiClockTimeStamp = now();
 				if (sendMidiClock && \
 						(midiClockTimeStamp - sharedData->PPQNTimeStamp) >= sharedData->PPQNPerUs[bar] && \
 						sharedData->PPQNCounter < sharedData->PPQN) {
-					midiOut.sendMidiByte(0xF8);
+					sendMidi(-1, 0xF8, 0, 0, 1);
 					sharedData->PPQNCounter++;
 					sharedData->PPQNTimeStamp = midiClockTimeStamp;
 				}
+				// all active glissandi and dynamics ramps are run together, and this costs nothing if there are none
+				if (!rampInsts.empty()) runControlRamps();
 				for (auto instMapIt = sharedData->instruments.begin(); instMapIt != sharedData->instruments.end(); ++instMapIt) {
 					if (instMapIt->second.getBarDataCounter() == 0) {
 						if (instMapIt->second.mustUpdateTempo()) {
 							instMapIt->second.setUpdateTempo(false);
 						}
 					}
-					runGlissando(instMapIt->first, bar); // this function determines whethere there are any active glissandi
 					if (instMapIt->second.hasNotesInBar(bar)) {
 						if (instMapIt->second.mustFireStep(timeStamp, bar, sharedData->tempo[bar])) {
 							// if we have a note, not a rest, and the current instrument is not muted
@@ -11501,15 +12743,15 @@ void Sequencer::threadedFunction()
 												!instMapIt->second.isNoteTied(bar, instMapIt->second.getBarDataCounter())) {
 											if (instMapIt->second.sendToPython()) {
 #ifdef USEPYO
-												std::string pyoStr = instMapIt->second.getName() + ".setAmp(0)";
-												sharedData->pyo.exec(pyoStr.c_str(), 0);
+												float amp = 0;
+												pushPyoParam(instMapIt->second.pyoAmpBinding, &amp, 1, instMapIt->second.getTimeStamp());
 #endif
 											}
 											else {
 												ofxOscMessage m;
 												m.setAddress("/" + instMapIt->second.getName() + "/dynamics");
 												m.addIntArg(0);
-												oscSender.sendMessage(m, false);
+												sendOsc(m);
 												m.clear();
 											}
 											((ofApp*)ofGetAppPtr())->storeActiveEditorElement(instMapIt->first, bar, instMapIt->second.getBarDataCounter(), false);
@@ -11547,13 +12789,13 @@ void Sequencer::threadedFunction()
 											for (auto it = instMapIt->second.articulations[bar][instMapIt->second.getBarDataCounter()].begin(); it != instMapIt->second.articulations[bar][instMapIt->second.getBarDataCounter()].end(); ++it) {
 												m.addStringArg(sharedData->articulSyms[*it]);
 											}
-											oscSender.sendMessage(m, false);
+											sendOsc(m);
 											m.clear();
 
 											if (instMapIt->second.hasText(bar)) {
 												m.setAddress("/" + instMapIt->second.getName() + "/text");
 												m.addStringArg(instMapIt->second.getText(bar));
-												oscSender.sendMessage(m, false);
+												sendOsc(m);
 												m.clear();
 											}
 
@@ -11561,14 +12803,14 @@ void Sequencer::threadedFunction()
 												m.setAddress("/" + instMapIt->second.getName() + "/note");
 											}
 											int i = 0;
-											std::string s = "";
-											if (instMapIt->second.sendToPython() && instMapIt->second.notes[bar][instMapIt->second.getBarDataCounter()].size() > 1) {
-												s += "[";
-											}
+#ifdef USEPYO
+											float freqs[PYOMAXVALUES];
+#endif
 											for (auto it = instMapIt->second.notes[bar][instMapIt->second.getBarDataCounter()].begin(); it != instMapIt->second.notes[bar][instMapIt->second.getBarDataCounter()].end(); ++it) {
 												if (instMapIt->second.sendToPython()) {
-													if (i > 0) s += ",";
-													s += std::to_string(midiToFreq(*it));
+#ifdef USEPYO
+													if (i < PYOMAXVALUES) freqs[i] = midiToFreq(*it);
+#endif
 												}
 												else {
 													if (instMapIt->second.sendMIDI()) m.addFloatArg(*it);
@@ -11578,29 +12820,36 @@ void Sequencer::threadedFunction()
 											}
 											if (instMapIt->second.sendToPython()) {
 #ifdef USEPYO
-												if (i > 1) s += "]";
-												std::string pyoStr = instMapIt->second.getName() + ".setFreq(" + s + ")";
-												sharedData->pyo.exec(pyoStr.c_str(), 0);
+												pushPyoParam(instMapIt->second.pyoFreqBinding, freqs, i, instMapIt->second.getTimeStamp());
 #endif
 											}
 											else {
-												oscSender.sendMessage(m, false);
+												sendOsc(m);
 												m.clear();
 											}
 
 											if (instMapIt->second.sendToPython()) {
 #ifdef USEPYO
-												std::string pyoStr = instMapIt->second.getName() + ".setAmp(" + std::to_string(instMapIt->second.getDynamic(bar)) + ")";
-												sharedData->pyo.exec(pyoStr.c_str(), 0);
+												float amp = instMapIt->second.getDynamic(bar);
+												pushPyoParam(instMapIt->second.pyoAmpBinding, &amp, 1, instMapIt->second.getTimeStamp());
 #endif
 											}
 											else {
 												m.setAddress("/" + instMapIt->second.getName() + "/dynamics");
 												if (instMapIt->second.sendMIDI()) m.addIntArg(instMapIt->second.getMidiVel(bar));
 												else m.addFloatArg(instMapIt->second.getDynamic(bar));
-												oscSender.sendMessage(m, false);
+												sendOsc(m);
 												m.clear();
 											}
+											if (sendsDynamicsController(instMapIt->first)) {
+												sendDynamicsController(instMapIt->first, instMapIt->second.getDynamic(bar));
+											}
+											if (instMapIt->second.midiDynamicsRampDurs.at(bar).at(instMapIt->second.getBarDataCounter()) > 0) {
+												startDynamicsRamp(instMapIt->first, bar, instMapIt->second.getBarDataCounter());
+											}
+											else {
+												instMapIt->second.setDynamicsRampStart(false);
+											}
 											((ofApp*)ofGetAppPtr())->storeActiveEditorElement(instMapIt->first, bar, instMapIt->second.getBarDataCounter(), true);
 										}
 										// if the previous note was slurred, but not tied, deactivate the editor element
@@ -11618,7 +12867,7 @@ void Sequencer::threadedFunction()
 										if (!instMapIt->second.isNoteSlurred(bar, instMapIt->second.getBarDataCounter()) && \
 												!instMapIt->second.isNoteTied(bar, instMapIt->second.getBarDataCounter())) {
 											for (auto it = instMapIt->second.midiNotes[bar][instMapIt->second.getBarDataCounter()].begin(); it != instMapIt->second.midiNotes[bar][instMapIt->second.getBarDataCounter()].end(); ++it) {
-												midiOuts[midiPortsMap[instMapIt->second.getMidiPort()]].sendNoteOff(instMapIt->second.getMidiChan(), *it, 0);
+												sendMidi(midiPortsMap[instMapIt->second.getMidiPort()], 0x80 + instMapIt->second.getMidiChan() - 1, *it, 0, 3);
 											}
 											((ofApp*)ofGetAppPtr())->storeActiveEditorElement(instMapIt->first, bar, instMapIt->second.getBarDataCounter(), false);
 										}
@@ -11652,10 +12901,21 @@ void Sequencer::threadedFunction()
 										if (sendData) {
 											//midiOuts[midiPortsMap[instMapIt->second.getMidiPort()]].sendPitchBend(instMapIt->second.getMidiChan(), instMapIt->second.getPitchBendVal(bar));
 											for (auto it = instMapIt->second.midiArticulationVals[bar][instMapIt->second.barDataCounter].begin(); it != instMapIt->second.midiArticulationVals[bar][instMapIt->second.barDataCounter].end(); ++it) {
-												midiOuts[midiPortsMap[instMapIt->second.getMidiPort()]].sendProgramChange(instMapIt->second.getMidiChan(), *it);
+												sendMidi(midiPortsMap[instMapIt->second.getMidiPort()], 0xC0 + instMapIt->second.getMidiChan() - 1, *it, 0, 2);
+											}
+											// the controller a ramp streams to is set to the dynamic of every note
+											// so a note after a ramp isn't left with the value the ramp ended at, and the next ramp starts from the note's dynamic
+											if (sendsDynamicsController(instMapIt->first)) {
+												sendDynamicsController(instMapIt->first, instMapIt->second.getDynamic(bar));
 											}
 											for (auto it = instMapIt->second.midiNotes[bar][instMapIt->second.barDataCounter].begin(); it != instMapIt->second.midiNotes[bar][instMapIt->second.barDataCounter].end(); ++it) {
-												midiOuts[midiPortsMap[instMapIt->second.getMidiPort()]].sendNoteOn(instMapIt->second.getMidiChan(), *it, instMapIt->second.getMidiVel(bar));
+												sendMidi(midiPortsMap[instMapIt->second.getMidiPort()], 0x90 + instMapIt->second.getMidiChan() - 1, *it, instMapIt->second.getMidiVel(bar), 3);
+											}
+											if (instMapIt->second.midiDynamicsRampDurs.at(bar).at(instMapIt->second.getBarDataCounter()) > 0) {
+												startDynamicsRamp(instMapIt->first, bar, instMapIt->second.getBarDataCounter());
+											}
+											else {
+												instMapIt->second.setDynamicsRampStart(false);
 											}
 											((ofApp*)ofGetAppPtr())->storeActiveEditorElement(instMapIt->first, bar, instMapIt->second.getBarDataCounter(), true);
 										}
@@ -11664,7 +12924,7 @@ void Sequencer::threadedFunction()
 											if (instMapIt->second.isNoteSlurred(bar, instMapIt->second.getBarDataCounter()-1) && \
 													!instMapIt->second.isNoteTied(bar, instMapIt->second.getBarDataCounter()-1)) {
 												for (auto it = instMapIt->second.midiNotes[bar][instMapIt->second.getBarDataCounter()-1].begin(); it != instMapIt->second.midiNotes[bar][instMapIt->second.getBarDataCounter()-1].end(); ++it) {
-													midiOuts[midiPortsMap[instMapIt->second.getMidiPort()]].sendNoteOff(instMapIt->second.getMidiChan(), *it, 0);
+													sendMidi(midiPortsMap[instMapIt->second.getMidiPort()], 0x80 + instMapIt->second.getMidiChan() - 1, *it, 0, 3);
 												}
 												((ofApp*)ofGetAppPtr())->storeActiveEditorElement(instMapIt->first, bar, instMapIt->second.getBarDataCounter()-1, false);
 											}
@@ -11678,14 +12938,15 @@ void Sequencer::threadedFunction()
 									ofxOscMessage m;
 									m.setAddress("/" + instMapIt->second.getName() + "/dynamics");
 									m.addIntArg(0);
-									oscSender.sendMessage(m, false);
+									sendOsc(m);
 									m.clear();
 								}
 								else {
 									// send all sound off with CC #120 with value 0
-									midiOut.sendControlChange(instMapIt->second.getMidiChan(), 120, 0);
+									sendMidi(-1, 0xB0 + instMapIt->second.getMidiChan() - 1, 120, 0, 3);
 								}
 							}
+							recordLatency(instMapIt->first);
 							if (sharedData->animate && !instMapIt->second.getSeqToggle()) {
 								instMapIt->second.setActiveNote();
 							}
@@ -11702,7 +12963,7 @@ void Sequencer::threadedFunction()
 										if (func->second.getCallingStep() == instMapIt->second.getBarDataCounter()) {
 											func->second.addStepIncrement(instMapIt->second.getBarDataCounter());
 											//((ofApp*)ofGetAppPtr())->parseCommand(((ofApp*)ofGetAppPtr())->genCmdInput(func->second.getName()), 1, 1); // dummy 2nd and 3rd arguments
-											((ofApp*)ofGetAppPtr())->parseString(func->second.getName(), 1, 1); // dummy 2nd and 3rd arguments
+											callBoundFunction(func->second.getName()); // dummy 2nd and 3rd arguments
 										}
 									}
 								}
@@ -11735,3 +12996,127 @@ void Sequencer::threadedFunction()
 		}
 	}
 }
+
+/**************************************************************/
+/************** OSC receiving thread class ********************/
+//--------------------------------------------------------------
+void OscReceiverThread::setup(int port)
+{
+	receiver.setup(port);
+	timer.setPeriodicEvent(OSCPOLLPERIOD);
+	startThread();
+}
+
+//--------------------------------------------------------------
+void OscReceiverThread::setRoutes(std::unordered_map<std::string, std::pair<int, int>> routes)
+{
+	lock();
+	oscRoutes = std::move(routes);
+	unlock();
+}
+
+//--------------------------------------------------------------
+void OscReceiverThread::stop()
+{
+	waitForThread(true);
+}
+
+//--------------------------------------------------------------
+void OscReceiverThread::threadedFunction()
+{
+	while (isThreadRunning()) {
+		timer.waitNext();
+		while (receiver.hasWaitingMessages()) {
+			TimedOscMessage msg;
+			receiver.getNextMessage(msg.m);
+			msg.timeStamp = ofGetElapsedTimeMicros();
+			lock();
+			auto route = oscRoutes.find(msg.m.getAddress());
+			bool routeFound = route != oscRoutes.end();
+			if (routeFound) {
+				msg.route = route->second.first;
+				msg.pane = route->second.second;
+			}
+			unlock();
+			if (!routeFound) continue;
+			// the maestro beat detection is handled here, as soon as the message arrives
+			// instead of waiting for the next frame, and only the detected beats are queued
+			if (msg.route == maestroRoute) {
+				TimedOscMessage beat;
+				if (((ofApp*)ofGetAppPtr())->maestroOsc(msg.m, msg.timeStamp, beat) && !queue.push(beat)) {
+					cout << "OSC input queue is full, dropping a maestro beat" << endl;
+				}
+			}
+			else if (!queue.push(msg)) {
+				cout << "OSC input queue is full, dropping message " << msg.m.getAddress() << endl;
+			}
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void PartSyncThread::setup()
+{
+	startThread();
+}
+
+//--------------------------------------------------------------
+void PartSyncThread::push(const PartSyncRequest& request)
+{
+	requests.send(request);
+}
+
+//--------------------------------------------------------------
+void PartSyncThread::stop()
+{
+	requests.close();
+	matched.close();
+	waitForThread(true);
+}
+
+//--------------------------------------------------------------
+void PartSyncThread::threadedFunction()
+{
+	PartSyncRequest request;
+	// a request without messages is matched to its instruments and passed to the main thread
+	// which sends it back with the snapshot to be sent to the part
+	// receive() blocks until a request arrives, and returns false once the channel is closed
+	while (requests.receive(request)) {
+		if (request.messages.empty()) {
+			matchInstruments(request);
+			if (!request.instNdxs.empty()) matched.send(request);
+		}
+		else {
+			sendSnapshot(request);
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void PartSyncThread::matchInstruments(PartSyncRequest& request)
+{
+	// a host can be given by name or by IP, so hosts are compared by the address they resolve to
+	request.instNdxs.clear();
+	unsigned long address = GetHostByName(request.host.c_str());
+	std::map<std::string, bool> sameHosts;
+	for (auto it = request.instHosts.begin(); it != request.instHosts.end(); ++it) {
+		auto sameIt = sameHosts.find(it->second);
+		if (sameIt == sameHosts.end()) {
+			bool same = it->second.compare(request.host) == 0 || (address != 0 && GetHostByName(it->second.c_str()) == address);
+			sameIt = sameHosts.insert(std::make_pair(it->second, same)).first;
+		}
+		if (sameIt->second) request.instNdxs.push_back(it->first);
+	}
+}
+
+//--------------------------------------------------------------
+void PartSyncThread::sendSnapshot(const PartSyncRequest& request)
+{
+	// the snapshot is a burst of UDP messages, so it's paced to give the part time to read them
+	ofxOscSender sender;
+	sender.setup(request.host, request.port);
+	for (size_t i = 0; i < request.messages.size(); i++) {
+		sender.sendMessage(request.messages[i], false);
+		if ((i+1) % SYNCBURSTSIZE == 0) sleep(1);
+	}
+}
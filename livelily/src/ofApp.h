@@ -5,10 +5,17 @@
 #include "ofxOsc.h"
 #include "ofxMidi.h"
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <utility> // to add pair
 #include "editor.h"
 #include "instrument.h"
+#include "ringBuffer.h"
+#include "traceRecorder.h"
+#include "scoreBatch.h"
+#include "scoreBench.h"
+#include "maestro.h"
+#include "ip/NetworkingUtils.h"
 #ifdef USEPYO
 #include "PyoClass.h"
 #endif
@@ -33,6 +40,11 @@
 #define MINTRACEBACKLINES 2
 
 #define OSCPORT 9050 // for receiving OSC messages in editors
+#define OSCPOLLPERIOD 500000 // 500 us period of the OSC receiving thread, in nanoseconds
+#define OSCQUEUESIZE 1024 // number of messages the OSC receiving thread can queue for the main thread
+#define SYNCBURSTSIZE 32 // messages sent to a score part that syncs, before pausing for a millisecond
+#define SCOPEQUEUESIZE 16384 // in frames, for passing the output audio to the oscilloscope
+#define SCOPECHUNKSIZE 256 // number of frames copied to and from the scope queue at once
 
 #define WINDOW_RESIZE_GAP 50
 
@@ -40,10 +52,10 @@
 
 #define SENDBARDATA_WAITDUR 1000 // in milliseconds
 #define NOTESXOFFSETCOEF 3 // multiplication coefficient for giving offset to the notes
-
-#define MAESTROTHRESH 100
-
-#define GLISSGRAIN 20 // 20ms grain for glissandi
+#define LAYOUTLOOKAHEAD 8 // number of bars after the ones shown that are laid out in advance
+#define PROJECTIONCLOSED -2 // values of ofApp::projectionMonitor other than monitor indexes
+#define PROJECTIONWINDOWED -1
+#define PROJECTIONNUMSAMPLES 4 // multisampling of the FBO the score is drawn to when it is projected
 
 // for the piano roll
 #define LOWESTKEY 21 // should be 21 // this is an A four octaves below tuning A
@@ -154,6 +166,8 @@ struct SharedData
 	size_t pyStdoutStrNdx;
 	bool typePyStrCharByChar;
 	bool typePyStrLineByLine;
+	bool typePyStrBulk; // type the whole string in one frame instead of one character per frame
+	float typePyStrAnimRate; // lines per second revealed after a bulk insertion, 0 for no animation
 	int whichPyPane;
 	bool typePyStr;
 	std::vector<std::string> pyStdoutStrVec;
@@ -204,7 +218,6 @@ struct SharedData
 	bool beatAnimate;
 	bool beatTypeCommand;
 	int beatVizType;
-	bool beatUpdated;
 	// the variable below is used by the serquencer to iterate over one loop
 	unsigned thisBarIndex;
 	int loopIndex;
@@ -288,6 +301,43 @@ struct CmdOutput
 	std::vector<std::string> outputVec;
 };
 
+// the playback position of the sequencer and the score, saved before an offline render and restored after it
+// so that the next \play starts from where it would have without the render
+struct SequencerSnapshot
+{
+	unsigned thisBarIndex;
+	int beatCounter;
+	uint64_t tickCounter;
+	int onNextStartMidiByte;
+	bool firstIter;
+	bool endOfBar;
+	int sendBeatVizInfoCounter;
+	bool finished;
+	bool mustStop;
+	bool mustStopCalled;
+	bool muteChecked;
+	bool countdown;
+	int countdownCounter;
+	bool updateSequencer;
+	bool sequencerUpdated;
+	// the part of the shared data the sequencer writes to
+	unsigned sharedThisBarIndex;
+	int sharedBeatCounter;
+	int loopIndex;
+	int barCounter;
+	bool animate;
+	bool setAnimation;
+	bool beatAnimate;
+	bool setBeatAnimation;
+	bool beatViz;
+	bool drawLoopStartEnd;
+	int prevNumBars;
+	int prevPosition;
+	unsigned long PPQNCounter;
+	uint64_t PPQNTimeStamp;
+	std::map<int, InstSeqState> instruments;
+};
+
 class Sequencer : public ofThread
 {
 	public:
@@ -302,11 +352,16 @@ class Sequencer : public ofThread
 		void setFinish(bool finishState);
 		void setCountdown(int num);
 		void setMidiTune(int tuneVal);
+		bool render(std::string fileName, uint64_t durUs);
+		bool isRendering();
+		void resetLatency();
+		int getPartsCountdown();
 
 		ofxMidiOut midiOut;
 		std::vector<ofxMidiOut> midiOuts;
 		std::vector<std::string> midiOutPorts;
 		std::map<int, int> midiPortsMap;
+		TraceRecorder tracer;
 
 	private:
 		int setBarIndex(bool increment);
@@ -316,7 +371,26 @@ class Sequencer : public ofThread
 		float midiToFreq(float midiNote);
 		float mapVal(float inVal, float fromLow, float fromHigh, float toLow, float toHigh);
 		void startGlissando(int instNdx, int bar, int barDataCounter);
-		void runGlissando(int instNdx, int bar);
+		void runGlissando(int instNdx);
+		void startDynamicsRamp(int instNdx, int bar, int barDataCounter);
+		void runDynamicsRamp(int instNdx);
+		float getDynamicsRampTarget(int instNdx, int bar, int barDataCounter);
+		bool sendsDynamicsController(int instNdx);
+		void sendDynamicsController(int instNdx, float val);
+		void addControlRamp(int instNdx);
+		void runControlRamps();
+		void recordLatency(int instNdx);
+		void resetLatencyHistograms();
+		void saveSnapshot();
+		void restoreSnapshot();
+		void sendOsc(ofxOscMessage& m);
+		void sendMidi(int port, int status, int data1, int data2, int numBytes);
+#ifdef USEPYO
+		void pushPyoParam(int binding, const float *values, int len, uint64_t timeStamp);
+#endif
+		void callBoundFunction(std::string name);
+		uint64_t now();
+		void advanceVirtualTime();
 		void sendToParts(ofxOscMessage m, bool delay);
 		void sendSequencerStateToParts(bool state);
 		void sendLoopIndexToParts();
@@ -351,6 +425,17 @@ class Sequencer : public ofThread
 		int countdownCounter;
 		bool countdown;
 		int midiTuneVal;
+		// when rendering offline the sequencer runs on virtualTime instead of the wall clock
+		std::atomic<bool> offline;
+		uint64_t virtualTime;
+		uint64_t renderEndTime;
+		SequencerSnapshot renderSnapshot;
+		// indexes of the instruments with an active glissando or dynamics ramp
+		std::vector<int> rampInsts;
+		// the histograms are cleared by the thread that writes them, on its next tick
+		std::atomic<bool> latencyResetRequested;
+		// the last countdown sent to the parts, 0 if none, for parts that sync
+		std::atomic<int> partsCountdown;
 
 		/* iterators for accessing data in Instrument objects */
 		std::map<std::string, int>::iterator instNamesIt;
@@ -361,6 +446,89 @@ class Sequencer : public ofThread
 		std::map<int, Instrument>::reverse_iterator instMapRevIt;
 };
 
+// types of routes an incoming OSC address can be dispatched to
+// maestroBeatRoute is not an address, it's used by the OSC thread to pass the beats it detects to update()
+enum oscRouteTypes {maestroRoute, maestroBeatRoute, maestroToggleRoute, maestroLevareRoute, editorPressRoute, editorReleaseRoute, syncRoute, statsRoute};
+
+// a stereo frame of the output audio, passed from the audio thread to the oscilloscope
+struct ScopeFrame
+{
+	float left;
+	float right;
+};
+
+// a key of the piano roll clavier that lights up while a note of the bar that reaches the clavier plays
+struct PianoRollHighlight
+{
+	int inst;
+	int noteNdx; // index of the note within the bar
+	ofColor color;
+	ofRectangle key;
+	ofRectangle restOfKey; // natural keys are wider below the black keys
+	bool accidental;
+};
+
+// an incoming OSC message stamped with its arrival time and the route it was dispatched to
+struct TimedOscMessage
+{
+	ofxOscMessage m;
+	uint64_t timeStamp; // in microseconds
+	int route;
+	int pane;
+};
+
+// OSC input runs in its own thread so that it is not quantized to the frame rate
+// time critical input (the maestro beat detection) is handled as soon as it arrives
+// the rest is queued with its time stamp and consumed by ofApp::update()
+class OscReceiverThread : public ofThread
+{
+	public:
+		void setup(int port);
+		void setRoutes(std::unordered_map<std::string, std::pair<int, int>> routes);
+		void stop();
+
+		RingBuffer<TimedOscMessage, OSCQUEUESIZE> queue;
+
+	private:
+		void threadedFunction();
+
+		ofxOscReceiver receiver;
+		ofTimer timer;
+		// keys are OSC addresses, values are the route type and the pane index
+		std::unordered_map<std::string, std::pair<int, int>> oscRoutes;
+};
+
+// a sync request of a score part
+// the instruments that send to the port of the part are matched to its host by PartSyncThread
+// then the main thread stores the snapshot of their state, which PartSyncThread sends
+struct PartSyncRequest
+{
+	std::string host;
+	int port;
+	std::map<int, std::string> instHosts; // the instruments that send to this port, with the host they were set up with
+	std::vector<int> instNdxs; // the instruments whose host resolves to the address of the part
+	std::vector<ofxOscMessage> messages;
+};
+
+// resolving host names and sending a whole snapshot both block, so parts that sync are served by a thread of their own
+class PartSyncThread : public ofThread
+{
+	public:
+		void setup();
+		void push(const PartSyncRequest& request);
+		void stop();
+
+		// the requests whose instruments are matched, for the main thread to store their snapshot
+		ofThreadChannel<PartSyncRequest> matched;
+
+	private:
+		void threadedFunction();
+		void matchInstruments(PartSyncRequest& request);
+		void sendSnapshot(const PartSyncRequest& request);
+
+		ofThreadChannel<PartSyncRequest> requests;
+};
+
 class ofApp : public ofBaseApp
 {
 	public:
@@ -372,9 +540,26 @@ class ofApp : public ofBaseApp
 		void drawTraceback();
 		void drawShell();
 		void drawScore();
+		void drawScoreToFbo();
+		void drawProjection();
+		void openProjectionWindow();
+		void closeProjectionWindow();
+		void projectionWindowClosed();
 		void drawPianoRoll();
+		void buildPianoRollKeys();
+		void buildPianoRollNotes();
 		void drawBlackKeysOutline(float xPos, float yPos);
 		void drawScope();
+		void updateScope();
+		void decimateScope(const std::vector<float>& samples, ofPolyline& waveform);
+
+		//---------------------------------
+		// OSC input handling
+		void setOscRoutes();
+		bool maestroOsc(ofxOscMessage& m, uint64_t timeStamp, TimedOscMessage& beat);
+		void maestroBeat(ofxOscMessage& m);
+		void maestroToggleOsc(ofxOscMessage& m);
+		void editorOsc(ofxOscMessage& m, int pane, bool press);
 
 		void sendBeatVizInfo(int bar);
 		void moveCursorOnShiftReturn();
@@ -392,8 +577,10 @@ class ofApp : public ofBaseApp
 		void keyPressed(int key);
 		void keyReleased(int key);
 		// the following two functions are used to check for key modifiers received from a Python pane
-		pyStdoutStrKeyModifier checkPyStdoutKeyModifier(int ndx);
+		pyStdoutStrKeyModifier checkPyStdoutKeyModifier(const std::string& str, int ndx);
 		void handleKeyModifier(pyStdoutStrKeyModifier modifierStruct);
+		void typePyStdoutChar();
+		void typePyStdoutBulk();
 		//---------------------------------
 		// adding/removing editor panes
 		void addPane(int key);
@@ -445,6 +632,16 @@ class ofApp : public ofBaseApp
 		void sendChangeBeatColorToPart(int instNdx, bool changeBeatColor);
 		void sendFullscreenToPart(int instNdx, bool fullscreen);
 		void sendCursorToPart(int instNdx, bool cursor);
+		void sendSettingToPart(int instNdx, ofxOscMessage m);
+		int getPrevDefinitionIndex(int barIndex);
+		ofxOscMessage genLineMessage(int instNdx, int barIndex, int prevBarIndex);
+		void requestPartSync(std::string host, int port);
+		void syncPart(PartSyncRequest& request);
+		//---------------------------------
+		// sequencer timing statistics
+		std::string getLatencyStatsStr();
+		void sendLatencyStats(std::string host, int port);
+		void dumpLatencyStats();
 		//---------------------------------
 		// debugging
 		void printVector(std::vector<int> v);
@@ -501,6 +698,7 @@ class ofApp : public ofBaseApp
 		// end of command API I/O functions
 		void initPyo();
 		CmdOutput functionFuncs(std::vector<std::string>& commands);
+		void setLoopData(int loopNdx, const std::vector<int>& bars);
 		int getLastLoopIndex();
 		int getLastBarIndex();
 		int getPrevBarIndex();
@@ -517,8 +715,8 @@ class ofApp : public ofBaseApp
 		void setScoreCoords();
 		void resetScoreYOffset();
 		void setScoreNotes(int barIndex);
-		void setNotePositions(int bar);
-		void setNotePositions(int bar, int numBars);
+		void setLayoutDirty(int bar);
+		void layoutBars(const std::vector<int>& bars);
 		void swapScorePosition(int orientation);
 		void setScoreSizes();
 		void calculateStaffPositions(int bar, bool windowChanged);
@@ -586,9 +784,31 @@ class ofApp : public ofBaseApp
 		bool inSoundDeviceSet;
 		bool outSoundDeviceSet;
 		// oscilloscope drawing stuff
-		ofSoundBuffer scopeBuffer;
+		// the audio thread pushes its output to scopeQueue and update() keeps the latest bufferSize frames
+		// which are reduced to a minimum and a maximum per pixel column before drawing
+		RingBuffer<ScopeFrame, SCOPEQUEUESIZE> scopeQueue;
+		std::vector<float> scopeLeft;
+		std::vector<float> scopeRight;
 		ofPolyline scopeWaveformLeft;
 		ofPolyline scopeWaveformRight;
+
+		// the score can be projected to a second window that draws the FBO the score is drawn to
+		// so the score is laid out and drawn only once, by the same process
+		std::shared_ptr<ofAppBaseWindow> projectionWindow;
+		ofEventListeners projectionListeners;
+		ofFbo scoreFbo;
+		bool scoreFboDirty; // the FBO is drawn again only when the score might have changed
+		int projectionMonitor; // the monitor to open the window full screen on, or one of the values defined above
+		int projectionWindowMonitor; // the same for the window that is open
+
+		// the piano roll keeps the clavier in meshes that are rebuilt only when the sizes change
+		// the notes of the two bars it shows are put in a mesh when the bars change, which is scrolled with a translation
+		ScoreBatch pianoRollKeys;
+		ScoreBatch pianoRollKeyLines;
+		ScoreBatch pianoRollNotes;
+		std::vector<PianoRollHighlight> pianoRollHighlights;
+		std::pair<int, int> pianoRollBars;
+		bool pianoRollDirty;
 		float scopeRms;
 
 		// shell commands stuff
@@ -612,6 +832,19 @@ class ofApp : public ofBaseApp
 		// so we can group instruments that send their data to the same server
 		// this way, generic messages will be sent only once
 		std::map<int, std::pair<std::string, int>> instrumentOSCHostPorts;
+		// when a bar is re-executed it gets a new index, and the map below stores the index of its previous definition
+		// so that only the lines of the instruments that changed are sent to the score parts
+		std::map<int, int> prevBarsIndexes;
+		// the last display settings sent to each part and the instrument groups
+		// so they can be sent again to a part that requests a sync
+		std::map<int, std::map<std::string, ofxOscMessage>> partSettings;
+		std::vector<ofxOscMessage> partGroups;
+		// periodic CSV dump of the sequencer timing statistics
+		std::string latencyDumpFile;
+		uint64_t latencyDumpInterval; // in ms, 0 for no dumping
+		uint64_t latencyDumpTimeStamp;
+		// replays trace files recorded with \trace.record
+		TracePlayer tracePlayer;
 
 		// time to wait for a positive/negative response from a server
 		uint64_t scorePartResponseTime;
@@ -657,14 +890,13 @@ class ofApp : public ofBaseApp
 		std::string maestroAddress;
 		std::string maestroToggleAddress;
 		std::string maestroLevareAddress;
-		int maestroValNdx;
+		// the two below are read by the OSC thread
+		std::atomic<int> maestroValNdx;
 		bool maestroToggleSet;
-		bool receivingMaestro;
+		std::atomic<bool> receivingMaestro;
 		bool maestroInitialized;
 		int maestroBeatsIn;
-		unsigned long maestroTimeStamp;
-		float maestroValThresh;
-		std::vector<float> maestroVec;
+		Maestro maestro;
 
 		enum errorTypeNdx {note, warning, error};
 
@@ -679,12 +911,16 @@ class ofApp : public ofBaseApp
 		ofColor beatColor;
 		ofColor scoreBackgroundColor;
 		float brightnessCoeff;
+		// the notes of all the instruments are drawn together at the end of drawScore()
+		ScoreBatch scoreBatch;
+		ScoreBench scoreBench;
 
 		ofTrueTypeFont font;
 		ofTrueTypeFont instFont;
 		bool fontLoaded;
 
-		ofxOscReceiver oscReceiver;
+		OscReceiverThread oscReceiver;
+		PartSyncThread partSyncer;
 		bool oscReceiverIsSet;
 
 		std::map<int, std::string> allStrings;
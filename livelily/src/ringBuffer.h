@@ -0,0 +1,97 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+// single-producer/single-consumer lock-free FIFO with a fixed capacity
+// one thread may only call push() and one other thread may only call pop() and front()
+// all the memory is allocated on construction, so no allocation happens while running
+// one slot is always kept empty to distinguish a full from an empty buffer
+template <typename T, size_t N>
+class RingBuffer
+{
+	public:
+		RingBuffer() : head(0), tail(0) {}
+
+		// returns false if the buffer is full, in which case the item is dropped
+		bool push(const T& item)
+		{
+			size_t h = head.load(std::memory_order_relaxed);
+			size_t next = (h + 1) % N;
+			if (next == tail.load(std::memory_order_acquire)) return false;
+			buffer[h] = item;
+			head.store(next, std::memory_order_release);
+			return true;
+		}
+
+		// returns false if the buffer is empty
+		bool pop(T& item)
+		{
+			size_t t = tail.load(std::memory_order_relaxed);
+			if (t == head.load(std::memory_order_acquire)) return false;
+			item = buffer[t];
+			tail.store((t + 1) % N, std::memory_order_release);
+			return true;
+		}
+
+		// pushes up to n items and returns how many were pushed
+		size_t push(const T *items, size_t n)
+		{
+			size_t h = head.load(std::memory_order_relaxed);
+			size_t t = tail.load(std::memory_order_acquire);
+			size_t space = (t + N - h - 1) % N;
+			if (n > space) n = space;
+			for (size_t i = 0; i < n; i++) {
+				buffer[(h + i) % N] = items[i];
+			}
+			head.store((h + n) % N, std::memory_order_release);
+			return n;
+		}
+
+		// pops up to n items and returns how many were popped
+		size_t pop(T *items, size_t n)
+		{
+			size_t t = tail.load(std::memory_order_relaxed);
+			size_t h = head.load(std::memory_order_acquire);
+			size_t available = (h + N - t) % N;
+			if (n > available) n = available;
+			for (size_t i = 0; i < n; i++) {
+				items[i] = buffer[(t + i) % N];
+			}
+			tail.store((t + n) % N, std::memory_order_release);
+			return n;
+		}
+
+		// returns a pointer to the oldest item without removing it, or nullptr if the buffer is empty
+		T *front()
+		{
+			size_t t = tail.load(std::memory_order_relaxed);
+			if (t == head.load(std::memory_order_acquire)) return nullptr;
+			return &buffer[t];
+		}
+
+		bool empty() const
+		{
+			return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+		}
+
+		size_t size() const
+		{
+			size_t h = head.load(std::memory_order_acquire);
+			size_t t = tail.load(std::memory_order_acquire);
+			return (h + N - t) % N;
+		}
+
+		size_t capacity() const
+		{
+			return N - 1;
+		}
+
+	private:
+		T buffer[N];
+		std::atomic<size_t> head;
+		std::atomic<size_t> tail;
+};
+
+#endif
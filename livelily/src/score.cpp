@@ -56,13 +56,14 @@ void Staff::setRhythm(bool isRhythm)
 void Staff::setSize(int fontSize, float staffLinesDist)
 {
 	Staff::fontSize = fontSize;
-	notationFont.load("sonata.ttf", fontSize);
-	BPMDisplayFont.load("times-new-roman.ttf", fontSize*0.6);
+	// the fonts are shared by the staffs and notes of all the instruments
+	notationFont = FontCache::get("sonata.ttf", fontSize);
+	BPMDisplayFont = FontCache::get("times-new-roman.ttf", (int)(fontSize*0.6));
 	staffDist = staffLinesDist;
-	noteWidth = notationFont.stringWidth(BPMDisplayNotes[2]);
-	clefLength = max(notationFont.stringWidth(clefSyms[0]), notationFont.stringWidth(clefSyms[1]));
-	clefLength = max(clefLength, notationFont.stringWidth(clefSyms[2]));
-	meterLength = notationFont.stringWidth("64");
+	noteWidth = notationFont->stringWidth(BPMDisplayNotes[2]);
+	clefLength = max(notationFont->stringWidth(clefSyms[0]), notationFont->stringWidth(clefSyms[1]));
+	clefLength = max(clefLength, notationFont->stringWidth(clefSyms[2]));
+	meterLength = notationFont->stringWidth("64");
 }
 
 //--------------------------------------------------------------
@@ -190,7 +191,7 @@ void Staff::drawStaff(int bar, float xStartPnt, float yStartPnt, float yOffset,
 	}
 	if (drawClef) {
 		if (clefIndex[bar] < 3) {
-			notationFont.drawString(clefSyms[clefIndex[bar]], xStartLocal+((yDist/2)*xCoefLocal),
+			notationFont->drawString(clefSyms[clefIndex[bar]], xStartLocal+((yDist/2)*xCoefLocal),
 									yStartPnt+(yDist*3.8)+yOffset);
 		}
 		else {
@@ -207,11 +208,11 @@ void Staff::drawStaff(int bar, float xStartPnt, float yStartPnt, float yOffset,
 		float denominatorY = numeratorY + (yDist*2);
 		if (drawClef) xPos += getClefXOffset();
 		if (meterIndex[bar] < 2) {
-			notationFont.drawString(meterSyms[meterIndex[bar]], xPos, numeratorY+yDist);
+			notationFont->drawString(meterSyms[meterIndex[bar]], xPos, numeratorY+yDist);
 		}
 		else {
-			notationFont.drawString(ofToString(numerator[bar]), xPos, numeratorY);
-			notationFont.drawString(ofToString(denominator[bar]), xPos, denominatorY);
+			notationFont->drawString(ofToString(numerator[bar]), xPos, numeratorY);
+			notationFont->drawString(ofToString(denominator[bar]), xPos, denominatorY);
 		}
 	}
 	if (drawLoopStartEnd) {
@@ -224,14 +225,14 @@ void Staff::drawStaff(int bar, float xStartPnt, float yStartPnt, float yOffset,
 		float offset = 0;
 		// the following line is taken from the clef drawing chunk above
 		float y = yStartPnt+(yDist*3.8)+yOffset;
-		y -= notationFont.stringHeight(clefSyms[0]);
+		y -= notationFont->stringHeight(clefSyms[0]);
 		if (BPMDisplayDots[bar]) {
 			ofDrawCircle(xStartPnt+(noteWidth*1.5), y, staffDist*0.2);
 			offset = noteWidth * 0.5;
 		}
 		std::string BPMString = " = " + std::to_string(BPMTempi[bar]);
-		notationFont.drawString(tempoBaseString, xStartPnt, y);
-		BPMDisplayFont.drawString(BPMString, xStartPnt+offset+noteWidth, y);
+		notationFont->drawString(tempoBaseString, xStartPnt, y);
+		BPMDisplayFont->drawString(BPMString, xStartPnt+offset+noteWidth, y);
 	}
 }
 
@@ -241,11 +242,11 @@ void Staff::drawLoopStart(int bar, float xStart, float yStartPnt, float yOffset)
 	// the " + (yDist*3.5)" is taken from drawStaff() where the meter is drawn
 	float xPos = xStart + (yDist*3.5);
 	if (meterIndex[bar] < 2) {
-		xPos += notationFont.stringWidth(meterSyms[meterIndex[bar]]);
+		xPos += notationFont->stringWidth(meterSyms[meterIndex[bar]]);
 	}
 	else {
-		float maxWidth = max(notationFont.stringWidth(ofToString(numerator[bar])),
-							 notationFont.stringWidth(ofToString(denominator[bar])));
+		float maxWidth = max(notationFont->stringWidth(ofToString(numerator[bar])),
+							 notationFont->stringWidth(ofToString(denominator[bar])));
 		xPos += maxWidth;
 	}
 	// a little bit of offset so that symbols are not clamped together
@@ -323,6 +324,8 @@ Notes::Notes()
 	accidentalsOffsetCoef = 1.2;
 	notesColor = ofColor::black;
 	activeNotesColor = ofColor::red;
+	countingDrawCalls = false;
+	numDrawCalls = 0;
 }
 
 //--------------------------------------------------------------
@@ -348,18 +351,36 @@ void Notes::setFontSize(int fontSize, float staffLinesDist)
 {
 	if (Notes::fontSize != fontSize) {
 		Notes::fontSize = fontSize;
-		notationFont.load("sonata.ttf", fontSize);
-		textFont.load("times-new-roman.ttf", fontSize/2);
-		noteWidth = notationFont.stringWidth(notesSyms[2]);
-		noteHeight = notationFont.stringHeight(notesSyms[2]);
+		notationFont = FontCache::get("sonata.ttf", fontSize);
+		textFont = FontCache::get("times-new-roman.ttf", fontSize/2);
+		// measuring the symbols stores their metrics in the font, so this is done once for all instruments
+		notationFont->measure(notesSyms, 5);
+		notationFont->measure(accSyms, 9);
+		notationFont->measure(restsSyms, 6);
+		notationFont->measure(dynSyms, 8);
+		notationFont->measure(articulSyms, 6);
+		notationFont->measure(octaveSyms, 3);
+		noteWidth = notationFont->stringWidth(notesSyms[2]);
+		noteHeight = notationFont->stringHeight(notesSyms[2]);
 		for (int i = 0; i < 8; i++) {
-			dynSymsWidths[i] = notationFont.stringWidth(dynSyms[i]);
-			dynSymsHeights[i] = notationFont.stringHeight(dynSyms[i]);
+			dynSymsWidths[i] = notationFont->stringWidth(dynSyms[i]);
+			dynSymsHeights[i] = notationFont->stringHeight(dynSyms[i]);
 		}
 		for (int i = 0; i < 6; i++) {
-			restsSymsWidths[i] = notationFont.stringWidth(restsSyms[i]);
-			restsSymsHeights[i] = notationFont.stringHeight(restsSyms[i]);
+			restsSymsWidths[i] = notationFont->stringWidth(restsSyms[i]);
+			restsSymsHeights[i] = notationFont->stringHeight(restsSyms[i]);
+			articulSymsHeights[i] = notationFont->stringHeight(articulSyms[i]);
 		}
+		for (int i = 0; i < 3; i++) {
+			octaveSymsHeights[i] = notationFont->stringHeight(octaveSyms[i]);
+		}
+		// a portando is drawn as a staccato above a tenuto
+		portandoHalfHeight = (notationFont->stringHeight(".") + notationFont->stringHeight("_")) / 2;
+		tupletNumWidths.clear();
+		for (auto it = allBars.begin(); it != allBars.end(); ++it) {
+			storeStringMetrics(*it);
+		}
+		invalidateLayout();
 		staffDist = staffLinesDist;
 		halfStaffDist = staffDist / 2.0;
 	}
@@ -368,6 +389,7 @@ void Notes::setFontSize(int fontSize, float staffLinesDist)
 //--------------------------------------------------------------
 void Notes::setCoords(float xLen, float staffLinesDist, int fontSize)
 {
+	if (xLength != xLen || staffDist != staffLinesDist) invalidateLayout();
 	xLength = xLen;
 	staffDist = staffLinesDist;
 	halfStaffDist = staffDist / 2;
@@ -407,18 +429,21 @@ float Notes::getMinVsAnchor(int bar)
 //--------------------------------------------------------------
 float Notes::getNoteWidth()
 {
-	return notationFont.stringWidth(notesSyms[0]);
+	if (!notationFont) return 0;
+	return notationFont->stringWidth(notesSyms[0]);
 }
 
 //--------------------------------------------------------------
 float Notes::getNoteHeight()
 {
-	return notationFont.stringHeight(notesSyms[0]);
+	if (!notationFont) return 0;
+	return notationFont->stringHeight(notesSyms[0]);
 }
 
 //--------------------------------------------------------------
 void Notes::setClef(int bar, int clefIdx)
 {
+	if (clefIndex[bar] != clefIdx) invalidateLayout(bar);
 	clefIndex[bar] = clefIdx;
 }
 
@@ -440,12 +465,24 @@ void Notes::setAnimation(bool anim)
 	animate = anim;
 }
 
+//--------------------------------------------------------------
+bool Notes::getAnimation()
+{
+	return animate;
+}
+
 //--------------------------------------------------------------
 void Notes::setActiveNote(int note)
 {
 	whichNote = note;
 }
 
+//--------------------------------------------------------------
+int Notes::getActiveNote()
+{
+	return whichNote;
+}
+
 //--------------------------------------------------------------
 void Notes::setMute(bool muteState)
 {
@@ -455,10 +492,14 @@ void Notes::setMute(bool muteState)
 //--------------------------------------------------------------
 void Notes::setMeter(int bar, int numer, int denom, int numBeats)
 {
+	float dist = xLength / numBeats;
+	if (numerator[bar] != numer || denominator[bar] != denom || beats[bar] != numBeats || distBetweenBeats[bar] != dist) {
+		invalidateLayout(bar);
+	}
 	numerator[bar] = numer;
 	denominator[bar] = denom;
 	beats[bar] = numBeats;
-	distBetweenBeats[bar] = xLength / numBeats;
+	distBetweenBeats[bar] = dist;
 }
 
 //--------------------------------------------------------------
@@ -524,6 +565,9 @@ void Notes::setNotes(int bar,
 	isLinked[bar] = std::make_pair(0, 0);
 	BPMMultiplier[bar] = BPMMult;
 	if (clefIndex[bar] != 0) changeNotesBasedOnClef(bar);
+	storeStringMetrics(bar);
+	invalidateLayout(bar);
+	invalidateNaturalSigns(bar);
 }
 
 //--------------------------------------------------------------
@@ -568,6 +612,7 @@ void Notes::correctDynamics(int bar, std::vector<int> dyns)
 	for (unsigned i = 0; i < dynamics[bar].size(); i++) {
 		dynamics[bar][i] = dyns[i];
 	}
+	invalidateLayout(bar, dynamicsPass);
 }
 
 //--------------------------------------------------------------
@@ -1276,13 +1321,13 @@ void Notes::storeArticulationsCoords(int bar)
 					if (((int)(abs(allNoteHeadCoordsY[bar][i][allChordsBaseIndexes[bar][i]]) / halfStaffDist) % 2) == 0) {
 						if (stemDirections[bar][i] > 0) yPos += halfStaffDist;
 						else  yPos -= halfStaffDist;
-						if (yPos + (notationFont.stringHeight(articulSyms[allArticulations[bar][i][j]-1])/2) > allNotesMaxYPos[bar][i] && yPos < FLT_MAX) {
+						if (yPos + (articulSymsHeights[allArticulations[bar][i][j]-1]/2) > allNotesMaxYPos[bar][i] && yPos < FLT_MAX) {
 							// articulation symbols start with index 1, because 0 is reserved for no articulation
 							// so we subtract 1 from the index
-							allNotesMaxYPos[bar][i] = yPos + (notationFont.stringHeight(articulSyms[allArticulations[bar][i][j]-1])/2);
+							allNotesMaxYPos[bar][i] = yPos + (articulSymsHeights[allArticulations[bar][i][j]-1]/2);
 						}
-						if (yPos - (notationFont.stringHeight(articulSyms[allArticulations[bar][i][j]-1])/2) < allNotesMinYPos[bar][i] && yPos > -FLT_MAX) {
-							allNotesMinYPos[bar][i] = yPos - (notationFont.stringHeight(articulSyms[allArticulations[bar][i][j]-1])/2);
+						if (yPos - (articulSymsHeights[allArticulations[bar][i][j]-1]/2) < allNotesMinYPos[bar][i] && yPos > -FLT_MAX) {
+							allNotesMinYPos[bar][i] = yPos - (articulSymsHeights[allArticulations[bar][i][j]-1]/2);
 						}
 					}
 				}
@@ -1309,7 +1354,7 @@ void Notes::storeArticulationsCoords(int bar)
 						}
 					}
 					// if case the articulation is a portando, we must get the height as in the line below
-					float halfArticulHeight = (notationFont.stringHeight(".") + notationFont.stringHeight("_")) / 2;
+					float halfArticulHeight = portandoHalfHeight;
 					if (yPosPortando + halfArticulHeight > allNotesMaxYPos[bar][i] && yPosPortando < FLT_MAX) {
 						allNotesMaxYPos[bar][i] = yPosPortando + halfArticulHeight;
 					}
@@ -1399,8 +1444,7 @@ void Notes::storeTupletCoords(int bar)
 		// we now need to calculate how much less of X and Y we need to draw
 		// for this we need the width and height of the std::string of the tuplet ratio
 		// for the Ys, this is only in case we don't draw a straight line
-		std::string tuplet = std::to_string(tupRatios[bar][it->first].first);
-		float stringWidth = textFont.stringWidth(tuplet);
+		float stringWidth = tupletNumWidths[tupRatios[bar][it->first].first];
 		vX[1] = vX[2] = vX[0] + ((vX[3] - vX[0]) / 2.0);
 		vX[1] -= stringWidth;
 		vX[2] += stringWidth;
@@ -1909,7 +1953,7 @@ void Notes::storeOttavaCoords(int bar)
 			if (allOttavas[bar][i] != prevOttava) {
 				allOttavasChangedAt[bar][i] = i;
 				float yPos;
-				float textHalfHeight = notationFont.stringHeight(octaveSyms[abs(allOttavas[bar][i])]) / 2;
+				float textHalfHeight = octaveSymsHeights[abs(allOttavas[bar][i])] / 2;
 				if (allOttavas[bar][i] > 0) {
 					// the compiler complains if I just compare with 0.0
 					// so I create a float here
@@ -1970,7 +2014,7 @@ void Notes::storeOttavaCoords(int bar)
 	// to the same value
 	unsigned prevChange = 0;
 	for (unsigned i = 1; i < allOttavasChangedAt[bar].size(); i++) {
-		float textHalfHeight = notationFont.stringHeight(octaveSyms[abs(allOttavas[bar][prevChange])]) / 2;
+		float textHalfHeight = octaveSymsHeights[abs(allOttavas[bar][prevChange])] / 2;
 		if (allOttavasChangedAt[bar][i] < 0) { // if the ottava hasn't changed here
 			// first check if all symbols within the same ottava don't fall on anything else
 			for (unsigned j = prevChange+1; j < allOttavasChangedAt[bar].size(); j++) {
@@ -2027,7 +2071,7 @@ void Notes::storeTextCoords(int bar)
 			if (allTextsIndexes.at(bar).at(i).at(j) != 0) {
 				allTextsXCoords.at(bar).at(i) = allNoteCoordsX.at(bar).at(i).at(allChordsBaseIndexes.at(bar).at(i))-(noteWidth/2.0);
 				float yPos;
-				float textHalfHeight = textFont.stringHeight(allTexts[bar][index]) / 2;
+				float textHalfHeight = textHalfHeights[bar][index];
 				if (allTextsIndexes.at(bar).at(i).at(j) > 0) {
 					allTextsYCoords.at(bar).at(i).at(j) = 0;
 					if (stemDirections.at(bar).at(i) > 0) {
@@ -2078,7 +2122,7 @@ void Notes::storeDynamicsCoords(int bar)
 		for (int j = 0; j < (int)allNotesMaxYPos[bar].size(); j++) {
 			if (dynamicsIndexes[bar][i] == j) {
 				float y = std::max((staffDist*4), allNotesMaxYPos[bar][j]);
-				y += (notationFont.stringHeight(dynSyms[dynamics[bar][i]]) * 1.2); // give a bit of room with 1.2
+				y += (dynSymsHeights[dynamics[bar][i]] * 1.2); // give a bit of room with 1.2
 				if (rhythm) y -= (staffDist * 2);
 				if (y > allNotesMaxYPos[bar][j]) allNotesMaxYPos[bar][j] = y;
 				dynsXCoords[bar][i] = allNoteCoordsX[bar][j][allChordsBaseIndexes[bar][j]]-dynSymsWidths[dynamics[bar][i]]/2;
@@ -2262,31 +2306,161 @@ void Notes::storeMinMaxY(int bar)
 	if (minYCoord[bar] > 0 && !tacet[bar]) minYCoord[bar] = 0;
 }
 
+//--------------------------------------------------------------
+void Notes::storeStringMetrics(int bar)
+{
+	// the font is only called from here, on the main thread, and the layout functions use the stored values
+	// bars set before the size of the score are measured once the fonts are loaded in setFontSize()
+	if (!textFont) return;
+	for (auto it = tupRatios[bar].begin(); it != tupRatios[bar].end(); ++it) {
+		if (tupletNumWidths.find(it->second.first) == tupletNumWidths.end()) {
+			tupletNumWidths[it->second.first] = textFont->stringWidth(std::to_string(it->second.first));
+		}
+	}
+	textHalfHeights[bar].clear();
+	for (auto it = allTexts[bar].begin(); it != allTexts[bar].end(); ++it) {
+		textHalfHeights[bar].push_back(textFont->stringHeight(*it) / 2);
+	}
+}
+
+//--------------------------------------------------------------
+void Notes::invalidateLayout(int bar, int fromPass)
+{
+	auto it = layoutFirstPass.find(bar);
+	if (it == layoutFirstPass.end() || it->second > fromPass) layoutFirstPass[bar] = fromPass;
+}
+
+//--------------------------------------------------------------
+void Notes::invalidateLayout()
+{
+	for (auto it = allNotes.begin(); it != allNotes.end(); ++it) {
+		layoutFirstPass[it->first] = positionsPass;
+	}
+}
+
+//--------------------------------------------------------------
+bool Notes::isLayoutDirty(int bar)
+{
+	return getFirstDirtyPass(bar) < numLayoutPasses;
+}
+
+//--------------------------------------------------------------
+int Notes::getFirstDirtyPass(int bar)
+{
+	auto it = layoutFirstPass.find(bar);
+	if (it == layoutFirstPass.end()) return numLayoutPasses;
+	// a bar that hasn't been laid out yet has no extents to start a later pass from
+	if (it->second > positionsPass && it->second < numLayoutPasses) {
+		auto extentsIt = layoutExtents.find(bar);
+		if (extentsIt == layoutExtents.end() || extentsIt->second.find(it->second) == extentsIt->second.end()) return positionsPass;
+	}
+	return it->second;
+}
+
+//--------------------------------------------------------------
+void Notes::runLayoutPass(int bar, int pass, bool first)
+{
+	// the extents before the slurs and the dynamics passes are stored when a bar is laid out
+	// and restored when it is laid out again from one of them
+	if (pass == slursPass || pass == dynamicsPass) {
+		LayoutExtents& extents = layoutExtents[bar][pass];
+		if (first) {
+			allNotesMaxYPos[bar] = extents.maxYPos;
+			allNotesMinYPos[bar] = extents.minYPos;
+			maxYCoord[bar] = extents.maxY;
+			minYCoord[bar] = extents.minY;
+		}
+		else {
+			extents.maxYPos = allNotesMaxYPos[bar];
+			extents.minYPos = allNotesMinYPos[bar];
+			extents.maxY = maxYCoord[bar];
+			extents.minY = minYCoord[bar];
+		}
+	}
+	switch (pass) {
+		case positionsPass:
+			setNotePositions(bar);
+			break;
+		case articulationsPass:
+			storeArticulationsCoords(bar);
+			break;
+		case tupletsPass:
+			storeTupletCoords(bar);
+			break;
+		case slursPass:
+			storeSlurCoords(bar);
+			break;
+		case ottavasPass:
+			storeOttavaCoords(bar);
+			break;
+		case textsPass:
+			storeTextCoords(bar);
+			break;
+		case dynamicsPass:
+			storeDynamicsCoords(bar);
+			break;
+		default:
+			break;
+	}
+	storeMinMaxY(bar);
+}
+
+//--------------------------------------------------------------
+void Notes::setLayoutClean(int bar)
+{
+	layoutFirstPass.erase(bar);
+}
+
 //--------------------------------------------------------------
 void Notes::deleteBar(int bar)
 {
 	allNotes.erase(bar);
+	layoutFirstPass.erase(bar);
+	layoutExtents.erase(bar);
+	invalidateNaturalSigns(bar);
 }
 
 //--------------------------------------------------------------
-void Notes::insertNaturalSigns(int bar, int loopNdx, std::vector<int> *v)
+const std::vector<std::vector<int>>& Notes::getNaturalSigns(int bar, int loop, int loopNdx, std::vector<int> *v)
 {
+	// the natural signs of a bar at a position of a loop are searched the first time the bar is drawn there
+	// and stay stored until the loop is stored again or the notes of a bar displayed before it change
+	std::map<std::pair<int, int>, NaturalSigns>& barNaturals = naturalSigns[bar];
+	auto it = barNaturals.find(std::make_pair(loop, loopNdx));
+	if (it == barNaturals.end()) {
+		NaturalSigns signs;
+		signs.prevBars.assign(v->begin(), v->begin() + std::min(loopNdx, (int)v->size()));
+		signs.naturals = findNaturalSigns(bar, signs.prevBars);
+		it = barNaturals.insert(std::make_pair(std::make_pair(loop, loopNdx), std::move(signs))).first;
+	}
+	return it->second.naturals;
+}
+
+//--------------------------------------------------------------
+std::vector<std::vector<int>> Notes::findNaturalSigns(int bar, const std::vector<int>& prevBars)
+{
+	std::vector<std::vector<int>> naturals;
+	for (unsigned i = 0; i < allNotes[bar].size(); i++) {
+		naturals.push_back(std::vector<int>(allNotes[bar][i].size(), 0));
+	}
 	// create an array of booleans where the index is the note and the value
 	// determines whether this note has already been corrected
 	int notesAlreadyCorrected[7] = {0};
 	// iterate backwards through the bars already displayed to see if we need to add a natural sign
-	for (int i = loopNdx-1; i >= 0; i--) {
-		for (int j = (int)allNotes[v->at(i)].size()-1; j >= 0; j--) {
-			for (int k = (int)allNotes[v->at(i)][j].size()-1; k >= 0; k--) {
+	for (int i = (int)prevBars.size()-1; i >= 0; i--) {
+		if (allNotes.find(prevBars[i]) == allNotes.end()) continue;
+		std::vector<std::vector<int>>& prevNotes = allNotes[prevBars[i]];
+		std::vector<std::vector<int>>& prevAccidentals = allAccidentals[prevBars[i]];
+		for (int j = (int)prevNotes.size()-1; j >= 0; j--) {
+			for (int k = (int)prevNotes[j].size()-1; k >= 0; k--) {
 				// once we access a note from a previous bar, we iterate over this bar to see if we have the same note
 				for (unsigned l = 0; l < allNotes[bar].size(); l++) {
 					for (unsigned m = 0; m < allNotes[bar][l].size(); m++) {
-						if (allNotes[v->at(i)][j][k] == allNotes[bar][l][m] && \
-								allAccidentals[v->at(i)][j][k] != allAccidentals[bar][l][m] &&
+						if (prevNotes[j][k] == allNotes[bar][l][m] && \
+								prevAccidentals[j][k] != allAccidentals[bar][l][m] &&
 								(allAccidentals[bar][l][m] == -1 || allAccidentals[bar][l][m] != 4)) {
 							if (!notesAlreadyCorrected[allNotes[bar][l][m]]) {
-								// the boolean below will be set to false once this additional natural sign is drawn
-								naturalSignsNotWritten[bar][l][m] = 1;
+								naturals[l][m] = 1;
 								notesAlreadyCorrected[allNotes[bar][l][m]] = 1;
 							}
 						}
@@ -2295,6 +2469,32 @@ void Notes::insertNaturalSigns(int bar, int loopNdx, std::vector<int> *v)
 			}
 		}
 	}
+	return naturals;
+}
+
+//--------------------------------------------------------------
+void Notes::invalidateNaturalSigns(int bar)
+{
+	// the signs of this bar, and of any bar that was displayed after it, must be searched again
+	naturalSigns.erase(bar);
+	for (auto it = naturalSigns.begin(); it != naturalSigns.end(); ++it) {
+		for (auto it2 = it->second.begin(); it2 != it->second.end();) {
+			const std::vector<int>& prevBars = it2->second.prevBars;
+			if (std::find(prevBars.begin(), prevBars.end(), bar) != prevBars.end()) it2 = it->second.erase(it2);
+			else ++it2;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void Notes::invalidateLoopNaturalSigns(int loop)
+{
+	for (auto it = naturalSigns.begin(); it != naturalSigns.end(); ++it) {
+		for (auto it2 = it->second.begin(); it2 != it->second.end();) {
+			if (it2->first.first == loop) it2 = it->second.erase(it2);
+			else ++it2;
+		}
+	}
 }
 
 //--------------------------------------------------------------
@@ -2303,6 +2503,33 @@ std::pair<int, int> Notes::isBarLinked(int bar)
 	return isLinked[bar];
 }
 
+//--------------------------------------------------------------
+std::pair<bool, bool> Notes::getSlurLinks(int bar)
+{
+	// whether a slur of this bar starts in the previous bar and whether one ends in the next bar
+	// this is known from the parsed slur indexes, before the bar is laid out
+	std::pair<bool, bool> links = std::make_pair(false, false);
+	auto it = slurIndexes.find(bar);
+	if (it == slurIndexes.end()) return links;
+	// a single pair of -1s is stored both for bars without slurs and for bars slurred entirely
+	if (it->second.size() == 1 && it->second[0].first == -1 && it->second[0].second == -1) {
+		auto wholeIt = isWholeSlurred.find(bar);
+		if (wholeIt != isWholeSlurred.end() && wholeIt->second) links = std::make_pair(true, true);
+		return links;
+	}
+	for (auto slurIt = it->second.begin(); slurIt != it->second.end(); ++slurIt) {
+		if (slurIt->first == -1 && slurIt->second > -1) links.first = true;
+		if (slurIt->second == -1 && slurIt->first > -1) links.second = true;
+	}
+	return links;
+}
+
+//--------------------------------------------------------------
+bool Notes::hasBar(int bar)
+{
+	return allNotes.find(bar) != allNotes.end();
+}
+
 //--------------------------------------------------------------
 void Notes::moveScoreX(int numPixels)
 {
@@ -2322,10 +2549,38 @@ void Notes::recenterScore()
 }
 
 //--------------------------------------------------------------
-void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt, float yStartPnt, float yOffset, bool animation, float xCoef)
+void Notes::setCountDrawCalls(bool count)
+{
+	countingDrawCalls = count;
+}
+
+//--------------------------------------------------------------
+unsigned Notes::getNumDrawCalls()
+{
+	return numDrawCalls;
+}
+
+//--------------------------------------------------------------
+void Notes::resetNumDrawCalls()
+{
+	numDrawCalls = 0;
+}
+
+//--------------------------------------------------------------
+void Notes::countDrawCalls(unsigned n)
+{
+	if (countingDrawCalls) numDrawCalls += n;
+}
+
+//--------------------------------------------------------------
+void Notes::drawNotes(int bar, int loop, int loopNdx, std::vector<int> *v, float xStartPnt, float yStartPnt, float yOffset, bool animation, float xCoef)
 {
 	if (allNotes.find(bar) == allNotes.end()) return;
 	ofSetColor(notesColor  * ((ofApp*)ofGetAppPtr())->brightnessCoeff);
+	// the note heads, stems, ledger lines, dots, tails, beams, and accidentals are added to the batch of the score
+	// which draws them all together once the score has been drawn
+	ScoreBatch& batch = ((ofApp*)ofGetAppPtr())->scoreBatch;
+	ofColor color = notesColor * ((ofApp*)ofGetAppPtr())->brightnessCoeff;
 	float xCoefLocal = xCoef;
 	//if (scoreOrientation > 0) xCoefLocal = 1;
 	// each bar must store its xStartPnt dynamically when drawn
@@ -2334,9 +2589,9 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 	xOffsets[bar] = xStartPnt;
 	if (!mute) {
 		// first determine if there is any natural sign that needs to be inserted
-		// the second argument is the index within the loop that displays the bars horizontally
-		// the third is a pointer to the std::vector that holds the bar indexes (map keys) of the currently playing loop
-		if (loopNdx > 0) insertNaturalSigns(bar, loopNdx, v);
+		// the second argument is the loop the bars are taken from, and the third the index within the loop that displays the bars horizontally
+		// the fourth is a pointer to the std::vector that holds the bar indexes (map keys) of the currently playing loop
+		const std::vector<std::vector<int>> *naturals = (loopNdx > 0 ? &getNaturalSigns(bar, loop, loopNdx, v) : nullptr);
 		for (unsigned i = 0; i < allNotes.at(bar).size(); i++) {
 			ofColor restsColor = notesColor;
 			for (unsigned j = 0; j < allNotes.at(bar).at(i).size(); j++) {
@@ -2346,13 +2601,13 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 					// draw the extra lines first so the animation is drawn on top
 					for (int k = 0; k < abs(numExtraLines.at(bar).at(i).at(j)); k++) {
 						yPos += (staffDist * extraLinesDir.at(bar).at(i).at(j));
-						ofDrawLine(xStartLocal - (noteWidth*EXTRALINECOEFF), yPos, xStartLocal + (noteWidth*EXTRALINECOEFF), yPos);
+						batch.addLine(xStartLocal - (noteWidth*EXTRALINECOEFF), yPos, xStartLocal + (noteWidth*EXTRALINECOEFF), yPos, color);
 					}
 				}
 				if (j == 0) {
 					// then set the animation color
 					if (animation && animate && whichNote == (int)i) {
-						ofSetColor(activeNotesColor.r * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
+						color = ofColor(activeNotesColor.r * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
 								activeNotesColor.g * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
 								activeNotesColor.b * ((ofApp*)ofGetAppPtr())->brightnessCoeff);
 						restsColor = activeNotesColor;
@@ -2364,7 +2619,7 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 					float x = xStartPnt + (allNoteCoordsX.at(bar).at(i).at(j) * xCoefLocal);
 					//if (allNoteShiftX.at(bar).at(i).at(j)) x += noteWidth;
 					float y = yStartPnt + allNoteHeadCoordsY.at(bar).at(i).at(j)+(noteHeight/8.0)-(staffDist/10.0) + yOffset;
-					notationFont.drawString(notesSyms[noteIdx], x-(noteWidth/2.0), y);
+					batch.addString(notationFont->getFont(), notesSyms[noteIdx], x-(noteWidth/2.0), y, color);
 					if (dotIndexes.at(bar).at(i) > 0) {
 						// if the note is on a line or we have a rest
 						if (((int)(((y+yOffset) - yStartPnt) / halfStaffDist) % 2) == scoreOrientationForDots) {
@@ -2372,7 +2627,7 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 							y -= halfStaffDist;
 						}
 						for (unsigned j = 0; j < dotsCounter.at(bar).at(i); j++) {
-							ofDrawCircle(x+(noteWidth/1.5), y, staffDist*0.2);
+							batch.addCircle(x+(noteWidth/1.5), y, staffDist*0.2, color);
 							x += (staffDist * 0.5);
 						}
 					}
@@ -2383,7 +2638,7 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 				int restIndex = drawRest(bar, actualDurs.at(bar).at(i), x, yStartPnt, restsColor, yOffset);
 				if (dotIndexes.at(bar).at(i) == 1) {
 					for (unsigned j = 0; j < dotsCounter.at(bar).at(i); j++) {
-						ofDrawCircle(x+(notationFont.stringWidth(restsSyms[restIndex])*1.2), middleOfStaff+yStartPnt+yOffset-halfStaffDist, staffDist*0.2);
+						batch.addCircle(x+(notationFont->stringWidth(restsSyms[restIndex])*1.2), middleOfStaff+yStartPnt+yOffset-halfStaffDist, staffDist*0.2, color);
 						x += (staffDist * 0.5);
 					}
 				}
@@ -2395,7 +2650,7 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 				else x -= ((noteWidth / 2.0) - (lineWidth / 2.0));
 				float y1 = yStartPnt + allNoteHeadCoordsY.at(bar).at(i)[allChordsBaseIndexes.at(bar).at(i)]+(noteHeight/8.0)-(staffDist/10.0) + yOffset;
 				float y2 = allNoteStemCoordsY.at(bar).at(i) + yStartPnt + yOffset;
-				ofDrawLine(x, y1, x, y2);
+				batch.addLine(x, y1, x, y2, color);
 			}
 			// then draw the individual tails
 			int numTailsLocal = log(actualDurs.at(bar).at(i)) / log(2) - 2;
@@ -2418,12 +2673,12 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 				}
 				int loopIter = abs(numTailsLocal);
 				for (int j = 0; j < loopIter; j++) {
-					notationFont.drawString(notesSyms[symIdx], xPos, yPos+((j*(staffDist*BEAMDISTCOEFF))*tailDir));
+					batch.addString(notationFont->getFont(), notesSyms[symIdx], xPos, yPos+((j*(staffDist*BEAMDISTCOEFF))*tailDir), color);
 				}
 			}
 			// reset the animation color
 			if (animation && animate && whichNote == (int)i) {
-				ofSetColor(notesColor.r * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
+				color = ofColor(notesColor.r * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
 						notesColor.g * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
 						notesColor.b * ((ofApp*)ofGetAppPtr())->brightnessCoeff);
 			}
@@ -2503,7 +2758,7 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 				}
 			}
 		}
-		drawAccidentals(bar, xStartPnt, yStartPnt, yOffset, xCoef);
+		drawAccidentals(bar, naturals, xStartPnt, yStartPnt, yOffset, xCoef);
 		drawGlissandi(bar, xStartPnt, yStartPnt, yOffset, xCoef);
 		drawTuplets(bar, xStartPnt, yStartPnt, yOffset, xCoef);
 		drawArticulations(bar, xStartPnt, yStartPnt, yOffset, xCoef);
@@ -2524,13 +2779,14 @@ void Notes::drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt
 //--------------------------------------------------------------
 int Notes::drawRest(int bar, int restDur, float x, float yStartPnt, ofColor color, float yOffset)
 {
-	ofSetColor(color * ((ofApp*)ofGetAppPtr())->brightnessCoeff);
+	ScoreBatch& batch = ((ofApp*)ofGetAppPtr())->scoreBatch;
+	color *= ((ofApp*)ofGetAppPtr())->brightnessCoeff;
 	int indexLocal;
 	if (restDur < 4) {
 		indexLocal = 0;
 		float y = yStartPnt + staffDist + halfStaffDist+((staffDist/2.0)*(restDur-1)) + yOffset;
 		if (rhythm && restDur == 1) y += staffDist;
-		notationFont.drawString(restsSyms[indexLocal], x-(noteHeight/2), y);
+		batch.addString(notationFont->getFont(), restsSyms[indexLocal], x-(noteHeight/2), y, color);
 	}
 	else {
 		indexLocal = (log(restDur) / log(2)) - 1;
@@ -2554,13 +2810,9 @@ int Notes::drawRest(int bar, int restDur, float x, float yStartPnt, ofColor colo
 			// so we subtract one full space
 			if (indexLocal > 3) extraOffset -= staffDist;
 		}
-		notationFont.drawString(restsSyms[indexLocal], x-((noteHeight*1.5)/2.0),
-				yStartPnt+staffDist+extraOffset+yOffset);
+		batch.addString(notationFont->getFont(), restsSyms[indexLocal], x-((noteHeight*1.5)/2.0),
+				yStartPnt+staffDist+extraOffset+yOffset, color);
 	}
-	// we reset the color to notes color as the rest of the things we draw should have that color
-	ofSetColor(notesColor.r * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
-			notesColor.g * ((ofApp*)ofGetAppPtr())->brightnessCoeff,
-			notesColor.b * ((ofApp*)ofGetAppPtr())->brightnessCoeff);
 	return indexLocal;
 }
 
@@ -2581,19 +2833,17 @@ void Notes::drawBeams(float x1, float y1, float x2, float y2)
 	b.y = y2;
 	ofPoint diff = (a - b).getNormalized();
 	diff.rotate(90, ofPoint(0,0,1));
-	ofMesh m;
-	m.setMode(OF_PRIMITIVE_TRIANGLE_STRIP);
-	m.addVertex(a + diff * beamsLineWidth);
-	m.addVertex(a - diff * beamsLineWidth);
-	m.addVertex(b + diff * beamsLineWidth);
-	m.addVertex(b - diff * beamsLineWidth);
-	m.draw();
+	((ofApp*)ofGetAppPtr())->scoreBatch.addQuad(a + diff * beamsLineWidth, a - diff * beamsLineWidth,
+			b + diff * beamsLineWidth, b - diff * beamsLineWidth,
+			notesColor * ((ofApp*)ofGetAppPtr())->brightnessCoeff);
 }
 
 //--------------------------------------------------------------
-void Notes::drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef)
+void Notes::drawAccidentals(int bar, const std::vector<std::vector<int>> *naturals, float xStartPnt, float yStartPnt, float yOffset, float xCoef)
 {
 	if (tacet[bar]) return;
+	ScoreBatch& batch = ((ofApp*)ofGetAppPtr())->scoreBatch;
+	ofColor color = notesColor * ((ofApp*)ofGetAppPtr())->brightnessCoeff;
 	float xCoefLocal = xCoef;
 	float prevX = FLT_MIN, prevY = FLT_MIN;
 	//if (scoreOrientation > 0) xCoefLocal = 1;
@@ -2613,23 +2863,22 @@ void Notes::drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOf
 							x -= (staffDist * accidentalsOffsetCoef);
 						}
 					}
-					notationFont.drawString(accSyms[allAccidentals[bar][i][j]],
+					batch.addString(notationFont->getFont(), accSyms[allAccidentals[bar][i][j]],
 							(x*xCoefLocal)+xStartPnt-(noteWidth*1.2),
-							y+yStartPnt+yOffset);
+							y+yStartPnt+yOffset, color);
 					prevY = y;
 					prevX = x;
 				}
 			}
-			if (naturalSignsNotWritten[bar][i][j]) {
+			if (naturalSignsNotWritten[bar][i][j] || (naturals != nullptr && (*naturals)[i][j])) {
 				if (abs(y-prevY) < staffDist * 3 && j > 0) {
 					if (prevX == (allNoteCoordsX[bar][i][allChordsBaseIndexes[bar][i]] - allNoteCoordsXOffset[bar][i])) {
 						x -= (staffDist * accidentalsOffsetCoef);
 					}
 				}
-				notationFont.drawString(accSyms[4],
+				batch.addString(notationFont->getFont(), accSyms[4],
 						(x*xCoefLocal)+xStartPnt-(noteWidth*1.2),
-						y+yStartPnt+yOffset);
-				naturalSignsNotWritten[bar][i][j] = 0;
+						y+yStartPnt+yOffset, color);
 				prevY = y;
 				prevX = x;
 			}
@@ -2671,7 +2920,7 @@ void Notes::drawGlissandi(int bar, float xStartPnt, float yStartPnt, float yOffs
 					if (stemDirections[bar][i+1] < 0) {
 						xEnd += staffDist;
 					}
-					xEnd -= (notationFont.stringWidth(accSyms[allAccidentals[bar][i+1][allChordsBaseIndexes[bar][i]]])/2.0);
+					xEnd -= (notationFont->stringWidth(accSyms[allAccidentals[bar][i+1][allChordsBaseIndexes[bar][i]]])/2.0);
 				}
 			}
 			if (stemDirections[bar][i] > 0) {
@@ -2700,6 +2949,7 @@ void Notes::drawGlissandi(int bar, float xStartPnt, float yStartPnt, float yOffs
 				}
 			}
 			ofDrawLine(xStart, yStart, xEnd, yEnd);
+			countDrawCalls(1);
 		}
 	}
 }
@@ -2711,8 +2961,8 @@ void Notes::drawTuplets(int bar, float xStartPnt, float yStartPnt, float yOffset
 	for (auto it = tupStartStop[bar].begin(); it != tupStartStop[bar].end(); ++it) {
 		// the std::string of the tuplet number to be displayed
 		std::string tuplet = std::to_string(tupRatios[bar][it->first].first);
-		float halfStringHeight = textFont.stringHeight(tuplet) * 0.5;
-		float halfStringWidth = textFont.stringWidth(tuplet) * 0.5;
+		float halfStringHeight = textFont->stringHeight(tuplet) * 0.5;
+		float halfStringWidth = textFont->stringWidth(tuplet) * 0.5;
 		for (int i = 0; i < 2; i++) {
 			ofDrawLine((tupXCoords[bar][it->first][i*2] * xCoef) + xStartPnt,
 					tupYCoords[bar][it->first][i*2] + yStartPnt + yOffset,
@@ -2722,9 +2972,11 @@ void Notes::drawTuplets(int bar, float xStartPnt, float yStartPnt, float yOffset
 					tupYCoords[bar][it->first][(i*2)+i] + yStartPnt,
 					(tupXCoords[bar][it->first][(i*2)+i] * xCoef) + xStartPnt,
 					tupYCoords[bar][it->first][(i*2)+i]+(halfStaffDist*tupDirs[bar][it->first]) + yStartPnt + yOffset);
+			countDrawCalls(2);
 		}
-		textFont.drawString(tuplet, (tupXCoords[bar][it->first][1] * xCoef) + xStartPnt + halfStringWidth,
+		textFont->drawString(tuplet, (tupXCoords[bar][it->first][1] * xCoef) + xStartPnt + halfStringWidth,
 				tupYCoords[bar][it->first][1] + halfStringHeight + yStartPnt + yOffset);
+		countDrawCalls(1);
 	}
 }
 
@@ -2744,12 +2996,13 @@ void Notes::drawArticulations(int bar, float xStartPnt, float yStartPnt, float y
 						ofPushMatrix();
 						ofTranslate((articulXPos[bar][i]*xCoefLocal)+xStartPnt, articulYPos[bar][i][j]+yStartPnt+yOffset);
 						ofRotateXDeg(180);
-						notationFont.drawString(articulStr, 0, 0);
+						notationFont->drawString(articulStr, 0, 0);
 						ofPopMatrix();
 					}
 					else {
-						notationFont.drawString(articulStr, (articulXPos[bar][i]*xCoefLocal)+xStartPnt, articulYPos[bar][i][j]+yStartPnt+yOffset);
+						notationFont->drawString(articulStr, (articulXPos[bar][i]*xCoefLocal)+xStartPnt, articulYPos[bar][i][j]+yStartPnt+yOffset);
 					}
+					countDrawCalls(1);
 				}
 				else {
 					float offset;
@@ -2759,8 +3012,9 @@ void Notes::drawArticulations(int bar, float xStartPnt, float yStartPnt, float y
 					else {
 						offset = -halfStaffDist;
 					}
-					notationFont.drawString(".", (articulXPos[bar][i]*xCoefLocal)+xStartPnt+(noteWidth/2), articulYPos[bar][i][j]+yStartPnt+yOffset);
-					notationFont.drawString("_", (articulXPos[bar][i]*xCoefLocal)+xStartPnt, articulYPos[bar][i][j]+yStartPnt+offset+yOffset);
+					notationFont->drawString(".", (articulXPos[bar][i]*xCoefLocal)+xStartPnt+(noteWidth/2), articulYPos[bar][i][j]+yStartPnt+yOffset);
+					notationFont->drawString("_", (articulXPos[bar][i]*xCoefLocal)+xStartPnt, articulYPos[bar][i][j]+yStartPnt+offset+yOffset);
+					countDrawCalls(2);
 				}
 			}
 		}
@@ -2775,7 +3029,8 @@ void Notes::drawOttavas(int bar, float xStartPnt, float yStartPnt, float yOffset
 	int prevOttava = 0;
 	for (unsigned i = 0; i < allOttavas[bar].size(); i++) {
 		if (allOttavas[bar][i] != prevOttava && allOttavas[bar][i] != 0) {
-			notationFont.drawString(octaveSyms[abs(allOttavas[bar][i])], (allNoteCoordsX[bar][i][0]*xCoefLocal)+xStartPnt, allOttavasYCoords[bar][i]+yStartPnt+yOffset);
+			notationFont->drawString(octaveSyms[abs(allOttavas[bar][i])], (allNoteCoordsX[bar][i][0]*xCoefLocal)+xStartPnt, allOttavasYCoords[bar][i]+yStartPnt+yOffset);
+			countDrawCalls(1);
 		}
 		prevOttava = allOttavas[bar][i];
 	}
@@ -2817,8 +3072,8 @@ void Notes::drawOttavaLine(int bar, unsigned startNdx, unsigned endNdx, float xS
 	float xStart = (allNoteCoordsX[bar][startNdx][0] * xCoefLocal) + xStartPnt;
 	float xEnd = (allNoteCoordsX[bar][endNdx][0] * xCoefLocal) + xStartPnt;
 	float y = allOttavasYCoords[bar][startNdx] + yStartPnt + yOffset;
-	float textHalfHeight = notationFont.stringHeight(octaveSyms[abs(allOttavas[bar][startNdx])]) / 2;
-	xStart += notationFont.stringWidth(octaveSyms[abs(allOttavas[bar][startNdx])]);
+	float textHalfHeight = notationFont->stringHeight(octaveSyms[abs(allOttavas[bar][startNdx])]) / 2;
+	xStart += notationFont->stringWidth(octaveSyms[abs(allOttavas[bar][startNdx])]);
 	ofDrawLine(xStart, y, xEnd, y);
 	if (allOttavas[bar][startNdx] > 0) {
 		ofDrawLine(xEnd, y, xEnd, y+textHalfHeight);
@@ -2826,6 +3081,7 @@ void Notes::drawOttavaLine(int bar, unsigned startNdx, unsigned endNdx, float xS
 	else {
 		ofDrawLine(xEnd, y, xEnd, y-textHalfHeight);
 	}
+	countDrawCalls(2);
 }
 
 //--------------------------------------------------------------
@@ -2837,7 +3093,8 @@ void Notes::drawText(int bar, float xStartPnt, float yStartPnt, float yOffset, f
 	for (unsigned i = 0; i < allTextsIndexes.at(bar).size(); i++) {
 		for (unsigned j = 0; j < allTextsIndexes.at(bar).at(i).size(); j++) {
 			if (allTextsIndexes.at(bar).at(i).at(j) != 0) {
-				textFont.drawString(allTexts.at(bar).at(index++), (allTextsXCoords.at(bar).at(i)*xCoefLocal)+xStartPnt, allTextsYCoords.at(bar).at(i).at(j)+yStartPnt+yOffset);
+				textFont->drawString(allTexts.at(bar).at(index++), (allTextsXCoords.at(bar).at(i)*xCoefLocal)+xStartPnt, allTextsYCoords.at(bar).at(i).at(j)+yStartPnt+yOffset);
+				countDrawCalls(1);
 			}
 		}
 	}
@@ -2887,6 +3144,7 @@ void Notes::drawSlurs(int bar, int loopNdx, float xStartPnt, float yStartPnt, fl
 		ofVertex(x0, y0);
 		ofBezierVertex(x1, y1, x2, y2, x3, y3);
 		ofEndShape();
+		countDrawCalls(1);
 	}
 	ofFill();
 }
@@ -2937,6 +3195,7 @@ void Notes::drawTie(int thisBar, unsigned i, unsigned j, float xStartPnt, float
 	ofVertex(x0, y);
 	ofBezierVertex(x1, yMiddle, x2, yMiddle, x3, y);
 	ofEndShape();
+	countDrawCalls(1);
 }
 
 //--------------------------------------------------------------
@@ -2946,7 +3205,8 @@ void Notes::drawDynamics(int bar, float xStartPnt, float yStartPnt, float yOffse
 	//if (scoreOrientation > 0) xCoefLocal = 1;
 	for (unsigned i = 0; i < dynamics[bar].size(); i++) {
 		if (dynamics[bar][i] > -1) {
-			notationFont.drawString(dynSyms[dynamics[bar][i]], (dynsXCoords[bar][i]*xCoefLocal)+xStartPnt, dynsYCoords[bar][i]+yStartPnt+yOffset);
+			notationFont->drawString(dynSyms[dynamics[bar][i]], (dynsXCoords[bar][i]*xCoefLocal)+xStartPnt, dynsYCoords[bar][i]+yStartPnt+yOffset);
+			countDrawCalls(1);
 		}
 	}
 	for (unsigned i = 0; i < dynamicsRampStart[bar].size(); i++) {
@@ -2965,6 +3225,7 @@ void Notes::drawDynamics(int bar, float xStartPnt, float yStartPnt, float yOffse
 						dynsRampStartYCoords[bar][i]+yStartPnt+(staffDist*(((dynamicsRampDir[bar][i]*(-1))+1)*((j*2)-1)))+yOffset,
 						(dynsRampEndXCoords[bar][endNdx]*xCoefLocal)+xStartPnt,
 						dynsRampEndYCoords[bar][endNdx]+yStartPnt+(staffDist*(dynamicsRampDir[bar][i]*((j*2)-1)))+yOffset);
+				countDrawCalls(1);
 			}
 		}
 	}
@@ -2,6 +2,7 @@
 #define SCORE_H
 
 #include "ofMain.h"
+#include "fontCache.h"
 #include <vector>
 
 #define EXTRALINECOEFF 0.7
@@ -72,10 +73,30 @@ class Staff
 		std::map<int, int> clefIndex;
 		int fontSize;
 		bool rhythm; // for rhythmic instruments
-		ofTrueTypeFont notationFont;
-		ofTrueTypeFont BPMDisplayFont;
+		std::shared_ptr<CachedFont> notationFont;
+		std::shared_ptr<CachedFont> BPMDisplayFont;
 };
 
+// the layout passes in the order they run
+// each pass extends the vertical extents of the notes left by the passes before it
+// so a pass that runs again is followed by all the passes after it
+enum layoutPasses {positionsPass, articulationsPass, tupletsPass, slursPass, ottavasPass, textsPass, dynamicsPass, numLayoutPasses};
+
+// the vertical extents of the notes of a bar before a layout pass, so that the bar can be laid out again from that pass
+struct LayoutExtents
+{
+	std::vector<float> maxYPos;
+	std::vector<float> minYPos;
+	float maxY;
+	float minY;
+};
+
+// the natural signs a bar needs at a position of a loop, with the bars displayed before it that they were searched in
+struct NaturalSigns
+{
+	std::vector<int> prevBars;
+	std::vector<std::vector<int>> naturals;
+};
 
 class Notes
 {
@@ -99,7 +120,9 @@ class Notes
 		void setOrientation(int orientation);
 		void setOrientationForDots(int orientation);
 		void setAnimation(bool anim);
+		bool getAnimation();
 		void setActiveNote(int note);
+		int getActiveNote();
 		void setMute(bool muteState);
 		void setMeter(int bar, int numer, int denom, int numBeats);
 		void setAccidentalsOffsetCoef(float coef);
@@ -138,17 +161,29 @@ class Notes
 		void storeTextCoords(int bar);
 		void storeDynamicsCoords(int bar);
 		void storeMinMaxY(int bar);
+		void storeStringMetrics(int bar);
+		void invalidateLayout(int bar, int fromPass = positionsPass);
+		void invalidateLayout();
+		bool isLayoutDirty(int bar);
+		int getFirstDirtyPass(int bar);
+		void runLayoutPass(int bar, int pass, bool first);
+		void setLayoutClean(int bar);
 		void deleteBar(int bar);
-		void insertNaturalSigns(int bar, int loopNdx, std::vector<int> *v);
+		const std::vector<std::vector<int>>& getNaturalSigns(int bar, int loop, int loopNdx, std::vector<int> *v);
+		std::vector<std::vector<int>> findNaturalSigns(int bar, const std::vector<int>& prevBars);
+		void invalidateNaturalSigns(int bar);
+		void invalidateLoopNaturalSigns(int loop);
 		std::pair<int, int> isBarLinked(int bar);
+		std::pair<bool, bool> getSlurLinks(int bar);
+		bool hasBar(int bar);
 		void moveScoreX(int numPixels);
 		void moveScoreY(int numPixels);
 		void recenterScore();
-		void drawNotes(int bar, int loopNdx, std::vector<int> *v, float xStartPnt, float yStartPnt,
+		void drawNotes(int bar, int loop, int loopNdx, std::vector<int> *v, float xStartPnt, float yStartPnt,
 				float yOffset, bool animation, float xCoef);
 		void drawBeams(float x1, float y1, float x2, float y2);
 		int drawRest(int bar, int restDur, float x, float yStartPnt, ofColor color, float yOffset);
-		void drawAccidentals(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
+		void drawAccidentals(int bar, const std::vector<std::vector<int>> *naturals, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawGlissandi(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawTuplets(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawArticulations(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
@@ -159,6 +194,10 @@ class Notes
 		void drawTies(int thisBar, int loopNdx, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
 		void drawTie(int thisBar, unsigned i, unsigned j, float xStartPnt, float yStartPnt, float yOffset, float xCoef, int stemDirCoef);
 		void drawDynamics(int bar, float xStartPnt, float yStartPnt, float yOffset, float xCoef);
+		// the draws that don't go through the batch of the score are counted only while \score bench runs
+		void setCountDrawCalls(bool count);
+		unsigned getNumDrawCalls();
+		void resetNumDrawCalls();
 		void printVector(std::vector<int> v);
 		void printVector(std::vector<std::string> v);
 		void printVector(std::vector<float> v);
@@ -166,6 +205,9 @@ class Notes
 		ofColor notesColor;
 		ofColor activeNotesColor;
 	private:
+		void countDrawCalls(unsigned n);
+		bool countingDrawCalls;
+		unsigned numDrawCalls;
 		int objID;
 		bool rhythm;
 		std::vector<int> allBars;
@@ -179,6 +221,9 @@ class Notes
 		std::map<int, std::vector<int>> allChordsEdgeIndexes;
 		std::map<int, std::vector<std::vector<int>>> allAccidentals;
 		std::map<int, std::vector<std::vector<int>>> naturalSignsNotWritten;
+		// the natural signs each bar needs because of the accidentals of the bars displayed before it in a line of the score
+		// stored per loop and position in the loop, and searched again when the loop is stored or the notes of a bar change
+		std::map<int, std::map<std::pair<int, int>, NaturalSigns>> naturalSigns;
 		std::map<int, std::vector<std::vector<int>>> allOctaves;
 		std::map<int, std::vector<int>> allOttavas;
 		std::map<int, std::vector<int>> allGlissandi;
@@ -271,8 +316,8 @@ class Notes
 		int scoreOrientationForDots;
 		std::map<int, float> distBetweenBeats;
 		std::map<int, bool> tacet;
-		ofTrueTypeFont notationFont;
-		ofTrueTypeFont textFont;
+		std::shared_ptr<CachedFont> notationFont;
+		std::shared_ptr<CachedFont> textFont;
 		// whole note, half note (without stem), filled note, tail for upward stem, tail for downward stem
 		std::string notesSyms[5] = {"w", "ú", "ö", "j", "J"};
 		// double flat, dummy 1.5 flat, flat, dummy half flat, natural,
@@ -292,6 +337,17 @@ class Notes
 		float dynSymsHeights[8];
 		float restsSymsWidths[6];
 		float restsSymsHeights[6];
+		float articulSymsHeights[6];
+		float octaveSymsHeights[3];
+		float portandoHalfHeight;
+		// the widths of tuplet numbers and the half heights of the texts of each bar
+		// stored whenever the data or the font changes, so the layout can run on worker threads
+		std::map<int, float> tupletNumWidths;
+		std::map<int, std::vector<float>> textHalfHeights;
+		// the first layout pass each out of date bar runs again from, when it is about to be shown
+		std::map<int, int> layoutFirstPass;
+		// the extents before the passes a bar can be laid out again from, the slurs and the dynamics
+		std::map<int, std::map<int, LayoutExtents>> layoutExtents;
 		//ofImage quarterSharp;
 		float noteWidth;
 		float noteHeight;
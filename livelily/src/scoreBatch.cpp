@@ -0,0 +1,112 @@
+#include "scoreBatch.h"
+
+//--------------------------------------------------------------
+ScoreBatch::ScoreBatch()
+{
+	lines.setMode(OF_PRIMITIVE_LINES);
+	shapes.setMode(OF_PRIMITIVE_TRIANGLES);
+	// the meshes are refilled on every frame
+	lines.setUsage(GL_STREAM_DRAW);
+	shapes.setUsage(GL_STREAM_DRAW);
+	for (int i = 0; i <= BATCHCIRCLERESOLUTION; i++) {
+		float angle = TWO_PI * ((float)i / (float)BATCHCIRCLERESOLUTION);
+		circleCos[i] = cos(angle);
+		circleSin[i] = sin(angle);
+	}
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::clear()
+{
+	// clearing keeps the allocated memory of the meshes, so after the first frames nothing is allocated
+	lines.clear();
+	shapes.clear();
+	for (auto it = glyphs.begin(); it != glyphs.end(); ++it) {
+		it->second.clear();
+	}
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::addLine(float x1, float y1, float x2, float y2, const ofColor& color)
+{
+	lines.addVertex(ofPoint(x1, y1));
+	lines.addVertex(ofPoint(x2, y2));
+	lines.addColor(color);
+	lines.addColor(color);
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::addQuad(const ofPoint& a, const ofPoint& b, const ofPoint& c, const ofPoint& d, const ofColor& color)
+{
+	// the vertices are in the order of a triangle strip, like the beams were drawn before
+	shapes.addVertex(a);
+	shapes.addVertex(b);
+	shapes.addVertex(c);
+	shapes.addVertex(b);
+	shapes.addVertex(c);
+	shapes.addVertex(d);
+	for (int i = 0; i < 6; i++) {
+		shapes.addColor(color);
+	}
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::addRectangle(float x, float y, float w, float h, const ofColor& color)
+{
+	addQuad(ofPoint(x, y), ofPoint(x, y+h), ofPoint(x+w, y), ofPoint(x+w, y+h), color);
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::addCircle(float x, float y, float radius, const ofColor& color)
+{
+	for (int i = 0; i < BATCHCIRCLERESOLUTION; i++) {
+		shapes.addVertex(ofPoint(x, y));
+		shapes.addVertex(ofPoint(x + (circleCos[i] * radius), y + (circleSin[i] * radius)));
+		shapes.addVertex(ofPoint(x + (circleCos[i+1] * radius), y + (circleSin[i+1] * radius)));
+		shapes.addColor(color);
+		shapes.addColor(color);
+		shapes.addColor(color);
+	}
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::addString(const ofTrueTypeFont& font, const std::string& str, float x, float y, const ofColor& color)
+{
+	auto it = glyphs.find(&font);
+	if (it == glyphs.end()) {
+		it = glyphs.insert(std::make_pair(&font, ofVboMesh())).first;
+		it->second.setMode(OF_PRIMITIVE_TRIANGLES);
+		it->second.setUsage(GL_STREAM_DRAW);
+	}
+	size_t numVertices = it->second.getNumVertices();
+	// this is the mesh drawString() draws, append() offsets its indexes to the vertices already in the batch
+	it->second.append(font.getStringMesh(str, x, y, ofIsVFlipped()));
+	for (size_t i = numVertices; i < it->second.getNumVertices(); i++) {
+		it->second.addColor(color);
+	}
+}
+
+//--------------------------------------------------------------
+void ScoreBatch::draw()
+{
+	if (lines.getNumVertices() > 0) lines.draw();
+	if (shapes.getNumVertices() > 0) shapes.draw();
+	// the glyphs are drawn last, so the note heads are on top of the ledger lines and the stems
+	for (auto it = glyphs.begin(); it != glyphs.end(); ++it) {
+		// fonts that didn't draw anything in this frame might not exist any more
+		if (it->second.getNumVertices() == 0) continue;
+		it->first->getFontTexture().bind();
+		it->second.draw();
+		it->first->getFontTexture().unbind();
+	}
+}
+
+//--------------------------------------------------------------
+int ScoreBatch::getNumDrawCalls() const
+{
+	int numDrawCalls = (lines.getNumVertices() > 0 ? 1 : 0) + (shapes.getNumVertices() > 0 ? 1 : 0);
+	for (auto it = glyphs.begin(); it != glyphs.end(); ++it) {
+		if (it->second.getNumVertices() > 0) numDrawCalls++;
+	}
+	return numDrawCalls;
+}
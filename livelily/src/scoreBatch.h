@@ -0,0 +1,35 @@
+#ifndef SCORE_BATCH_H
+#define SCORE_BATCH_H
+
+#include "ofMain.h"
+#include <map>
+
+#define BATCHCIRCLERESOLUTION 20 // same as the default resolution of ofDrawCircle()
+
+// collects the lines, filled shapes, and font glyphs of the score while it is being drawn
+// and draws them all at the end, with one draw call for the lines, one for the shapes, and one per font for the glyphs
+// colors are stored per vertex, so the highlighted notes don't need a separate batch
+// all coordinates are absolute, so only things that are drawn without a transformation of their own can be batched
+class ScoreBatch
+{
+	public:
+		ScoreBatch();
+		void clear();
+		void addLine(float x1, float y1, float x2, float y2, const ofColor& color);
+		void addQuad(const ofPoint& a, const ofPoint& b, const ofPoint& c, const ofPoint& d, const ofColor& color);
+		void addRectangle(float x, float y, float w, float h, const ofColor& color);
+		void addCircle(float x, float y, float radius, const ofColor& color);
+		void addString(const ofTrueTypeFont& font, const std::string& str, float x, float y, const ofColor& color);
+		void draw();
+		int getNumDrawCalls() const;
+
+	private:
+		ofVboMesh lines;
+		ofVboMesh shapes;
+		// the glyphs of each font are textured quads on the texture atlas of that font
+		std::map<const ofTrueTypeFont*, ofVboMesh> glyphs;
+		float circleCos[BATCHCIRCLERESOLUTION+1];
+		float circleSin[BATCHCIRCLERESOLUTION+1];
+};
+
+#endif
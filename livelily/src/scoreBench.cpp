@@ -0,0 +1,290 @@
+#include "scoreBench.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static const char *benchScoreNames[benchNumScores] = {"runs", "tuplets", "chords", "slurs"};
+static const char *layoutPassNames[numLayoutPasses] = {"positions", "articulations", "tuplets", "slurs", "ottavas", "texts", "dynamics"};
+
+//--------------------------------------------------------------
+static float median(std::vector<float>& v)
+{
+	std::nth_element(v.begin(), v.begin() + (v.size() / 2), v.end());
+	return v.at(v.size() / 2);
+}
+
+//--------------------------------------------------------------
+void ScoreBench::setup(int fontSizeLocal, float staffLinesDistLocal, float staffLengthLocal, float notesLengthLocal)
+{
+	fontSize = fontSizeLocal;
+	staffLinesDist = staffLinesDistLocal;
+	staffLength = staffLengthLocal;
+	notesLength = notesLengthLocal;
+	// room for the bars side by side, and for the ledger lines above and below the staff
+	fbo.allocate((int)(staffLength * BENCHNUMBARS), (int)(staffLinesDist * 24), GL_RGBA);
+}
+
+//--------------------------------------------------------------
+void ScoreBench::fillBar(Instrument& inst, int score, int bar, int barNdx)
+{
+	// the data is encoded the way the parser stores it, see parseMelodicLine() of ofApp
+	std::vector<std::vector<int>> notes;
+	std::vector<std::vector<int>> accidentals;
+	std::vector<std::vector<int>> octaves;
+	std::vector<std::vector<int>> articul;
+	std::vector<int> durs;
+	std::vector<std::pair<int, int>> slurIndexes(1, std::make_pair(-1, -1));
+	std::map<int, std::pair<int, int>> tupletRatios;
+	std::map<int, std::pair<unsigned, unsigned>> tupletStartStop;
+	bool wholeBarSlurred = false;
+	switch (score) {
+		case benchRuns:
+			// 64ths going up and down two octaves from below middle C, with an accent on every beat
+			for (int i = 0; i < 64; i++) {
+				int step = i % 28;
+				if (step > 14) step = 28 - step;
+				notes.push_back(std::vector<int>(1, step % 7));
+				octaves.push_back(std::vector<int>(1, step / 7));
+				accidentals.push_back(std::vector<int>(1, -1));
+				articul.push_back(std::vector<int>(1, (i % 16 == 0 ? 5 : 0)));
+				durs.push_back(MINDUR / 64);
+			}
+			break;
+		case benchTuplets: {
+			// eighth triplets, sixteenth quintuplets and sextuplets, and 32nd septuplets, each one a beat long
+			// the parser doesn't nest tuplets, so they are adjacent
+			int ratios[4][3] = {{3, 2, 8}, {5, 4, 16}, {6, 4, 16}, {7, 8, 32}};
+			for (int i = 0; i < 4; i++) {
+				tupletStartStop[i] = std::make_pair((unsigned)durs.size(), (unsigned)durs.size() + ratios[i][0] - 1);
+				tupletRatios[i] = std::make_pair(ratios[i][0], ratios[i][1]);
+				for (int j = 0; j < ratios[i][0]; j++) {
+					notes.push_back(std::vector<int>(1, (int)durs.size() % 7));
+					octaves.push_back(std::vector<int>(1, 1));
+					accidentals.push_back(std::vector<int>(1, -1));
+					articul.push_back(std::vector<int>(1, 0));
+					durs.push_back(MINDUR / ratios[i][2]);
+				}
+			}
+			break;
+		}
+		case benchChords: {
+			// eighths of six note chords, with the accidentals of each note changing from chord to chord
+			int chordNotes[6] = {0, 2, 4, 6, 1, 3};
+			int chordOctaves[6] = {0, 0, 0, 0, 1, 1};
+			int accidentalCodes[5] = {6, 2, 8, 0, 4};
+			for (int i = 0; i < 8; i++) {
+				notes.push_back(std::vector<int>(chordNotes, chordNotes + 6));
+				octaves.push_back(std::vector<int>(chordOctaves, chordOctaves + 6));
+				accidentals.push_back(std::vector<int>());
+				for (int j = 0; j < 6; j++) {
+					accidentals.back().push_back(accidentalCodes[(i + j) % 5]);
+				}
+				articul.push_back(std::vector<int>(1, 0));
+				durs.push_back(MINDUR / 8);
+			}
+			break;
+		}
+		case benchSlurs:
+			// sixteenths leaping up and down, under a slur from the first note of the first bar to the last note of the last one
+			for (int i = 0; i < 16; i++) {
+				int step = (i * 5) % 14;
+				notes.push_back(std::vector<int>(1, step % 7));
+				octaves.push_back(std::vector<int>(1, step / 7));
+				accidentals.push_back(std::vector<int>(1, -1));
+				articul.push_back(std::vector<int>(1, 0));
+				durs.push_back(MINDUR / 16);
+			}
+			if (barNdx == 0) slurIndexes.at(0).first = 0;
+			else if (barNdx == BENCHNUMBARS - 1) slurIndexes.at(0).second = 15;
+			else wholeBarSlurred = true;
+			break;
+		default:
+			break;
+	}
+	size_t numNotes = notes.size();
+	inst.setMeter(bar, 4, 4, MINDUR);
+	inst.createEmptyMelody(bar);
+	inst.scoreNaturalSignsNotWritten[bar].clear();
+	for (auto it = notes.begin(); it != notes.end(); ++it) {
+		inst.scoreNaturalSignsNotWritten[bar].push_back(std::vector<int>(it->size(), 0));
+	}
+	inst.scoreNotes[bar] = std::move(notes);
+	inst.scoreAccidentals[bar] = std::move(accidentals);
+	inst.scoreOctaves[bar] = std::move(octaves);
+	inst.scoreOttavas[bar] = std::vector<int>(numNotes, 0);
+	inst.scoreDurs[bar] = std::move(durs);
+	inst.scoreDotIndexes[bar] = std::vector<int>(numNotes, 0);
+	inst.scoreDotsCounter[bar] = std::vector<unsigned>(numNotes, 0);
+	inst.scoreGlissandi[bar] = std::vector<int>(numNotes, 0);
+	inst.articulations[bar] = std::move(articul);
+	inst.scoreDynamics[bar] = std::vector<int>(numNotes, -1);
+	inst.scoreDynamicsIndexes[bar] = std::vector<int>(numNotes, -1);
+	inst.scoreDynamicsRampStart[bar] = std::vector<int>(numNotes, -1);
+	inst.scoreDynamicsRampEnd[bar] = std::vector<int>(numNotes, -1);
+	inst.scoreDynamicsRampDir[bar] = std::vector<int>(numNotes, -1);
+	inst.slurIndexes[bar] = std::move(slurIndexes);
+	inst.tieIndexes[bar] = std::vector<int>(numNotes, -1);
+	inst.isWholeBarSlurred[bar] = wholeBarSlurred;
+	inst.scoreTupletRatios[bar] = std::move(tupletRatios);
+	inst.scoreTupletStartStop[bar] = std::move(tupletStartStop);
+	inst.scoreTexts[bar] = std::vector<std::string>();
+	inst.textIndexes[bar] = std::vector<std::vector<int>>(numNotes, std::vector<int>(1, 0));
+	inst.setScoreNotes(bar, 4, 4, MINDUR, 120, 4, false, 1);
+}
+
+//--------------------------------------------------------------
+void ScoreBench::runScore(int score, ScoreBatch& batch)
+{
+	// bar 0 is the default empty bar of the score, so the synthetic bars start at 1
+	std::vector<int> bars;
+	for (int i = 1; i <= BENCHNUMBARS; i++) {
+		bars.push_back(i);
+	}
+	std::vector<float> passDurs[numLayoutPasses];
+	std::vector<float> drawDurs;
+	std::vector<float> numDrawCalls;
+	for (int run = 0; run < BENCHNUMRUNS; run++) {
+		// the notes of a bar can only be set once, so every run starts with a new instrument
+		Instrument inst;
+		inst.setNotesFontSize(fontSize, staffLinesDist);
+		inst.setStaffCoords(staffLength, staffLinesDist);
+		inst.setNoteCoords(notesLength, staffLinesDist, fontSize);
+		for (unsigned i = 0; i < bars.size(); i++) {
+			fillBar(inst, score, bars.at(i), (int)i);
+		}
+		uint64_t durs[numLayoutPasses];
+		inst.timeLayoutPasses(bars, durs);
+		for (int i = 0; i < numLayoutPasses; i++) {
+			passDurs[i].push_back((float)durs[i] / BENCHNUMBARS);
+		}
+		// the drawing is timed until the GPU is done, so that it includes what the draw calls cost and not only their submission
+		fbo.begin();
+		ofClear(255, 255, 255, 255);
+		batch.clear();
+		inst.resetNumDrawCalls();
+		inst.setCountDrawCalls(true);
+		uint64_t start = ofGetElapsedTimeMicros();
+		for (unsigned i = 0; i < bars.size(); i++) {
+			inst.drawNotes(bars.at(i), 0, (int)i, &bars, staffLength * i, staffLinesDist * 10, 0, false, 1);
+		}
+		inst.setCountDrawCalls(false);
+		numDrawCalls.push_back((float)(inst.getNumDrawCalls() + batch.getNumDrawCalls()) / BENCHNUMBARS);
+		batch.draw();
+		glFinish();
+		drawDurs.push_back((float)(ofGetElapsedTimeMicros() - start) / BENCHNUMBARS);
+		fbo.end();
+		batch.clear();
+	}
+	for (int i = 0; i < numLayoutPasses; i++) {
+		results[score].passDurs[i] = median(passDurs[i]);
+	}
+	results[score].drawDur = median(drawDurs);
+	results[score].numDrawCalls = median(numDrawCalls);
+}
+
+//--------------------------------------------------------------
+void ScoreBench::run(ScoreBatch& batch)
+{
+	for (int i = 0; i < benchNumScores; i++) {
+		runScore(i, batch);
+	}
+}
+
+//--------------------------------------------------------------
+std::string ScoreBench::getResultsStr()
+{
+	// one line per synthetic score, with the time of each pass and of the drawing per bar
+	std::string str = "";
+	for (int i = 0; i < benchNumScores; i++) {
+		if (i > 0) str += "\n";
+		str += std::string(benchScoreNames[i]) + ":";
+		for (int j = 0; j < numLayoutPasses; j++) {
+			str += " " + std::string(layoutPassNames[j]) + " " + ofToString(results[i].passDurs[j], 1) + "us,";
+		}
+		str += " draw " + ofToString(results[i].drawDur, 1) + "us, " + ofToString(results[i].numDrawCalls, 1) + " draw calls";
+	}
+	return str;
+}
+
+//--------------------------------------------------------------
+bool ScoreBench::save(std::string fileName)
+{
+	std::ofstream file(fileName.c_str(), std::ios::trunc);
+	if (!file.is_open()) return false;
+	file << "score";
+	for (int i = 0; i < numLayoutPasses; i++) {
+		file << "," << layoutPassNames[i];
+	}
+	file << ",draw,drawcalls" << endl;
+	for (int i = 0; i < benchNumScores; i++) {
+		file << benchScoreNames[i];
+		for (int j = 0; j < numLayoutPasses; j++) {
+			file << "," << results[i].passDurs[j];
+		}
+		file << "," << results[i].drawDur << "," << results[i].numDrawCalls << endl;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+bool ScoreBench::load(std::string fileName, BenchResult *baseline)
+{
+	std::ifstream file(fileName.c_str());
+	if (!file.is_open()) return false;
+	bool found[benchNumScores] = {false};
+	std::string line;
+	while (std::getline(file, line)) {
+		std::vector<std::string> fields;
+		std::stringstream ss(line);
+		std::string field;
+		while (std::getline(ss, field, ',')) {
+			fields.push_back(field);
+		}
+		// the header and rows of scores this version doesn't have are skipped
+		if (fields.size() != numLayoutPasses + 3) continue;
+		for (int i = 0; i < benchNumScores; i++) {
+			if (fields.at(0).compare(benchScoreNames[i]) != 0) continue;
+			for (int j = 0; j < numLayoutPasses; j++) {
+				baseline[i].passDurs[j] = (float)atof(fields.at(j+1).c_str());
+			}
+			baseline[i].drawDur = (float)atof(fields.at(numLayoutPasses+1).c_str());
+			baseline[i].numDrawCalls = (float)atof(fields.at(numLayoutPasses+2).c_str());
+			found[i] = true;
+		}
+	}
+	for (int i = 0; i < benchNumScores; i++) {
+		if (!found[i]) return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------
+bool ScoreBench::compare(std::string fileName, std::string& regressions)
+{
+	BenchResult baseline[benchNumScores];
+	if (!load(fileName, baseline)) return false;
+	regressions = "";
+	auto isSlower = [](float dur, float baseDur) {
+		return dur > baseDur * BENCHREGRESSIONCOEF && dur - baseDur > BENCHNOISEFLOOR;
+	};
+	for (int i = 0; i < benchNumScores; i++) {
+		std::string name = benchScoreNames[i];
+		for (int j = 0; j < numLayoutPasses; j++) {
+			if (isSlower(results[i].passDurs[j], baseline[i].passDurs[j])) {
+				if (regressions.size() > 0) regressions += "\n";
+				regressions += name + " " + layoutPassNames[j] + ": " + ofToString(results[i].passDurs[j], 1) +
+					"us, was " + ofToString(baseline[i].passDurs[j], 1) + "us";
+			}
+		}
+		if (isSlower(results[i].drawDur, baseline[i].drawDur)) {
+			if (regressions.size() > 0) regressions += "\n";
+			regressions += name + " draw: " + ofToString(results[i].drawDur, 1) + "us, was " + ofToString(baseline[i].drawDur, 1) + "us";
+		}
+		// the draw calls don't depend on the timing, so any increase is a regression
+		if (results[i].numDrawCalls > baseline[i].numDrawCalls) {
+			if (regressions.size() > 0) regressions += "\n";
+			regressions += name + " draw calls: " + ofToString(results[i].numDrawCalls, 1) + ", was " + ofToString(baseline[i].numDrawCalls, 1);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,55 @@
+#ifndef SCORE_BENCH_H
+#define SCORE_BENCH_H
+
+#include "ofMain.h"
+#include "instrument.h"
+#include "scoreBatch.h"
+#include <string>
+
+#define BENCHNUMBARS 4 // bars of each synthetic score, laid out and drawn together like a line of the score
+#define BENCHNUMRUNS 20 // the median of the runs is reported, so that a single slow run doesn't count
+#define BENCHREGRESSIONCOEF 1.2 // a time that grows by more than 20% from the baseline is a regression
+#define BENCHNOISEFLOOR 2 // microseconds per bar, smaller differences from the baseline are not regressions
+#define BENCHBASELINEFILE "scorebench.csv" // in the data folder
+
+// the synthetic scores, each stressing a different part of the layout
+// runs are long beamed groups, tuplets are adjacent tuplets of different ratios
+// chords are dense chords with mixed accidentals, and slurs is a slur that spans all the bars
+enum benchScores {benchRuns, benchTuplets, benchChords, benchSlurs, benchNumScores};
+
+// the medians of the runs of a synthetic score, in microseconds per bar and draw calls per bar
+struct BenchResult
+{
+	float passDurs[numLayoutPasses];
+	float drawDur;
+	float numDrawCalls;
+};
+
+// lays out and draws the synthetic scores offscreen, timing each layout pass and the drawing separately
+// the scores are generated here, so the results don't depend on what is written in the editor
+// the fonts are loaded and the notes are drawn to an FBO, so run() must be called from the thread that draws
+class ScoreBench
+{
+	public:
+		void setup(int fontSize, float staffLinesDist, float staffLength, float notesLength);
+		void run(ScoreBatch& batch);
+		std::string getResultsStr();
+		bool save(std::string fileName);
+		// returns false if there is no baseline to compare to
+		// otherwise the times that are slower than the baseline are written to regressions, one per line
+		bool compare(std::string fileName, std::string& regressions);
+
+	private:
+		void fillBar(Instrument& inst, int score, int bar, int barNdx);
+		void runScore(int score, ScoreBatch& batch);
+		bool load(std::string fileName, BenchResult *baseline);
+
+		BenchResult results[benchNumScores];
+		int fontSize;
+		float staffLinesDist;
+		float staffLength;
+		float notesLength;
+		ofFbo fbo;
+};
+
+#endif
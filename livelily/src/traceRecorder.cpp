@@ -0,0 +1,344 @@
+#include "traceRecorder.h"
+#include <cstring>
+#include <thread>
+
+static_assert(sizeof(TraceRecord) == TRACERECORDSIZE, "trace records must be of fixed size");
+static_assert(offsetof(TraceRecord, data) == TRACEHEADERSIZE, "the trace record header must precede the payload");
+
+/********************* trace recorder class *******************/
+//--------------------------------------------------------------
+TraceRecorder::TraceRecorder()
+{
+	recording = false;
+	numDropped = 0;
+	startTimeStamp = 0;
+	blocking = false;
+}
+
+//--------------------------------------------------------------
+bool TraceRecorder::start(std::string fileName, uint64_t startTime, bool block)
+{
+	if (recording) stop();
+	file.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) return false;
+	// the file header is the magic string, the version, and the size of a record header
+	char magic[8] = {0};
+	strncpy(magic, TRACEMAGIC, 7);
+	uint32_t version = TRACEVERSION;
+	uint32_t headerSize = TRACEHEADERSIZE;
+	file.write(magic, 8);
+	file.write((const char*)&version, sizeof(version));
+	file.write((const char*)&headerSize, sizeof(headerSize));
+	numDropped = 0;
+	startTimeStamp = startTime;
+	blocking = block;
+	recording = true;
+	startThread();
+	return true;
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::stop()
+{
+	if (!recording) return;
+	recording = false;
+	stopThread();
+	waitForThread(false);
+	flush();
+	file.close();
+}
+
+//--------------------------------------------------------------
+bool TraceRecorder::isRecording()
+{
+	return recording;
+}
+
+//--------------------------------------------------------------
+uint64_t TraceRecorder::getNumDropped()
+{
+	return numDropped;
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::push(uint64_t timeStamp, TraceRecord& record)
+{
+	record.timeStamp = timeStamp - startTimeStamp;
+	while (!queue.push(record)) {
+		if (!blocking || !recording) {
+			numDropped++;
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::recordOsc(uint64_t timeStamp, const ofxOscMessage& m)
+{
+	TraceRecord record;
+	record.type = traceOsc;
+	record.flags = 0;
+	record.port = 0;
+	std::string address = m.getAddress();
+	size_t addressLen = std::min(address.size(), (size_t)TRACEPAYLOADSIZE - 1);
+	memcpy(record.data, address.c_str(), addressLen);
+	record.data[addressLen] = 0;
+	uint32_t pos = (uint32_t)addressLen + 1;
+	for (size_t i = 0; i < m.getNumArgs(); i++) {
+		char tag;
+		uint8_t value[8];
+		size_t valueLen = 0;
+		std::string str;
+		switch (m.getArgType(i)) {
+			case OFXOSC_TYPE_INT32: {
+				tag = 'i';
+				int32_t v = m.getArgAsInt32(i);
+				memcpy(value, &v, 4);
+				valueLen = 4;
+				break;
+			}
+			case OFXOSC_TYPE_INT64: {
+				tag = 'h';
+				int64_t v = m.getArgAsInt64(i);
+				memcpy(value, &v, 8);
+				valueLen = 8;
+				break;
+			}
+			case OFXOSC_TYPE_FLOAT: {
+				tag = 'f';
+				float v = m.getArgAsFloat(i);
+				memcpy(value, &v, 4);
+				valueLen = 4;
+				break;
+			}
+			case OFXOSC_TYPE_STRING:
+			case OFXOSC_TYPE_SYMBOL:
+				tag = 's';
+				str = m.getArgAsString(i);
+				valueLen = str.size() + 1;
+				break;
+			case OFXOSC_TYPE_TRUE:
+				tag = 'T';
+				break;
+			case OFXOSC_TYPE_FALSE:
+				tag = 'F';
+				break;
+			default:
+				// other types are not sent by the sequencer
+				record.flags |= TRACETRUNCATED;
+				continue;
+		}
+		if (pos + 1 + valueLen > TRACEPAYLOADSIZE) {
+			record.flags |= TRACETRUNCATED;
+			break;
+		}
+		record.data[pos++] = (uint8_t)tag;
+		if (tag == 's') memcpy(record.data + pos, str.c_str(), valueLen);
+		else if (valueLen > 0) memcpy(record.data + pos, value, valueLen);
+		pos += (uint32_t)valueLen;
+	}
+	record.len = pos;
+	push(timeStamp, record);
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::recordMidi(uint64_t timeStamp, int port, unsigned char status, unsigned char data1, unsigned char data2, int numBytes)
+{
+	TraceRecord record;
+	record.type = traceMidi;
+	record.flags = 0;
+	record.port = (int16_t)port;
+	record.data[0] = status;
+	record.data[1] = data1;
+	record.data[2] = data2;
+	record.len = (uint32_t)std::min(std::max(numBytes, 1), 3);
+	push(timeStamp, record);
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::recordPyo(uint64_t timeStamp, int binding, const float *values, int len, uint64_t scheduledTimeStamp)
+{
+	// the time the update is scheduled for is stored relative to the start of the recording, -1 for immediately
+	TraceRecord record;
+	record.type = tracePyo;
+	record.flags = 0;
+	record.port = (int16_t)binding;
+	int64_t scheduled = (scheduledTimeStamp == 0 ? -1 : (int64_t)scheduledTimeStamp - (int64_t)startTimeStamp);
+	memcpy(record.data, &scheduled, 8);
+	int numValues = std::min(len, (int)((TRACEPAYLOADSIZE - 8) / sizeof(float)));
+	memcpy(record.data + 8, values, numValues * sizeof(float));
+	record.len = 8 + (uint32_t)(numValues * sizeof(float));
+	push(timeStamp, record);
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::recordFunction(uint64_t timeStamp, const std::string& name)
+{
+	TraceRecord record;
+	record.type = traceFunction;
+	record.flags = 0;
+	record.port = 0;
+	size_t nameLen = std::min(name.size(), (size_t)TRACEPAYLOADSIZE - 1);
+	memcpy(record.data, name.c_str(), nameLen);
+	record.data[nameLen] = 0;
+	record.len = (uint32_t)nameLen + 1;
+	push(timeStamp, record);
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::flush()
+{
+	TraceRecord record;
+	while (queue.pop(record)) {
+		file.write((const char*)&record, TRACEHEADERSIZE + record.len);
+	}
+}
+
+//--------------------------------------------------------------
+void TraceRecorder::threadedFunction()
+{
+	while (isThreadRunning()) {
+		flush();
+		sleep(10);
+	}
+}
+
+/********************** trace player class ********************/
+//--------------------------------------------------------------
+void TracePlayer::setup(std::string host, int port, ofxMidiOut *defaultMidiOut, std::vector<ofxMidiOut> *midiOutputs)
+{
+	oscSender.setup(host, port);
+	midiOut = defaultMidiOut;
+	midiOuts = midiOutputs;
+}
+
+#ifdef USEPYO
+//--------------------------------------------------------------
+void TracePlayer::setPyo(Pyo *pyoPtr)
+{
+	pyo = pyoPtr;
+}
+#endif
+
+//--------------------------------------------------------------
+bool TracePlayer::play(std::string fileName)
+{
+	stop();
+	file.open(fileName.c_str(), std::ios::binary);
+	if (!file.is_open()) return false;
+	char magic[8];
+	uint32_t version = 0;
+	uint32_t headerSize = 0;
+	file.read(magic, 8);
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&headerSize, sizeof(headerSize));
+	if (!file || strncmp(magic, TRACEMAGIC, 7) != 0 || version != TRACEVERSION || headerSize != TRACEHEADERSIZE) {
+		file.close();
+		return false;
+	}
+	startThread();
+	return true;
+}
+
+//--------------------------------------------------------------
+void TracePlayer::stop()
+{
+	if (isThreadRunning()) {
+		stopThread();
+		waitForThread(false);
+	}
+	if (file.is_open()) file.close();
+}
+
+//--------------------------------------------------------------
+void TracePlayer::emit(const TraceRecord& record, uint64_t startTimeStamp)
+{
+	switch (record.type) {
+		case traceOsc: {
+			ofxOscMessage m;
+			m.setAddress(std::string((const char*)record.data));
+			size_t pos = strlen((const char*)record.data) + 1;
+			while (pos < record.len) {
+				char tag = (char)record.data[pos++];
+				if (tag == 'i') {
+					int32_t v;
+					memcpy(&v, record.data + pos, 4);
+					m.addIntArg(v);
+					pos += 4;
+				}
+				else if (tag == 'h') {
+					int64_t v;
+					memcpy(&v, record.data + pos, 8);
+					m.addInt64Arg(v);
+					pos += 8;
+				}
+				else if (tag == 'f') {
+					float v;
+					memcpy(&v, record.data + pos, 4);
+					m.addFloatArg(v);
+					pos += 4;
+				}
+				else if (tag == 's') {
+					std::string str((const char*)record.data + pos);
+					m.addStringArg(str);
+					pos += str.size() + 1;
+				}
+				else if (tag == 'T' || tag == 'F') {
+					m.addBoolArg(tag == 'T');
+				}
+				else {
+					break;
+				}
+			}
+			oscSender.sendMessage(m, false);
+			break;
+		}
+		case traceMidi: {
+			std::vector<unsigned char> bytes(record.data, record.data + record.len);
+			if (record.port < 0) {
+				midiOut->sendMidiBytes(bytes);
+			}
+			else if (record.port < (int)midiOuts->size()) {
+				(*midiOuts)[record.port].sendMidiBytes(bytes);
+			}
+			break;
+		}
+		case tracePyo: {
+#ifdef USEPYO
+			if (pyo == nullptr) break;
+			int64_t scheduled;
+			memcpy(&scheduled, record.data, 8);
+			float values[PYOMAXVALUES];
+			int len = std::min((int)((record.len - 8) / sizeof(float)), PYOMAXVALUES);
+			memcpy(values, record.data + 8, len * sizeof(float));
+			pyo->pushParam(record.port, values, len, (scheduled < 0 ? 0 : startTimeStamp + (uint64_t)scheduled));
+#endif
+			break;
+		}
+		default:
+			// bound functions are in the trace for reference only, as calling them would change the session
+			break;
+	}
+}
+
+//--------------------------------------------------------------
+void TracePlayer::threadedFunction()
+{
+	uint64_t startTimeStamp = ofGetElapsedTimeMicros();
+	TraceRecord record;
+	while (isThreadRunning()) {
+		if (!file.read((char*)&record, TRACEHEADERSIZE)) break;
+		if (record.len > TRACEPAYLOADSIZE || !file.read((char*)record.data, record.len)) break;
+		// wait until the time of the record, sleeping for the long waits and spinning for the last bit
+		while (isThreadRunning()) {
+			uint64_t elapsed = ofGetElapsedTimeMicros() - startTimeStamp;
+			if (elapsed >= record.timeStamp) break;
+			uint64_t remaining = record.timeStamp - elapsed;
+			if (remaining > 2000) sleep((int)((remaining - 1000) / 1000));
+			else yield();
+		}
+		emit(record, startTimeStamp);
+	}
+	file.close();
+}
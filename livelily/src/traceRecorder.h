@@ -0,0 +1,96 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "ofxMidi.h"
+#include <atomic>
+#include <fstream>
+#include <cstddef>
+#include "ringBuffer.h"
+#ifdef USEPYO
+#include "PyoClass.h"
+#endif
+
+#define TRACEMAGIC "LLTRACE"
+#define TRACEVERSION 1
+#define TRACERECORDSIZE 128
+#define TRACEHEADERSIZE 16
+#define TRACEPAYLOADSIZE (TRACERECORDSIZE - TRACEHEADERSIZE)
+#define TRACEQUEUESIZE 8192 // records the sequencer can queue before the writing thread flushes them
+#define TRACETRUNCATED 1 // flag for OSC messages whose arguments didn't fit in the payload
+
+enum traceRecordTypes {traceOsc, traceMidi, tracePyo, traceFunction};
+
+// a fixed-size record of something the sequencer sent
+// only the header and the used part of the payload are written to the file
+// OSC messages are stored as the NUL-terminated address followed by a type tag and the value of each argument
+// MIDI messages as their raw bytes, Pyo updates as the scheduled time followed by the values
+// and bound functions as their NUL-terminated name
+struct TraceRecord
+{
+	uint64_t timeStamp; // in microseconds since the recording started
+	uint8_t type;
+	uint8_t flags;
+	int16_t port; // index of the MIDI output (-1 for the default one), or the Pyo binding
+	uint32_t len; // number of bytes used in data
+	uint8_t data[TRACEPAYLOADSIZE];
+};
+
+// records everything the sequencer sends to a binary trace file
+// the sequencer thread is the only one that calls the record functions, which push to a lock-free queue
+// and the thread of this class writes the queued records to the file, so the sequencer never waits for the disk
+class TraceRecorder : public ofThread
+{
+	public:
+		TraceRecorder();
+		// startTimeStamp is the time of the first record on the clock the caller passes to the record functions
+		// a blocking recorder waits for room in the queue instead of dropping records, for offline rendering
+		bool start(std::string fileName, uint64_t startTimeStamp, bool blocking);
+		void stop();
+		bool isRecording();
+		uint64_t getNumDropped();
+		void recordOsc(uint64_t timeStamp, const ofxOscMessage& m);
+		void recordMidi(uint64_t timeStamp, int port, unsigned char status, unsigned char data1, unsigned char data2, int numBytes);
+		void recordPyo(uint64_t timeStamp, int binding, const float *values, int len, uint64_t scheduledTimeStamp);
+		void recordFunction(uint64_t timeStamp, const std::string& name);
+
+	private:
+		void threadedFunction();
+		void push(uint64_t timeStamp, TraceRecord& record);
+		void flush();
+
+		RingBuffer<TraceRecord, TRACEQUEUESIZE> queue;
+		std::ofstream file;
+		std::atomic<bool> recording;
+		std::atomic<uint64_t> numDropped;
+		uint64_t startTimeStamp;
+		bool blocking;
+};
+
+// re-emits a trace file to the OSC and MIDI outputs with the original timing
+// Pyo updates are queued with their original offsets, so the sequencer must not be running while replaying
+class TracePlayer : public ofThread
+{
+	public:
+		void setup(std::string host, int port, ofxMidiOut *defaultMidiOut, std::vector<ofxMidiOut> *midiOutputs);
+#ifdef USEPYO
+		void setPyo(Pyo *pyoPtr);
+#endif
+		bool play(std::string fileName);
+		void stop();
+
+	private:
+		void threadedFunction();
+		void emit(const TraceRecord& record, uint64_t startTimeStamp);
+
+		std::ifstream file;
+		ofxOscSender oscSender;
+		ofxMidiOut *midiOut;
+		std::vector<ofxMidiOut> *midiOuts;
+#ifdef USEPYO
+		Pyo *pyo = nullptr;
+#endif
+};
+
+#endif